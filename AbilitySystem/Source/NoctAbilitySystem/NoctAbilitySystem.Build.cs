@@ -41,7 +41,10 @@ public class NoctAbilitySystem : ModuleRules
 				"Slate",
 				"SlateCore",
 				"GameplayTags",
-				"EnhancedInput"
+				"EnhancedInput",
+				"DeveloperSettings",
+				"TraceLog",
+				"NetCore"
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -3,15 +3,103 @@
 
 #include "NoctAbility.h"
 
-#include "EnhancedInputComponent.h"
 #include "NoctAbilityComponent.h"
+#include "NoctAttribute.h"
+#include "NoctAbilitySystem.h"
+#include "NoctAbilityRecorder.h"
 #include "GameFramework/Character.h"
+#include "UObject/ObjectSaveContext.h"
 
 UNoctAbility::UNoctAbility()
 {
 	OwningAbilityComponent = Cast<UNoctAbilityComponent>(GetOuter());
 }
 
+void UNoctAbility::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	// Instances normally inherit the tables from their archetype, this only bakes when those are missing or stale.
+	// Loaded objects don't have their properties yet, they are baked in PostLoad instead.
+	if (!HasAnyFlags(RF_NeedLoad) && !AreScalingTablesBaked())
+	{
+		BakeScalingTables();
+	}
+}
+
+void UNoctAbility::PostLoad()
+{
+	Super::PostLoad();
+
+	// The editor always re-bakes, the curve assets may have been edited since the tables were saved
+	if (GIsEditor || !AreScalingTablesBaked())
+	{
+		BakeScalingTables();
+	}
+}
+
+void UNoctAbility::PreSave(const FObjectPreSaveContext SaveContext)
+{
+	// Baked on save so cooked class defaults ship with their tables
+	BakeScalingTables();
+
+	Super::PreSave(SaveContext);
+}
+
+#if WITH_EDITOR
+void UNoctAbility::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	BakeScalingTables();
+
+	BlockingTags.SyncFromEditorTags();
+	CancelTags.SyncFromEditorTags();
+}
+#endif
+
+void UNoctAbility::BakeScalingTables()
+{
+	CostScalingTable.Bake(CostScalingCurve, MaxLevel);
+	CooldownScalingTable.Bake(CooldownScalingCurve, MaxLevel);
+}
+
+bool UNoctAbility::AreScalingTablesBaked() const
+{
+	return CostScalingTable.IsBakedFrom(CostScalingCurve, MaxLevel)
+		&& CooldownScalingTable.IsBakedFrom(CooldownScalingCurve, MaxLevel);
+}
+
+void UNoctAbility::LoadState(const FNoctAbilityState& State)
+{
+	bIsActive = State.bIsActive;
+	Level = State.Level;
+	CurrentInputValue = State.CurrentInputValue;
+	CommittedCosts = State.CommittedCosts;
+}
+
+void UNoctAbility::StoreState(FNoctAbilityState& State) const
+{
+	State.bIsActive = bIsActive;
+	State.Level = Level;
+	State.CurrentInputValue = CurrentInputValue;
+	State.CommittedCosts = CommittedCosts;
+}
+
+void UNoctAbility::ResetForReuse()
+{
+	const UNoctAbility* DefaultAbility = GetClass()->GetDefaultObject<UNoctAbility>();
+	for (TFieldIterator<FProperty> It(GetClass()); It; ++It)
+	{
+		if (!It->HasAnyPropertyFlags(CPF_Transient))
+		{
+			It->CopyCompleteValue_InContainer(this, DefaultAbility);
+		}
+	}
+
+	OwningAbilityComponent = Cast<UNoctAbilityComponent>(GetOuter());
+}
+
 // Native Functions
 void UNoctAbility::AbilityAddedToOwner()
 {
@@ -20,24 +108,8 @@ void UNoctAbility::AbilityAddedToOwner()
 		ActivateAbility();
 	}
 	
-	if (ActivationAction)
-	{
-		if (const auto OwnerPawn = Cast<APawn>(OwningAbilityComponent->GetOwner()))
-		{
-			if (const auto InputComponent = OwnerPawn->FindComponentByClass<UEnhancedInputComponent>())
-			{
-				InputComponent->BindAction(ActivationAction, ETriggerEvent::Started, this, &UNoctAbility::InputActionStarted);
-
-				if (bAllowInputTriggered)
-				{
-					InputComponent->BindAction(ActivationAction, ETriggerEvent::Triggered, this, &UNoctAbility::InputActionTriggered);
-				}
-				
-				InputComponent->BindAction(ActivationAction, ETriggerEvent::Completed, this, &UNoctAbility::InputActionCompleted);
-				InputComponent->BindAction(ActivationAction,  ETriggerEvent::Canceled, this, &UNoctAbility::InputActionCancelled);
-			}
-		}
-	}
+	// The component binds each action once and routes its events to the abilities using it
+	OwningAbilityComponent->RegisterAbilityInput(ActivationAction, AbilityTag, bAllowInputTriggered);
 
 	AbilityAdded();
 	OnAbilityAdded();
@@ -45,16 +117,7 @@ void UNoctAbility::AbilityAddedToOwner()
 
 void UNoctAbility::AbilityRemovedFromOwner()
 {
-	if (ActivationAction)
-	{
-		if (const auto OwnerPawn = Cast<APawn>(OwningAbilityComponent->GetOwner()))
-		{
-			if (const auto InputComponent = OwnerPawn->FindComponentByClass<UEnhancedInputComponent>())
-			{
-				InputComponent->ClearBindingsForObject(this);
-			}
-		}
-	}
+	OwningAbilityComponent->UnregisterAbilityInput(AbilityTag);
 	
 	AbilityRemoved();
 	OnAbilityRemoved();
@@ -62,13 +125,34 @@ void UNoctAbility::AbilityRemovedFromOwner()
 
 void UNoctAbility::ActivateAbility()
 {
-	if(!CanActivateAbility())
+	ActivateAbilityInternal(true);
+}
+
+void UNoctAbility::ActivateAbilityWithoutCancel()
+{
+	ActivateAbilityInternal(false);
+}
+
+void UNoctAbility::ActivateAbilityInternal(const bool bCancelAbilities)
+{
+	if(!IsBoundToComponent() || !CanActivateAbility())
 	{
 		return;
 	}
 
-	OwningAbilityComponent->CancelAbilities(CancelTags);
-	OwningAbilityComponent->ActiveAbilityTags.AddTag(AbilityTag);
+	if(bCommitCostNatively && !CommitCost())
+	{
+		return;
+	}
+
+	NOCT_RECORD(RecordAbility(ENoctRecordedEventType::AbilityActivated, OwningAbilityComponent, AbilityTag));
+	NOCT_RECORD_NESTED_SCOPE();
+
+	if(bCancelAbilities && MayCancelActiveAbilities())
+	{
+		OwningAbilityComponent->CancelAbilities(CancelTags.Get());
+	}
+	OwningAbilityComponent->AddActiveAbilityTag(AbilityTag);
 	bIsActive = true;
 
 	AbilityActivated();
@@ -82,8 +166,20 @@ void UNoctAbility::ActivateAbility()
 
 void UNoctAbility::FinishAbility()
 {
-	OwningAbilityComponent->ActiveAbilityTags.RemoveTag(AbilityTag);
+	// Finishing an ability that isn't active, such as on a release before a buffered activation, mustn't start its cooldown
+	if(!IsBoundToComponent() || !bIsActive)
+	{
+		return;
+	}
+
+	NOCT_RECORD(RecordAbility(ENoctRecordedEventType::AbilityFinished, OwningAbilityComponent, AbilityTag));
+	NOCT_RECORD_NESTED_SCOPE();
+
+	OwningAbilityComponent->NotifyAbilityEnded(this, false);
+	OwningAbilityComponent->RemoveActiveAbilityTag(AbilityTag);
+	OwningAbilityComponent->CancelAbilityTasks(AbilityTag);
 	bIsActive = false;
+	CommittedCosts.Reset();
 	TriggerCooldown();
 
 	AbilityFinished();
@@ -92,9 +188,28 @@ void UNoctAbility::FinishAbility()
 
 void UNoctAbility::CancelAbility()
 {
-	OwningAbilityComponent->ActiveAbilityTags.RemoveTag(AbilityTag);
+	if(!IsBoundToComponent())
+	{
+		return;
+	}
+
+	NOCT_RECORD(RecordAbility(ENoctRecordedEventType::AbilityCancelled, OwningAbilityComponent, AbilityTag));
+	NOCT_RECORD_NESTED_SCOPE();
+
+	if(bIsActive)
+	{
+		OwningAbilityComponent->NotifyAbilityEnded(this, true);
+	}
+	OwningAbilityComponent->RemoveActiveAbilityTag(AbilityTag);
+	OwningAbilityComponent->CancelAbilityTasks(AbilityTag);
 	bIsActive = false;
 
+	if(bCommitCostNatively && bRefundCostOnCancel)
+	{
+		RefundCost();
+	}
+	CommittedCosts.Reset();
+
 	if(bCooldownOnCancel)
 	{
 		TriggerCooldown();
@@ -104,6 +219,72 @@ void UNoctAbility::CancelAbility()
 	OnAbilityCancelled();
 }
 
+FNoctAbilityTaskHandle UNoctAbility::WaitDelay(const float Duration)
+{
+	FNoctAbilityTask Task;
+	Task.Type = ENoctAbilityTaskType::WaitDelay;
+	Task.Duration = FMath::Max(Duration, 0.0f);
+	return StartTask(Task);
+}
+
+FNoctAbilityTaskHandle UNoctAbility::WaitInputReleased()
+{
+	FNoctAbilityTask Task;
+	Task.Type = ENoctAbilityTaskType::WaitInputReleased;
+	return StartTask(Task);
+}
+
+FNoctAbilityTaskHandle UNoctAbility::WaitAttributeChange(const FGameplayTag AttributeTag, const ENoctAttributeThreshold Threshold, const float ThresholdValue)
+{
+	FNoctAbilityTask Task;
+	Task.Type = ENoctAbilityTaskType::WaitAttributeChange;
+	Task.Tag = AttributeTag;
+	Task.Threshold = Threshold;
+	Task.ThresholdValue = ThresholdValue;
+	return StartTask(Task);
+}
+
+FNoctAbilityTaskHandle UNoctAbility::WaitEffectRemoved(const FGameplayTag EffectTag)
+{
+	FNoctAbilityTask Task;
+	Task.Type = ENoctAbilityTaskType::WaitEffectRemoved;
+	Task.Tag = EffectTag;
+	return StartTask(Task);
+}
+
+FNoctAbilityTaskHandle UNoctAbility::WaitTagAdded(const FGameplayTag Tag)
+{
+	FNoctAbilityTask Task;
+	Task.Type = ENoctAbilityTaskType::WaitTagAdded;
+	Task.Tag = Tag;
+	return StartTask(Task);
+}
+
+FNoctAbilityTaskHandle UNoctAbility::StartTask(FNoctAbilityTask& Task)
+{
+	if(!IsBoundToComponent() || !bIsActive)
+	{
+		return FNoctAbilityTaskHandle();
+	}
+
+	Task.AbilityTag = AbilityTag;
+	return OwningAbilityComponent->StartAbilityTask(Task);
+}
+
+void UNoctAbility::CancelAbilityTask(const FNoctAbilityTaskHandle Handle)
+{
+	if(IsBoundToComponent())
+	{
+		OwningAbilityComponent->CancelAbilityTask(Handle);
+	}
+}
+
+void UNoctAbility::NativeAbilityTaskCompleted(const FNoctAbilityTaskHandle Handle, const ENoctAbilityTaskType TaskType, const float Value)
+{
+	AbilityTaskCompleted(Handle, TaskType, Value);
+	OnAbilityTaskCompleted(Handle, TaskType, Value);
+}
+
 void UNoctAbility::FinishCooldown()
 {
 	NativeOnAbilityCooldownFinished();
@@ -114,20 +295,208 @@ void UNoctAbility::FinishCooldown()
 
 void UNoctAbility::TriggerCooldown(float CooldownOverride)
 {
-	float Time = CooldownOverride > 0 ? CooldownOverride : BaseCooldown;
-	GetWorld()->GetTimerManager().SetTimer(CooldownTimer, this, &UNoctAbility::FinishCooldown, Time, false);
+	float Time = CooldownOverride > 0 ? CooldownOverride : GetScaledCooldown();
+	if (HasCharges() && Time > 0)
+	{
+		OwningAbilityComponent->SpendCharge(AbilityTag, MaxCharges, Time, RechargePolicy);
+	}
+	else
+	{
+		OwningAbilityComponent->StartCooldown(AbilityTag, Time);
+	}
+
+	if (CooldownGroupTag.IsValid())
+	{
+		OwningAbilityComponent->StartCooldown(CooldownGroupTag, GroupCooldown > 0 ? GroupCooldown : Time);
+	}
 }
 
 bool UNoctAbility::CanActivateAbility()
 {
+	const bool bAbilityBlocked = OwningAbilityComponent->UsesTagBits() && AbilityTagBit != INDEX_NONE
+		? OwningAbilityComponent->GetBlockedAbilityBits().TestBit(AbilityTagBit)
+		: OwningAbilityComponent->BlockedAbilityTags.HasTagExact(AbilityTag);
+	
 	return (
-		!OwningAbilityComponent->ActiveAbilityTags.HasAnyExact(BlockingTags)
+		!IsBlockedByActiveAbilities()
 		&& !CooldownActive()
 		&& !bIsActive
-		&& !OwningAbilityComponent->BlockedAbilityTags.HasTagExact(AbilityTag)
+		&& !bAbilityBlocked
+		&& (!bCommitCostNatively || CanAffordCost())
 	);
 }
 
+float UNoctAbility::GetCostValue(const int32 CostIndex) const
+{
+	return CostIndex == 0 ? GetScaledCostValue() : AdditionalCosts[CostIndex - 1].GetValueAtLevel(Level);
+}
+
+void UNoctAbility::ResolveCostAttributes(TArray<FNoctAttribute*, TInlineAllocator<2>>& OutAttributes)
+{
+	TMap<FGameplayTag, FNoctAttribute>& Attributes = OwningAbilityComponent->Attributes;
+
+	// Non-instanced abilities are bound to a different component for every call
+	const bool bSameComponent = CostAttributesComponent == OwningAbilityComponent;
+	CostAttributesComponent = OwningAbilityComponent;
+	CostAttributeIds.SetNum(GetNumCosts());
+
+	OutAttributes.Reset();
+	for (int32 CostIndex = 0; CostIndex < CostAttributeIds.Num(); ++CostIndex)
+	{
+		const FGameplayTag AttributeTag = GetCostAttributeTag(CostIndex);
+		FSetElementId& Id = CostAttributeIds[CostIndex];
+		if (!bSameComponent || !Attributes.IsValidId(Id) || Attributes.Get(Id).Key != AttributeTag)
+		{
+			Id = Attributes.FindId(AttributeTag);
+		}
+		OutAttributes.Add(Id.IsValidId() ? &Attributes.Get(Id).Value : nullptr);
+	}
+}
+
+bool UNoctAbility::CanAffordCost()
+{
+	TArray<FNoctAttribute*, TInlineAllocator<2>> Attributes;
+	ResolveCostAttributes(Attributes);
+	return CanAffordCostFrom(Attributes);
+}
+
+bool UNoctAbility::CanAffordCostFrom(const TConstArrayView<FNoctAttribute*> Attributes) const
+{
+	// Sum per attribute first, two costs on the same attribute must both fit
+	TArray<TPair<FNoctAttribute*, float>, TInlineAllocator<2>> Totals;
+	for (int32 CostIndex = 0; CostIndex < Attributes.Num(); ++CostIndex)
+	{
+		const float Value = GetCostValue(CostIndex);
+		if (Value <= 0.0f)
+		{
+			continue;
+		}
+
+		FNoctAttribute* Attribute = Attributes[CostIndex];
+		if (!Attribute)
+		{
+			return false;
+		}
+
+		if (TPair<FNoctAttribute*, float>* Total = Totals.FindByPredicate([Attribute](const TPair<FNoctAttribute*, float>& Entry) { return Entry.Key == Attribute; }))
+		{
+			Total->Value += Value;
+		}
+		else
+		{
+			Totals.Emplace(Attribute, Value);
+		}
+	}
+
+	// Checked against the base value, which is what CommitCost takes the cost from
+	for (const TPair<FNoctAttribute*, float>& Total : Totals)
+	{
+		if (Total.Key->BaseValue < Total.Value)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool UNoctAbility::CommitCost()
+{
+	TArray<FNoctAttribute*, TInlineAllocator<2>> Attributes;
+	ResolveCostAttributes(Attributes);
+	if (!CanAffordCostFrom(Attributes))
+	{
+		return false;
+	}
+
+	CommittedCosts.SetNumZeroed(GetNumCosts());
+	for (int32 CostIndex = 0; CostIndex < Attributes.Num(); ++CostIndex)
+	{
+		const float Value = GetCostValue(CostIndex);
+		if (Value > 0.0f)
+		{
+			FNoctAttribute* Attribute = Attributes[CostIndex];
+			Attribute->BaseValue -= Value;
+			Attribute->CurrentValue = Attribute->CalculateValue();
+			CommittedCosts[CostIndex] = Value;
+			OwningAbilityComponent->RecordPredictedAttributeDelta(GetCostAttributeTag(CostIndex), -Value);
+		}
+	}
+	return true;
+}
+
+void UNoctAbility::RefundCost()
+{
+	TArray<FNoctAttribute*, TInlineAllocator<2>> Attributes;
+	ResolveCostAttributes(Attributes);
+	for (int32 CostIndex = 0; CostIndex < CommittedCosts.Num() && CostIndex < Attributes.Num(); ++CostIndex)
+	{
+		if (FNoctAttribute* Attribute = Attributes[CostIndex]; Attribute && CommittedCosts[CostIndex] > 0.0f)
+		{
+			Attribute->BaseValue += CommittedCosts[CostIndex];
+			Attribute->CurrentValue = Attribute->CalculateValue();
+		}
+	}
+	CommittedCosts.Reset();
+}
+
+bool UNoctAbility::IsBlockedByActiveAbilities() const
+{
+	// Exact matches only, so the bits give the same answer as the container whenever every blocking tag has a bit
+	if (bBlockingTagsCompiled && OwningAbilityComponent->UsesTagBits())
+	{
+		return OwningAbilityComponent->GetActiveAbilityBits().Intersects(BlockingTagBits);
+	}
+	return OwningAbilityComponent->ActiveAbilityTags.HasAnyExact(BlockingTags.Get());
+}
+
+bool UNoctAbility::MayCancelActiveAbilities() const
+{
+	if (CancelTags.IsEmpty())
+	{
+		return false;
+	}
+
+	// Only conclusive when every active ability has a bit
+	if (OwningAbilityComponent->UsesTagBits() && OwningAbilityComponent->GetNumUnindexedActiveAbilityTags() == 0)
+	{
+		return OwningAbilityComponent->GetActiveAbilityBits().Intersects(CancelTagBits);
+	}
+	return true;
+}
+
+void UNoctAbility::SetBlockingTags(const FGameplayTagContainer& Tags)
+{
+	BlockingTags.Set(Tags);
+	CompileTagBits();
+}
+
+void UNoctAbility::SetCancelTags(const FGameplayTagContainer& Tags)
+{
+	CancelTags.Set(Tags);
+	CompileTagBits();
+}
+
+void UNoctAbility::CompileTagBits()
+{
+	const FNoctTagBitRegistry& Registry = FNoctTagBitRegistry::Get();
+	
+	AbilityTagBit = Registry.GetBitIndex(AbilityTag);
+	bBlockingTagsCompiled = Registry.IsEnabled() && Registry.MakeExactBits(BlockingTags.Get(), BlockingTagBits);
+	Registry.MakeHierarchicalBits(CancelTags.Get(), CancelTagBits);
+}
+
+bool UNoctAbility::IsBoundToComponent() const
+{
+	if (OwningAbilityComponent)
+	{
+		return true;
+	}
+
+	// Non-instanced abilities only have an owner while the component is calling into them
+	UE_LOG(LogNoctAbilitySystem, Warning, TEXT("%s has no owning ability component. Non-instanced abilities can't be activated, finished or cancelled outside of a call from their component."), *GetName());
+	return false;
+}
+
 UWorld* UNoctAbility::GetWorld() const
 {
 	return OwningAbilityComponent ? OwningAbilityComponent->GetWorld() : nullptr;
@@ -145,20 +514,31 @@ ACharacter* UNoctAbility::GetOwningCharacter() const
 
 void UNoctAbility::InputActionStarted(const FInputActionValue& Value)
 {
+	CurrentInputValue = Value;
 	if (bAutoActivateAbilityOnInputStarted)
 	{
-		ActivateAbility();
+		if (OwningAbilityComponent->bBufferInputActivations)
+		{
+			OwningAbilityComponent->RequestActivateAbilityByTag(AbilityTag);
+		}
+		else
+		{
+			// Through the component, so an owning client predicts the activation
+			OwningAbilityComponent->ActivateAbilityByTag(AbilityTag);
+		}
 	}
 	OnAbilityInputStarted(Value);
 }
 
 void UNoctAbility::InputActionTriggered(const FInputActionValue& Value)
 {
+	CurrentInputValue = Value;
 	OnAbilityInputTriggered(Value);
 }
 
 void UNoctAbility::InputActionCompleted(const FInputActionValue& Value)
 {
+	CurrentInputValue = Value;
 	if (bAutoFinishAbilityOnInputCompleted)
 	{
 		FinishAbility();
@@ -168,6 +548,7 @@ void UNoctAbility::InputActionCompleted(const FInputActionValue& Value)
 
 void UNoctAbility::InputActionCancelled(const struct FInputActionValue& Value)
 {
+	CurrentInputValue = Value;
 	if (bAutoCancelAbilityOnInputCancelled)
 	{
 		CancelAbility();
@@ -177,5 +558,6 @@ void UNoctAbility::InputActionCancelled(const struct FInputActionValue& Value)
 
 bool UNoctAbility::CooldownActive() const 
 {
-	return GetWorld()->GetTimerManager().IsTimerActive(CooldownTimer);
+	// Covers the cooldown group as well
+	return OwningAbilityComponent && OwningAbilityComponent->IsAbilityOnCooldown(AbilityTag);
 }
@@ -4,146 +4,1703 @@
 #include "NoctAbilityComponent.h"
 #include "NoctAbility.h"
 #include "NoctEffect.h"
+#include "NoctAbilitySystemTrace.h"
+#include "NoctAbilityRecorder.h"
+#include "EnhancedInputComponent.h"
+#include "GameFramework/GameStateBase.h"
+#include "NoctAbilitySystemSettings.h"
+#include "Net/UnrealNetwork.h"
+#include "Algo/BinarySearch.h"
+
+FNoctAbilityBindingScope::FNoctAbilityBindingScope(UNoctAbilityComponent* InComponent, UNoctAbility* InAbility)
+{
+	if (!InComponent || !InAbility || InAbility->IsInstanced() || InAbility->OwningAbilityComponent == InComponent)
+	{
+		return;
+	}
+
+	const FNoctAbilityState* State = InComponent->FindSharedAbilityState(InAbility->AbilityTag);
+	if (!State)
+	{
+		return;
+	}
+
+	Component = InComponent;
+	Ability = InAbility;
+	PreviousComponent = Ability->OwningAbilityComponent;
+	Ability->StoreState(PreviousState);
+
+	Ability->OwningAbilityComponent = Component;
+	Ability->LoadState(*State);
+}
+
+FNoctAbilityBindingScope::~FNoctAbilityBindingScope()
+{
+	if (!Ability)
+	{
+		return;
+	}
+
+	// Look the state up again, the ability may have changed the component's abilities while bound
+	if (FNoctAbilityState* State = Component->FindSharedAbilityState(Ability->AbilityTag))
+	{
+		Ability->StoreState(*State);
+	}
+
+	Ability->OwningAbilityComponent = PreviousComponent;
+	Ability->LoadState(PreviousState);
+}
 
 UNoctAbilityComponent::UNoctAbilityComponent()
 {
-	PrimaryComponentTick.bCanEverTick = false;
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	SetIsReplicatedByDefault(true);
+
+	ReplicatedUnlockedTags.Owner = this;
+	ReplicatedUnlockedTags.SetType = ENoctReplicatedTagSet::Unlocked;
+	ReplicatedBlockedTags.Owner = this;
+	ReplicatedBlockedTags.SetType = ENoctReplicatedTagSet::Blocked;
+	ReplicatedActiveTags.Owner = this;
+	ReplicatedActiveTags.SetType = ENoctReplicatedTagSet::Active;
+	ReplicatedCooldowns.Owner = this;
+}
+
+// Called when the game starts
+void UNoctAbilityComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Abilities may already have been restored from a save
+	RebuildAbilityIndex();
+	RebuildTagBits();
+	RebuildReplicatedState();
+
+	for (const auto Ability : DefaultAbilities)
+	{
+		UnlockAbilityByClass(Ability);
+	}
+
+	if (UNoctAbilitySubsystem* Subsystem = UNoctAbilitySubsystem::Get(GetWorld()))
+	{
+		Subsystem->RegisterComponent(this);
+	}
+}
+
+void UNoctAbilityComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	NOCT_RECORD(RecordComponentRemoved(this));
+
+	if (UNoctAbilitySubsystem* Subsystem = UNoctAbilitySubsystem::Get(GetWorld()))
+	{
+		Subsystem->UnregisterComponent(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UNoctAbilityComponent::SetSignificanceTier(const ENoctSignificanceTier NewTier)
+{
+	if (NewTier == SignificanceTier)
+	{
+		return;
+	}
+
+	SignificanceTier = NewTier;
+
+	const UNoctAbilitySystemSettings* Settings = GetDefault<UNoctAbilitySystemSettings>();
+	switch (SignificanceTier)
+	{
+	case ENoctSignificanceTier::High:
+		SetComponentTickInterval(0.0f);
+		break;
+	case ENoctSignificanceTier::Medium:
+		SetComponentTickInterval(Settings->MediumSignificanceTickInterval);
+		break;
+	case ENoctSignificanceTier::Low:
+		SetComponentTickInterval(Settings->LowSignificanceTickInterval);
+		break;
+	}
+}
+
+void UNoctAbilityComponent::TickComponent(const float DeltaTime, const ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// Everything the tick does follows from earlier events, a replay gets it by ticking
+	NOCT_RECORD_NESTED_SCOPE();
+
+	AdvanceEffects(GetWorld()->GetTimeSeconds());
+	ProcessAbilityTasks(GetWorld()->GetTimeSeconds());
+	ProcessExpiredCooldowns(GetCooldownTime());
+	ResolveActivationRequests(GetCooldownTime());
+
+	UpdateTickEnabled();
+}
+
+bool UNoctAbilityComponent::HasAbilityUnlocked(const FGameplayTag TagToCheck) const
+{
+	return TestTagBit(UnlockedAbilityBits, TagToCheck, UnlockedAbilityTags);
+}
+
+bool UNoctAbilityComponent::HasAbilityActive(const FGameplayTag TagToCheck) const
+{
+	return TestTagBit(ActiveAbilityBits, TagToCheck, ActiveAbilityTags);
+}
+
+bool UNoctAbilityComponent::HasAbilityBlocked(const FGameplayTag TagToCheck) const
+{
+	return TestTagBit(BlockedAbilityBits, TagToCheck, BlockedAbilityTags);
+}
+
+void UNoctAbilityComponent::AddActiveAbilityTag(const FGameplayTag Tag)
+{
+	if(ActiveAbilityTags.HasTagExact(Tag))
+	{
+		return;
+	}
+
+	ActiveAbilityTags.AddTag(Tag);
+	if(CurrentPrediction)
+	{
+		CurrentPrediction->AddedActiveTags.Add(Tag);
+	}
+	NotifyAbilityTasks(ENoctAbilityTaskType::WaitTagAdded, Tag);
+	if(bTagBitsEnabled && !UpdateTagBit(ActiveAbilityBits, Tag, true))
+	{
+		++NumUnindexedActiveAbilityTags;
+	}
+	if(IsReplicatingState())
+	{
+		ReplicatedActiveTags.AddTag(Tag);
+	}
+}
+
+void UNoctAbilityComponent::RemoveActiveAbilityTag(const FGameplayTag Tag)
+{
+	if(!ActiveAbilityTags.RemoveTag(Tag))
+	{
+		return;
+	}
+
+	if(bTagBitsEnabled && !UpdateTagBit(ActiveAbilityBits, Tag, false))
+	{
+		--NumUnindexedActiveAbilityTags;
+	}
+	if(IsReplicatingState())
+	{
+		ReplicatedActiveTags.RemoveTag(Tag);
+	}
+}
+
+void UNoctAbilityComponent::SetUnlockedTag(const FGameplayTag Tag, const bool bUnlocked)
+{
+	if(bUnlocked == UnlockedAbilityTags.HasTagExact(Tag))
+	{
+		return;
+	}
+
+	if(bUnlocked)
+	{
+		UnlockedAbilityTags.AddTag(Tag);
+	}
+	else
+	{
+		UnlockedAbilityTags.RemoveTag(Tag);
+	}
+	
+	if(bTagBitsEnabled)
+	{
+		UpdateTagBit(UnlockedAbilityBits, Tag, bUnlocked);
+	}
+	if(IsReplicatingState())
+	{
+		bUnlocked ? ReplicatedUnlockedTags.AddTag(Tag) : ReplicatedUnlockedTags.RemoveTag(Tag);
+	}
+}
+
+void UNoctAbilityComponent::SetBlockedTag(const FGameplayTag Tag, const bool bBlocked)
+{
+	if(bBlocked == BlockedAbilityTags.HasTagExact(Tag))
+	{
+		return;
+	}
+
+	if(bBlocked)
+	{
+		BlockedAbilityTags.AddTag(Tag);
+	}
+	else
+	{
+		BlockedAbilityTags.RemoveTag(Tag);
+	}
+	
+	if(bTagBitsEnabled)
+	{
+		UpdateTagBit(BlockedAbilityBits, Tag, bBlocked);
+	}
+	if(IsReplicatingState())
+	{
+		bBlocked ? ReplicatedBlockedTags.AddTag(Tag) : ReplicatedBlockedTags.RemoveTag(Tag);
+	}
+}
+
+bool UNoctAbilityComponent::IsReplicatingState() const
+{
+	return bReplicateAbilityState && GetIsReplicated() && GetOwner() && GetOwner()->HasAuthority() && GetNetMode() != NM_Standalone;
+}
+
+void UNoctAbilityComponent::RebuildReplicatedState()
+{
+	if(!IsReplicatingState())
+	{
+		return;
+	}
+
+	ReplicatedUnlockedTags.Reset(UnlockedAbilityTags);
+	ReplicatedBlockedTags.Reset(BlockedAbilityTags);
+	ReplicatedActiveTags.Reset(ActiveAbilityTags);
+
+	ReplicatedCooldowns.Items.Reset();
+	for (const FNoctCooldownEntry& Entry : Cooldowns.Entries)
+	{
+		ReplicatedCooldowns.SetCooldown(Entry.Tag, &Entry);
+	}
+	ReplicatedCooldowns.MarkArrayDirty();
+}
+
+void UNoctAbilityComponent::ApplyReplicatedTag(const ENoctReplicatedTagSet SetType, const FGameplayTag Tag, const bool bAdded)
+{
+	switch (SetType)
+	{
+	case ENoctReplicatedTagSet::Unlocked:
+		SetUnlockedTag(Tag, bAdded);
+		break;
+	case ENoctReplicatedTagSet::Blocked:
+		SetBlockedTag(Tag, bAdded);
+		break;
+	case ENoctReplicatedTagSet::Active:
+		bAdded ? AddActiveAbilityTag(Tag) : RemoveActiveAbilityTag(Tag);
+		break;
+	}
+}
+
+void UNoctAbilityComponent::ApplyReplicatedCooldown(const FNoctReplicatedCooldown& Cooldown)
+{
+	Cooldowns.Restore(Cooldown.ToEntry(), GetCooldownTime());
+	UpdateTickEnabled();
+}
+
+void UNoctAbilityComponent::OnRep_ActiveAbilityFlags(const TArray<uint64>& PreviousFlags)
+{
+	// Only sent to clients that don't own the component, the owner gets ReplicatedActiveTags instead
+	const FNoctTagBitRegistry& Registry = FNoctTagBitRegistry::Get();
+	const int32 NumWords = FMath::Max(PreviousFlags.Num(), ReplicatedActiveAbilityFlags.Num());
+	
+	for (int32 WordIndex = 0; WordIndex < NumWords; ++WordIndex)
+	{
+		const uint64 Previous = PreviousFlags.IsValidIndex(WordIndex) ? PreviousFlags[WordIndex] : 0;
+		const uint64 Current = ReplicatedActiveAbilityFlags.IsValidIndex(WordIndex) ? ReplicatedActiveAbilityFlags[WordIndex] : 0;
+		
+		for (uint64 Changed = Previous ^ Current; Changed != 0; Changed &= Changed - 1)
+		{
+			const int32 BitIndex = WordIndex * 64 + static_cast<int32>(FMath::CountTrailingZeros64(Changed));
+			const FGameplayTag Tag = Registry.GetTag(BitIndex);
+			if (!Tag.IsValid())
+			{
+				continue;
+			}
+
+			if (Current & (1ull << (BitIndex & 63)))
+			{
+				AddActiveAbilityTag(Tag);
+			}
+			else
+			{
+				RemoveActiveAbilityTag(Tag);
+			}
+		}
+	}
+}
+
+void UNoctAbilityComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(UNoctAbilityComponent, ReplicatedUnlockedTags, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(UNoctAbilityComponent, ReplicatedBlockedTags, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(UNoctAbilityComponent, ReplicatedActiveTags, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(UNoctAbilityComponent, ReplicatedCooldowns, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(UNoctAbilityComponent, ReplicatedActiveAbilityFlags, COND_SkipOwner);
+}
+
+void UNoctAbilityComponent::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	// Other clients only see which abilities are active, and only as often as NonOwnerReplicationInterval allows
+	const double Now = GetCooldownTime();
+	if (bReplicateAbilityState && Now - LastActiveFlagsSnapshotTime >= NonOwnerReplicationInterval)
+	{
+		LastActiveFlagsSnapshotTime = Now;
+		
+		const TArray<uint64, TInlineAllocator<4>>& Words = ActiveAbilityBits.Words;
+		const bool bChanged = ReplicatedActiveAbilityFlags.Num() != Words.Num()
+			|| FMemory::Memcmp(ReplicatedActiveAbilityFlags.GetData(), Words.GetData(), Words.Num() * sizeof(uint64)) != 0;
+		
+		if (bChanged)
+		{
+			ReplicatedActiveAbilityFlags.Reset();
+			ReplicatedActiveAbilityFlags.Append(Words);
+		}
+	}
+}
+
+void UNoctAbilityComponent::RebuildTagBits()
+{
+	bTagBitsEnabled = bUseTagBits && FNoctTagBitRegistry::Get().IsEnabled();
+
+	UnlockedAbilityBits.Reset();
+	BlockedAbilityBits.Reset();
+	ActiveAbilityBits.Reset();
+	NumUnindexedActiveAbilityTags = 0;
+
+	if(!bTagBitsEnabled)
+	{
+		return;
+	}
+
+	const FNoctTagBitRegistry& Registry = FNoctTagBitRegistry::Get();
+	Registry.MakeExactBits(UnlockedAbilityTags, UnlockedAbilityBits);
+	Registry.MakeExactBits(BlockedAbilityTags, BlockedAbilityBits);
+	Registry.MakeExactBits(ActiveAbilityTags, ActiveAbilityBits);
+
+	for (const FGameplayTag& Tag : ActiveAbilityTags)
+	{
+		if(Registry.GetBitIndex(Tag) == INDEX_NONE)
+		{
+			++NumUnindexedActiveAbilityTags;
+		}
+	}
+}
+
+bool UNoctAbilityComponent::UpdateTagBit(FNoctTagBits& Bits, const FGameplayTag Tag, const bool bSet)
+{
+	const int32 Index = FNoctTagBitRegistry::Get().GetBitIndex(Tag);
+	if(Index == INDEX_NONE)
+	{
+		return false;
+	}
+
+	if(bSet)
+	{
+		Bits.SetBit(Index);
+	}
+	else
+	{
+		Bits.ClearBit(Index);
+	}
+	return true;
+}
+
+bool UNoctAbilityComponent::TestTagBit(const FNoctTagBits& Bits, const FGameplayTag Tag, const FGameplayTagContainer& FallbackContainer) const
+{
+	if(bTagBitsEnabled)
+	{
+		const int32 Index = FNoctTagBitRegistry::Get().GetBitIndex(Tag);
+		if(Index != INDEX_NONE)
+		{
+			return Bits.TestBit(Index);
+		}
+	}
+	return FallbackContainer.HasTagExact(Tag);
+}
+
+bool UNoctAbilityComponent::UnlockAbilityByTag(const FGameplayTag AbilityTag)
+{
+	if(UnlockedAbilityTags.HasTagExact(AbilityTag))
+	{
+		return false;
+	}
+
+	SetUnlockedTag(AbilityTag, true);
+	return true;
+}
+
+bool UNoctAbilityComponent::UnlockAbilityByClass(const TSubclassOf<UNoctAbility> AbilityClass)
+{
+	bool bValidAbility = false;
+	if (AbilityClass)
+	{
+		if (auto DefaultAbility = AbilityClass->GetDefaultObject<UNoctAbility>())
+		{
+			bValidAbility = ! UnlockedAbilityTags.HasTagExact(DefaultAbility->AbilityTag);
+		}
+	}
+
+	if (bValidAbility)
+	{
+		const auto DefaultAbility = AbilityClass->GetDefaultObject<UNoctAbility>();
+		
+		if (bLazyAbilityInstancing && DefaultAbility->IsInstanced() && !DefaultAbility->bAutoActivateOnAdd)
+		{
+			FNoctPendingAbility& PendingAbility = PendingAbilities.AddDefaulted_GetRef();
+			PendingAbility.AbilityClass = AbilityClass;
+			PendingAbility.AbilityTag = DefaultAbility->AbilityTag;
+			RegisterAbilityInput(DefaultAbility->ActivationAction, DefaultAbility->AbilityTag, DefaultAbility->bAllowInputTriggered);
+		}
+		// Non-instanced abilities share the class default object, only their state is per actor
+		else if (UNoctAbility* NewAbility = DefaultAbility->IsInstanced() ? AcquireAbility(AbilityClass) : DefaultAbility)
+		{
+			if (!NewAbility->IsInstanced())
+			{
+				FNoctAbilityState& State = SharedAbilityStates.AddDefaulted_GetRef();
+				State.AbilityTag = NewAbility->AbilityTag;
+				State.Level = NewAbility->Level;
+			}
+			
+			AddAbility(NewAbility);
+		}
+		else
+		{
+			return false;
+		}
+
+		SetUnlockedTag(DefaultAbility->AbilityTag, true);
+		NOCT_RECORD(RecordAbilityUnlocked(this, AbilityClass));
+	}
+
+	return bValidAbility;
+}
+
+
+void UNoctAbilityComponent::AddAbility(UNoctAbility* Ability)
+{
+	Abilities.Add(Ability);
+	IndexAbility(Ability);
+	
+	FNoctAbilityBindingScope BindingScope(this, Ability);
+	Ability->AbilityAddedToOwner();
+}
+
+UNoctAbility* UNoctAbilityComponent::FindOrCreateAbilityByTag(const FGameplayTag AbilityTag)
+{
+	if (const auto Ability = FindAbilityByTag(AbilityTag))
+	{
+		return Ability;
+	}
+
+	const int32 PendingIndex = PendingAbilities.IndexOfByPredicate([AbilityTag](const FNoctPendingAbility& PendingAbility)
+	{
+		return PendingAbility.AbilityTag == AbilityTag;
+	});
+	
+	if (PendingIndex == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	// Its input is already routed by tag, the ability registering itself once added just refreshes that
+	const FNoctPendingAbility PendingAbility = PendingAbilities[PendingIndex];
+	PendingAbilities.RemoveAtSwap(PendingIndex, 1, EAllowShrinking::No);
+	
+	const auto NewAbility = AcquireAbility(PendingAbility.AbilityClass);
+	if (NewAbility)
+	{
+		AddAbility(NewAbility);
+	}
+	return NewAbility;
+}
+
+UNoctAbility* UNoctAbilityComponent::AcquireAbility(const TSubclassOf<UNoctAbility> AbilityClass)
+{
+	if (FNoctAbilityPool* Pool = AbilityPool.Find(AbilityClass))
+	{
+		if (Pool->FreeAbilities.Num() > 0)
+		{
+			return Pool->FreeAbilities.Pop(EAllowShrinking::No);
+		}
+	}
+
+	return NewObject<UNoctAbility>(this, AbilityClass);
+}
+
+void UNoctAbilityComponent::ReleaseAbility(UNoctAbility* Ability)
+{
+	if (!Ability || !Ability->IsInstanced() || Ability->GetOuter() != this)
+	{
+		return;
+	}
+
+	FNoctAbilityPool& Pool = AbilityPool.FindOrAdd(Ability->GetClass());
+	if (Pool.FreeAbilities.Num() < MaxPooledAbilitiesPerClass)
+	{
+		Ability->ResetForReuse();
+		Pool.FreeAbilities.Add(Ability);
+	}
+}
+
+UNoctAbility* UNoctAbilityComponent::FindAbilityByTag(const FGameplayTag AbilityTag) const
+{
+	const TObjectPtr<UNoctAbility>* Ability = AbilitiesByTag.Find(AbilityTag);
+	return Ability ? Ability->Get() : nullptr;
+}
+
+FNoctAbilityState* UNoctAbilityComponent::FindSharedAbilityState(const FGameplayTag AbilityTag)
+{
+	// Components only hold a handful of these, a scan beats a map here
+	return SharedAbilityStates.FindByPredicate([AbilityTag](const FNoctAbilityState& State)
+	{
+		return State.AbilityTag == AbilityTag;
+	});
+}
+
+bool UNoctAbilityComponent::IsAbilityActive(const UNoctAbility* Ability) const
+{
+	if (Ability->IsInstanced() || Ability->OwningAbilityComponent == this)
+	{
+		return Ability->bIsActive;
+	}
+
+	const FNoctAbilityState* State = SharedAbilityStates.FindByPredicate([Ability](const FNoctAbilityState& Entry)
+	{
+		return Entry.AbilityTag == Ability->AbilityTag;
+	});
+	return State && State->bIsActive;
+}
+
+bool FNoctInputRoute::WantsTriggered() const
+{
+	return Targets.ContainsByPredicate([](const FNoctInputRouteTarget& Target)
+	{
+		return Target.bAllowInputTriggered;
+	});
+}
+
+void UNoctAbilityComponent::RegisterAbilityInput(UInputAction* Action, const FGameplayTag AbilityTag, const bool bAllowInputTriggered)
+{
+	if (!Action)
+	{
+		return;
+	}
+
+	FNoctInputRoute* Route = InputRoutes.FindByPredicate([Action](const FNoctInputRoute& Entry)
+	{
+		return Entry.Action == Action;
+	});
+
+	UEnhancedInputComponent* InputComponent = FindInputComponent();
+	if (!Route)
+	{
+		Route = &InputRoutes.AddDefaulted_GetRef();
+		Route->Action = Action;
+		BindInputRoute(*Route, InputComponent);
+	}
+
+	FNoctInputRouteTarget* Target = Route->Targets.FindByPredicate([AbilityTag](const FNoctInputRouteTarget& Entry)
+	{
+		return Entry.AbilityTag == AbilityTag;
+	});
+	
+	if (!Target)
+	{
+		Target = &Route->Targets.AddDefaulted_GetRef();
+		Target->AbilityTag = AbilityTag;
+	}
+	Target->bAllowInputTriggered = bAllowInputTriggered;
+
+	UpdateTriggeredBinding(*Route, InputComponent);
+}
+
+void UNoctAbilityComponent::UnregisterAbilityInput(const FGameplayTag AbilityTag)
+{
+	UEnhancedInputComponent* InputComponent = FindInputComponent();
+	
+	for (int32 Index = InputRoutes.Num() - 1; Index >= 0; --Index)
+	{
+		FNoctInputRoute& Route = InputRoutes[Index];
+		const int32 NumRemoved = Route.Targets.RemoveAll([AbilityTag](const FNoctInputRouteTarget& Target)
+		{
+			return Target.AbilityTag == AbilityTag;
+		});
+
+		if (NumRemoved == 0)
+		{
+			continue;
+		}
+		
+		if (Route.Targets.IsEmpty())
+		{
+			UnbindInputRoute(Route, InputComponent);
+			InputRoutes.RemoveAtSwap(Index);
+		}
+		else
+		{
+			UpdateTriggeredBinding(Route, InputComponent);
+		}
+	}
+}
+
+void UNoctAbilityComponent::RebindInputRoutes()
+{
+	UEnhancedInputComponent* InputComponent = FindInputComponent();
+	for (FNoctInputRoute& Route : InputRoutes)
+	{
+		UnbindInputRoute(Route, InputComponent);
+		BindInputRoute(Route, InputComponent);
+		UpdateTriggeredBinding(Route, InputComponent);
+	}
+}
+
+UEnhancedInputComponent* UNoctAbilityComponent::FindInputComponent() const
+{
+	if (const auto OwnerPawn = Cast<APawn>(GetOwner()))
+	{
+		return OwnerPawn->FindComponentByClass<UEnhancedInputComponent>();
+	}
+	return nullptr;
+}
+
+void UNoctAbilityComponent::BindInputRoute(FNoctInputRoute& Route, UEnhancedInputComponent* InputComponent)
+{
+	if (!InputComponent)
+	{
+		return;
+	}
+
+	for (const ETriggerEvent TriggerEvent : {ETriggerEvent::Started, ETriggerEvent::Completed, ETriggerEvent::Canceled})
+	{
+		Route.BindingHandles.Add(InputComponent->BindAction(Route.Action, TriggerEvent, this, &UNoctAbilityComponent::HandleRoutedInput).GetHandle());
+	}
+}
+
+void UNoctAbilityComponent::UnbindInputRoute(FNoctInputRoute& Route, UEnhancedInputComponent* InputComponent)
+{
+	if (InputComponent)
+	{
+		for (const uint32 Handle : Route.BindingHandles)
+		{
+			InputComponent->RemoveBindingByHandle(Handle);
+		}
+		
+		if (Route.TriggeredBindingHandle != 0)
+		{
+			InputComponent->RemoveBindingByHandle(Route.TriggeredBindingHandle);
+		}
+	}
+	
+	Route.BindingHandles.Reset();
+	Route.TriggeredBindingHandle = 0;
+}
+
+void UNoctAbilityComponent::UpdateTriggeredBinding(FNoctInputRoute& Route, UEnhancedInputComponent* InputComponent)
+{
+	// Triggered fires every frame the action is held, only bind it while an ability listens for it
+	const bool bWantsTriggered = InputComponent && Route.WantsTriggered();
+	const bool bHasTriggered = Route.TriggeredBindingHandle != 0;
+	
+	if (bWantsTriggered && !bHasTriggered)
+	{
+		Route.TriggeredBindingHandle = InputComponent->BindAction(Route.Action, ETriggerEvent::Triggered, this, &UNoctAbilityComponent::HandleRoutedInput).GetHandle();
+	}
+	else if (!bWantsTriggered && bHasTriggered)
+	{
+		if (InputComponent)
+		{
+			InputComponent->RemoveBindingByHandle(Route.TriggeredBindingHandle);
+		}
+		Route.TriggeredBindingHandle = 0;
+	}
+}
+
+void UNoctAbilityComponent::HandleRoutedInput(const FInputActionInstance& Instance)
+{
+	const FNoctInputRoute* Route = InputRoutes.FindByPredicate([&Instance](const FNoctInputRoute& Entry)
+	{
+		return Entry.Action == Instance.GetSourceAction();
+	});
+
+	if (!Route)
+	{
+		return;
+	}
+
+	const ETriggerEvent TriggerEvent = Instance.GetTriggerEvent();
+	const FInputActionValue Value = Instance.GetValue();
+	
+	// Copied, abilities reacting to input can add or remove abilities and with them routes
+	TArray<FNoctInputRouteTarget, TInlineAllocator<4>> Targets(Route->Targets);
+	for (const FNoctInputRouteTarget& Target : Targets)
+	{
+		if (TriggerEvent != ETriggerEvent::Triggered || Target.bAllowInputTriggered)
+		{
+			DispatchAbilityInput(Value, TriggerEvent, Target.AbilityTag);
+		}
+	}
+}
+
+void UNoctAbilityComponent::DispatchAbilityInput(const FInputActionValue& Value, const ETriggerEvent TriggerEvent, const FGameplayTag AbilityTag)
+{
+	const auto Ability = FindOrCreateAbilityByTag(AbilityTag);
+	if (!Ability)
+	{
+		return;
+	}
+
+	// Before the ability sees the input, which may finish it and end its tasks
+	if (TriggerEvent == ETriggerEvent::Completed || TriggerEvent == ETriggerEvent::Canceled)
+	{
+		NotifyAbilityTasks(ENoctAbilityTaskType::WaitInputReleased, FGameplayTag(), AbilityTag);
+	}
+
+	FNoctAbilityBindingScope BindingScope(this, Ability);
+	switch (TriggerEvent)
+	{
+	case ETriggerEvent::Started:
+		Ability->InputActionStarted(Value);
+		break;
+	case ETriggerEvent::Triggered:
+		Ability->InputActionTriggered(Value);
+		break;
+	case ETriggerEvent::Completed:
+		Ability->InputActionCompleted(Value);
+		break;
+	case ETriggerEvent::Canceled:
+		Ability->InputActionCancelled(Value);
+		break;
+	default:
+		break;
+	}
+}
+
+void UNoctAbilityComponent::IndexAbility(UNoctAbility* Ability)
+{
+	AbilitiesByTag.Add(Ability->AbilityTag, Ability);
+	Ability->CompileTagBits();
+
+	// Index under the tag itself and all of its parents, so a cancel by "Ability.Movement" finds "Ability.Movement.Dash"
+	for (const FGameplayTag& ParentTag : Ability->AbilityTag.GetGameplayTagParents())
+	{
+		AbilitiesByParentTag.FindOrAdd(ParentTag).AddUnique(Ability);
+	}
+
+	if (Ability->CooldownGroupTag.IsValid())
+	{
+		AbilitiesByCooldownGroup.FindOrAdd(Ability->CooldownGroupTag).AddUnique(Ability);
+	}
+}
+
+void UNoctAbilityComponent::UnindexAbility(UNoctAbility* Ability)
+{
+	AbilitiesByTag.Remove(Ability->AbilityTag);
+
+	for (const FGameplayTag& ParentTag : Ability->AbilityTag.GetGameplayTagParents())
+	{
+		if (TArray<UNoctAbility*>* AbilitiesUnderTag = AbilitiesByParentTag.Find(ParentTag))
+		{
+			AbilitiesUnderTag->RemoveSingleSwap(Ability);
+			if (AbilitiesUnderTag->IsEmpty())
+			{
+				AbilitiesByParentTag.Remove(ParentTag);
+			}
+		}
+	}
+
+	if (TArray<UNoctAbility*>* GroupAbilities = AbilitiesByCooldownGroup.Find(Ability->CooldownGroupTag))
+	{
+		GroupAbilities->RemoveSingleSwap(Ability);
+		if (GroupAbilities->IsEmpty())
+		{
+			AbilitiesByCooldownGroup.Remove(Ability->CooldownGroupTag);
+		}
+	}
+}
+
+void UNoctAbilityComponent::RebuildAbilityIndex()
+{
+	AbilitiesByTag.Reset();
+	AbilitiesByParentTag.Reset();
+	AbilitiesByCooldownGroup.Reset();
+
+	for (const auto& Ability : Abilities)
+	{
+		if (Ability)
+		{
+			IndexAbility(Ability);
+		}
+	}
+}
+
+void UNoctAbilityComponent::ActivateAbilityByTag(const FGameplayTag AbilityTag)
+{
+	if (const auto Ability = FindOrCreateAbilityByTag(AbilityTag))
+	{
+		if (IsPredictingClient())
+		{
+			ActivateAbilityPredicted(Ability);
+			return;
+		}
+		
+		FNoctAbilityBindingScope BindingScope(this, Ability);
+		if(Ability->CanActivateAbility())
+			Ability->ActivateAbility();
+	}
+}
+
+void UNoctAbilityComponent::RequestActivateAbilityByTag(const FGameplayTag AbilityTag)
+{
+	if (!AbilityTag.IsValid())
+	{
+		return;
+	}
+
+	// The activation happens in the tick, which is nested, so a replay needs the request to get it
+	NOCT_RECORD(RecordAbility(ENoctRecordedEventType::AbilityActivationRequested, this, AbilityTag));
+
+	// Asking again refreshes the buffer window rather than queueing a second activation
+	const double Now = GetCooldownTime();
+	if (FNoctActivationRequest* Request = PendingActivations.FindByPredicate([AbilityTag](const FNoctActivationRequest& Entry)
+	{
+		return Entry.AbilityTag == AbilityTag;
+	}))
+	{
+		Request->RequestTime = Now;
+	}
+	else
+	{
+		PendingActivations.Add({AbilityTag, Now});
+	}
+
+	UpdateTickEnabled();
+}
+
+void UNoctAbilityComponent::ResolveActivationRequests(const double Now)
+{
+	if (PendingActivations.IsEmpty())
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NoctResolveActivations);
+
+	// Requests made while resolving, by the abilities activating, are left for the next frame
+	const TArray<FNoctActivationRequest, TInlineAllocator<8>> Requests(PendingActivations);
+	PendingActivations.Reset();
+
+	struct FCandidate
+	{
+		UNoctAbility* Ability;
+		const FNoctActivationRequest* Request;
+	};
+	
+	TArray<FCandidate, TInlineAllocator<8>> Candidates;
+	FGameplayTagContainer BatchCancelTags;
+
+	const auto KeepBuffered = [this, Now](const FNoctActivationRequest& Request)
+	{
+		const bool bRequestedAgain = PendingActivations.ContainsByPredicate([&Request](const FNoctActivationRequest& Entry)
+		{
+			return Entry.AbilityTag == Request.AbilityTag;
+		});
+		
+		if (!bRequestedAgain && Now - Request.RequestTime < InputBufferWindow)
+		{
+			PendingActivations.Add(Request);
+		}
+	};
+
+	for (const FNoctActivationRequest& Request : Requests)
+	{
+		UNoctAbility* Ability = FindOrCreateAbilityByTag(Request.AbilityTag);
+		if (!Ability)
+		{
+			continue;
+		}
+
+		FNoctAbilityBindingScope BindingScope(this, Ability);
+		if (Ability->CanActivateAbility())
+		{
+			Candidates.Add({Ability, &Request});
+			BatchCancelTags.AppendTags(Ability->GetCancelTags());
+		}
+		else
+		{
+			KeepBuffered(Request);
+		}
+	}
+
+	if (Candidates.IsEmpty())
+	{
+		return;
+	}
+
+	// Stable, so equal priorities activate in the order they were requested
+	Candidates.StableSort([](const FCandidate& A, const FCandidate& B)
+	{
+		return A.Ability->ActivationPriority > B.Ability->ActivationPriority;
+	});
+
+	// One cancel pass for the whole batch, for the abilities that were already active.
+	// Candidates aren't active yet, cancels between them are resolved as they activate below.
+	if (!BatchCancelTags.IsEmpty())
+	{
+		CancelAbilities(BatchCancelTags);
+	}
+
+	// What the candidates activated so far cancel. Later candidates under these are dropped, so two abilities
+	// that cancel each other never end up active together. The higher priority one wins.
+	FGameplayTagContainer ActivatedCancelTags;
+	int32 NumActivated = 0;
+
+	for (const FCandidate& Candidate : Candidates)
+	{
+		// Cancelling runs Blueprint code, which may have removed the ability
+		if (FindAbilityByTag(Candidate.Request->AbilityTag) != Candidate.Ability)
+		{
+			continue;
+		}
+
+		if (Candidate.Request->AbilityTag.MatchesAny(ActivatedCancelTags))
+		{
+			continue;
+		}
+
+		// Checked again, a higher priority ability that activated first may block this one
+		FNoctAbilityBindingScope BindingScope(this, Candidate.Ability);
+		if (Candidate.Ability->CanActivateAbility())
+		{
+			// Candidates that activated earlier in the batch missed the cancel pass, cancel them as activating one at a time would
+			const FGameplayTagContainer& CancelTags = Candidate.Ability->GetCancelTags();
+			if (NumActivated > 0 && !CancelTags.IsEmpty())
+			{
+				CancelAbilities(CancelTags);
+			}
+
+			if (IsPredictingClient())
+			{
+				ActivateAbilityPredicted(Candidate.Ability, false);
+			}
+			else
+			{
+				Candidate.Ability->ActivateAbilityWithoutCancel();
+			}
+
+			if (Candidate.Ability->bIsActive)
+			{
+				ActivatedCancelTags.AppendTags(CancelTags);
+				++NumActivated;
+			}
+		}
+		else
+		{
+			KeepBuffered(*Candidate.Request);
+		}
+	}
+}
+
+bool UNoctAbilityComponent::IsPredictingClient() const
+{
+	// The server's answers are only meaningful when it replicates the state they confirm
+	return bReplicateAbilityState && GetIsReplicated() && GetOwnerRole() == ROLE_AutonomousProxy;
+}
+
+void UNoctAbilityComponent::ActivateAbilityPredicted(UNoctAbility* Ability, const bool bCancelAbilities)
+{
+	const FNoctPredictionKey PredictionKey = PredictActivation(Ability, bCancelAbilities);
+	if (!PredictionKey.IsValid())
+	{
+		return;
+	}
+
+	// Copied out, the server's answer can arrive straight away when there is no connection in between
+	const FNoctPredictionRecord& Record = PendingPredictions.Last();
+	const FGameplayTag AbilityTag = Record.AbilityTag;
+	const bool bEndedDuringActivation = Record.bEndedDuringActivation;
+	const bool bCancelledDuringActivation = Record.bCancelledDuringActivation;
+
+	ServerActivateAbilityPredicted(AbilityTag, PredictionKey);
+	if (bEndedDuringActivation)
+	{
+		bCancelledDuringActivation ? ServerCancelAbilityPredicted(AbilityTag) : ServerFinishAbilityPredicted(AbilityTag);
+	}
+}
+
+FNoctPredictionKey UNoctAbilityComponent::PredictActivation(UNoctAbility* Ability, const bool bCancelAbilities)
+{
+	const double Now = GetCooldownTime();
+	
+	FNoctPredictionRecord Record;
+	Record.Key = LastPredictionKey = FNoctPredictionKey::MakeNext(LastPredictionKey);
+	Record.AbilityTag = Ability->AbilityTag;
+	Record.PredictionTime = Now;
+	
+	// Finishing later starts the cooldown outside of the prediction, so remember it as it is now
+	Record.RecordCooldown(Ability->AbilityTag, Cooldowns);
+	if (Ability->CooldownGroupTag.IsValid())
+	{
+		Record.RecordCooldown(Ability->CooldownGroupTag, Cooldowns);
+	}
+	
+	{
+		TGuardValue<FNoctPredictionRecord*> PredictionScope(CurrentPrediction, &Record);
+		FNoctAbilityBindingScope BindingScope(this, Ability);
+		
+		if (!Ability->CanActivateAbility())
+		{
+			return FNoctPredictionKey();
+		}
+
+		if (bCancelAbilities)
+		{
+			Ability->ActivateAbility();
+		}
+		else
+		{
+			Ability->ActivateAbilityWithoutCancel();
+		}
+
+		// Refused locally, such as by a cost it couldn't commit. Nothing was predicted, so there is nothing to ask for.
+		if (!Ability->bIsActive && !Record.bEndedDuringActivation)
+		{
+			return FNoctPredictionKey();
+		}
+	}
+
+	const FNoctPredictionKey PredictionKey = Record.Key;
+	PendingPredictions.Add(MoveTemp(Record));
+	if (PendingPredictions.Num() > MaxPendingPredictions)
+	{
+		PendingPredictions.RemoveAt(0);
+	}
+	return PredictionKey;
+}
+
+void UNoctAbilityComponent::RecordPredictedAttributeDelta(const FGameplayTag AttributeTag, const float Delta)
+{
+	if (CurrentPrediction)
+	{
+		CurrentPrediction->RecordAttributeDelta(AttributeTag, Delta);
+	}
+}
+
+void UNoctAbilityComponent::ServerActivateAbilityPredicted_Implementation(const FGameplayTag AbilityTag, const FNoctPredictionKey PredictionKey)
+{
+	bool bActivated = false;
+	if (const auto Ability = FindOrCreateAbilityByTag(AbilityTag))
+	{
+		FNoctAbilityBindingScope BindingScope(this, Ability);
+		if (Ability->CanActivateAbility())
+		{
+			Ability->ActivateAbility();
+			bActivated = true;
+
+			// Instant abilities have already ended, and the client's finish for them is ignored
+			if (Ability->bIsActive)
+			{
+				PredictedActiveAbilityTags.AddTag(AbilityTag);
+			}
+		}
+	}
+
+	if (bActivated)
+	{
+		ClientConfirmPrediction(PredictionKey);
+	}
+	else
+	{
+		ClientRejectPrediction(PredictionKey);
+	}
+}
+
+void UNoctAbilityComponent::NotifyAbilityEnded(const UNoctAbility* Ability, const bool bCancelled)
+{
+	// However it ended on the server, the client's predicted activation is over
+	PredictedActiveAbilityTags.RemoveTag(Ability->AbilityTag);
+
+	if (bRollingBackPrediction || !IsPredictingClient())
+	{
+		return;
+	}
+
+	if (CurrentPrediction && CurrentPrediction->AbilityTag == Ability->AbilityTag)
+	{
+		CurrentPrediction->bEndedDuringActivation = true;
+		CurrentPrediction->bCancelledDuringActivation = bCancelled;
+		return;
+	}
+
+	if (bCancelled)
+	{
+		ServerCancelAbilityPredicted(Ability->AbilityTag);
+	}
+	else
+	{
+		ServerFinishAbilityPredicted(Ability->AbilityTag);
+	}
+}
+
+void UNoctAbilityComponent::ServerFinishAbilityPredicted_Implementation(const FGameplayTag AbilityTag)
+{
+	// Abilities the server activated itself, such as a stun or a channel, aren't the client's to end
+	if (PredictedActiveAbilityTags.HasTagExact(AbilityTag))
+	{
+		FinishAbilityByTag(AbilityTag);
+	}
+}
+
+void UNoctAbilityComponent::ServerCancelAbilityPredicted_Implementation(const FGameplayTag AbilityTag)
+{
+	if (PredictedActiveAbilityTags.HasTagExact(AbilityTag))
+	{
+		CancelAbilityByTag(AbilityTag);
+	}
+}
+
+void UNoctAbilityComponent::ClientConfirmPrediction_Implementation(const FNoctPredictionKey PredictionKey)
+{
+	PendingPredictions.RemoveAll([PredictionKey](const FNoctPredictionRecord& Record)
+	{
+		return Record.Key == PredictionKey;
+	});
+}
+
+void UNoctAbilityComponent::SendCues(const TArray<FNoctCue>& Cues)
+{
+	// The server's cues go to every client, effects applied anywhere else are only shown there
+	if (IsMulticastingCues())
+	{
+		MulticastCues(Cues);
+		return;
+	}
+
+	UNoctAbilitySubsystem* Subsystem = UNoctAbilitySubsystem::Get(GetWorld());
+	if (!Subsystem)
+	{
+		return;
+	}
+
+	// The owning client applies effects the server applies too, so their cues will also arrive in the server's batch
+	if (GetIsReplicated() && GetOwnerRole() == ROLE_AutonomousProxy)
+	{
+		const double Now = GetWorld()->GetTimeSeconds();
+		PruneLocallyShownCues(Now);
+		for (const FNoctCue& Cue : Cues)
+		{
+			LocallyShownCues.Add({Cue.CueTag, Cue.Event, Now});
+		}
+	}
+
+	Subsystem->HandleCues(GetOwner(), Cues);
+}
+
+void UNoctAbilityComponent::MulticastCues_Implementation(const TArray<FNoctCue>& Cues)
+{
+	UNoctAbilitySubsystem* Subsystem = UNoctAbilitySubsystem::Get(GetWorld());
+	if (!Subsystem)
+	{
+		return;
+	}
+
+	if (LocallyShownCues.IsEmpty())
+	{
+		Subsystem->HandleCues(GetOwner(), Cues);
+		return;
+	}
+
+	// Skip the cues this client has already shown, each locally shown cue accounts for one from the server
+	PruneLocallyShownCues(GetWorld()->GetTimeSeconds());
+
+	TArray<FNoctCue, TInlineAllocator<8>> NewCues;
+	for (const FNoctCue& Cue : Cues)
+	{
+		const int32 ShownIndex = LocallyShownCues.IndexOfByPredicate([&Cue](const FNoctLocallyShownCue& Shown)
+		{
+			return Shown.CueTag == Cue.CueTag && Shown.Event == Cue.Event;
+		});
+
+		if (ShownIndex != INDEX_NONE)
+		{
+			LocallyShownCues.RemoveAt(ShownIndex, 1, EAllowShrinking::No);
+		}
+		else
+		{
+			NewCues.Add(Cue);
+		}
+	}
+
+	if (NewCues.Num() > 0)
+	{
+		Subsystem->HandleCues(GetOwner(), NewCues);
+	}
+}
+
+bool UNoctAbilityComponent::IsMulticastingCues() const
+{
+	return GetIsReplicated() && GetOwner() && GetOwner()->HasAuthority() && GetNetMode() != NM_Standalone;
+}
+
+void UNoctAbilityComponent::PruneLocallyShownCues(const double Now)
+{
+	// Longest the server's copy of a locally shown cue is waited for, past this a cue with the same tag is a new one
+	constexpr double LocallyShownCueLifetime = 1.0;
+
+	// Shown in order, so the expired ones are at the front
+	const int32 NumExpired = Algo::LowerBoundBy(LocallyShownCues, Now - LocallyShownCueLifetime, &FNoctLocallyShownCue::ShownTime);
+	LocallyShownCues.RemoveAt(0, NumExpired, EAllowShrinking::No);
+}
+
+void UNoctAbilityComponent::ClientRejectPrediction_Implementation(const FNoctPredictionKey PredictionKey)
+{
+	const int32 Index = PendingPredictions.IndexOfByPredicate([PredictionKey](const FNoctPredictionRecord& Record)
+	{
+		return Record.Key == PredictionKey;
+	});
+
+	if (Index != INDEX_NONE)
+	{
+		const FNoctPredictionRecord Record = MoveTemp(PendingPredictions[Index]);
+		PendingPredictions.RemoveAt(Index);
+		RollbackPrediction(Record);
+	}
+}
+
+void UNoctAbilityComponent::RollbackPrediction(const FNoctPredictionRecord& Record)
+{
+	TGuardValue<bool> RollbackScope(bRollingBackPrediction, true);
+
+	if (const auto Ability = FindAbilityByTag(Record.AbilityTag))
+	{
+		FNoctAbilityBindingScope BindingScope(this, Ability);
+		if (Ability->bIsActive)
+		{
+			// The cost is put back from the record below, don't refund it a second time
+			Ability->CommittedCosts.Reset();
+			Ability->CancelAbility();
+		}
+		Ability->OnAbilityPredictionRejected();
+	}
+
+	for (const FGameplayTag& Tag : Record.AddedActiveTags)
+	{
+		RemoveActiveAbilityTag(Tag);
+	}
+
+	// Cancelling may have started the cooldown again, so this comes after
+	const double Now = GetCooldownTime();
+	for (const FNoctPredictedCooldown& Cooldown : Record.Cooldowns)
+	{
+		Cooldowns.Restore(Cooldown.Entry, Now);
+	}
+
+	for (const FNoctPredictedAttributeDelta& AttributeDelta : Record.AttributeDeltas)
+	{
+		if (FNoctAttribute* Attribute = FindAttribute(AttributeDelta.AttributeTag))
+		{
+			Attribute->BaseValue -= AttributeDelta.Delta;
+			Attribute->CurrentValue = Attribute->CalculateValue();
+		}
+	}
+
+	UpdateTickEnabled();
+}
+
+FNoctAbilityTaskHandle UNoctAbilityComponent::StartAbilityTask(const FNoctAbilityTask& Task)
+{
+	FNoctAbilityTask NewTask = Task;
+	NewTask.StartTime = GetWorld()->GetTimeSeconds();
+
+	switch (NewTask.Type)
+	{
+	case ENoctAbilityTaskType::WaitAttributeChange:
+		if (const FNoctAttribute* Attribute = Attributes.Find(NewTask.Tag))
+		{
+			NewTask.StartValue = Attribute->CurrentValue;
+		}
+		break;
+	case ENoctAbilityTaskType::WaitEffectRemoved:
+	case ENoctAbilityTaskType::WaitTagAdded:
+		{
+			float Value;
+			NewTask.bConditionMet = IsAbilityTaskConditionMet(NewTask, NewTask.StartTime, Value);
+		}
+		break;
+	default:
+		break;
+	}
+
+	const FNoctAbilityTaskHandle Handle = AbilityTasks.Add(NewTask);
+	UpdateTickEnabled();
+	return Handle;
+}
+
+void UNoctAbilityComponent::CancelAbilityTask(const FNoctAbilityTaskHandle Handle)
+{
+	AbilityTasks.Remove(Handle);
+}
+
+void UNoctAbilityComponent::CancelAbilityTasks(const FGameplayTag AbilityTag)
+{
+	if (AbilityTasks.Num() > 0)
+	{
+		AbilityTasks.RemoveAll(AbilityTag);
+	}
+}
+
+void UNoctAbilityComponent::ProcessAbilityTasks(const double Now)
+{
+	if (!AbilityTasks.HasPolledTasks())
+	{
+		return;
+	}
+
+	// Tasks started by the completions below wait for the next tick
+	const uint32 FirstNewSerial = AbilityTasks.GetNextSerial();
+	for (int32 Index = 0; Index < AbilityTasks.Tasks.Num(); ++Index)
+	{
+		const FNoctAbilityTask& Task = AbilityTasks.Tasks[Index];
+		float Value = 0.0f;
+		if (Task.IsActive() && Task.Serial < FirstNewSerial && Task.IsPolled() && IsAbilityTaskConditionMet(Task, Now, Value))
+		{
+			CompleteAbilityTask(Index, Value);
+		}
+	}
+}
+
+void UNoctAbilityComponent::NotifyAbilityTasks(const ENoctAbilityTaskType Type, const FGameplayTag Tag, const FGameplayTag AbilityTag)
+{
+	if (AbilityTasks.Num() == 0)
+	{
+		return;
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const uint32 FirstNewSerial = AbilityTasks.GetNextSerial();
+	for (int32 Index = 0; Index < AbilityTasks.Tasks.Num(); ++Index)
+	{
+		const FNoctAbilityTask& Task = AbilityTasks.Tasks[Index];
+		if (!Task.IsActive() || Task.Serial >= FirstNewSerial || Task.Type != Type
+			|| (AbilityTag.IsValid() && Task.AbilityTag != AbilityTag)
+			|| (Task.Tag.IsValid() && !Tag.MatchesTag(Task.Tag)))
+		{
+			continue;
+		}
+
+		float Value = static_cast<float>(Now - Task.StartTime);
+
+		// Another effect under the same tag can still be applied
+		if (Type == ENoctAbilityTaskType::WaitEffectRemoved && !IsAbilityTaskConditionMet(Task, Now, Value))
+		{
+			continue;
+		}
+
+		CompleteAbilityTask(Index, Value);
+	}
+}
+
+void UNoctAbilityComponent::CompleteAbilityTask(const int32 Index, const float Value)
+{
+	const FNoctAbilityTaskHandle Handle = AbilityTasks.GetHandle(Index);
+	const ENoctAbilityTaskType Type = AbilityTasks.Tasks[Index].Type;
+	const FGameplayTag AbilityTag = AbilityTasks.Tasks[Index].AbilityTag;
+
+	// Freed first, the ability may start another task straight away
+	AbilityTasks.Remove(Handle);
+
+	if (const auto Ability = FindAbilityByTag(AbilityTag))
+	{
+		FNoctAbilityBindingScope BindingScope(this, Ability);
+		Ability->NativeAbilityTaskCompleted(Handle, Type, Value);
+	}
+}
+
+bool UNoctAbilityComponent::IsAbilityTaskConditionMet(const FNoctAbilityTask& Task, const double Now, float& OutValue) const
+{
+	OutValue = static_cast<float>(Now - Task.StartTime);
+
+	switch (Task.Type)
+	{
+	case ENoctAbilityTaskType::WaitDelay:
+		return Now >= Task.StartTime + Task.Duration;
+	case ENoctAbilityTaskType::WaitAttributeChange:
+		if (const FNoctAttribute* Attribute = Attributes.Find(Task.Tag))
+		{
+			OutValue = Attribute->CurrentValue;
+			switch (Task.Threshold)
+			{
+			case ENoctAttributeThreshold::AnyChange:
+				return OutValue != Task.StartValue;
+			case ENoctAttributeThreshold::AtOrAbove:
+				return OutValue >= Task.ThresholdValue;
+			case ENoctAttributeThreshold::AtOrBelow:
+				return OutValue <= Task.ThresholdValue;
+			}
+		}
+		return false;
+	case ENoctAbilityTaskType::WaitEffectRemoved:
+		return !ActiveEffects.ContainsByPredicate([&Task](const UNoctEffect* Effect)
+		{
+			return Effect->bIsActiveAndApplied && Effect->EffectTag.MatchesTag(Task.Tag);
+		});
+	case ENoctAbilityTaskType::WaitTagAdded:
+		return ActiveAbilityTags.HasTag(Task.Tag);
+	default:
+		return Task.bConditionMet;
+	}
+}
+
+void UNoctAbilityComponent::CancelAbilityByTag(const FGameplayTag GameplayTag)
+{
+	if (const auto Ability = FindAbilityByTag(GameplayTag))
+	{
+		FNoctAbilityBindingScope BindingScope(this, Ability);
+		if(Ability->bIsActive)
+			Ability->CancelAbility();
+	}
+}
+
+void UNoctAbilityComponent::FinishAbilityByTag(const FGameplayTag GameplayTag)
+{
+	if (const auto Ability = FindAbilityByTag(GameplayTag))
+	{
+		FNoctAbilityBindingScope BindingScope(this, Ability);
+		if(Ability->bIsActive)
+			Ability->FinishAbility();
+	}
+}
+
+void UNoctAbilityComponent::RemoveAbilityByTag(const FGameplayTag GameplayTag)
+{
+	if (const auto Ability = FindAbilityByTag(GameplayTag))
+	{
+		{
+			FNoctAbilityBindingScope BindingScope(this, Ability);
+			Ability->AbilityRemovedFromOwner();
+		}
+		CancelAbilityTasks(Ability->AbilityTag);
+		UnindexAbility(Ability);
+		Abilities.Remove(Ability);
+		SetUnlockedTag(Ability->AbilityTag, false);
+		PredictedActiveAbilityTags.RemoveTag(Ability->AbilityTag);
+
+		if (!Ability->IsInstanced())
+		{
+			SharedAbilityStates.RemoveAll([Ability](const FNoctAbilityState& State)
+			{
+				return State.AbilityTag == Ability->AbilityTag;
+			});
+		}
+
+		ReleaseAbility(Ability);
+	}
+	else
+	{
+		const int32 PendingIndex = PendingAbilities.IndexOfByPredicate([GameplayTag](const FNoctPendingAbility& PendingAbility)
+		{
+			return PendingAbility.AbilityTag == GameplayTag;
+		});
+		
+		if (PendingIndex != INDEX_NONE)
+		{
+			UnregisterAbilityInput(GameplayTag);
+			PendingAbilities.RemoveAtSwap(PendingIndex);
+			SetUnlockedTag(GameplayTag, false);
+		}
+	}
 }
 
-// Called when the game starts
-void UNoctAbilityComponent::BeginPlay()
+const FGameplayTagContainer& UNoctAbilityComponent::GetAbilitiesOnCooldown() const
 {
-	Super::BeginPlay();
+	return Cooldowns.ActiveTags;
+}
 
-	for (const auto Ability : DefaultAbilities)
+bool UNoctAbilityComponent::IsAbilityOnCooldown(const FGameplayTag GameplayTag)
+{
+	const double Now = GetCooldownTime();
+	if (Cooldowns.IsOnCooldown(GameplayTag, Now))
 	{
-		UnlockAbilityByClass(Ability);
+		return true;
 	}
+
+	// Blocked by its group just the same as by its own cooldown
+	const UNoctAbility* Ability = FindAbilitySettingsByTag(GameplayTag);
+	return Ability && Ability->CooldownGroupTag.IsValid() && Cooldowns.IsOnCooldown(Ability->CooldownGroupTag, Now);
 }
 
-bool UNoctAbilityComponent::HasAbilityUnlocked(const FGameplayTag TagToCheck) const
+void UNoctAbilityComponent::StartCooldown(const FGameplayTag CooldownTag, const float Duration)
 {
-	return UnlockedAbilityTags.HasTagExact(TagToCheck);
+	if (CurrentPrediction)
+	{
+		CurrentPrediction->RecordCooldown(CooldownTag, Cooldowns);
+	}
+	
+	if (Duration > 0)
+	{
+		Cooldowns.Start(CooldownTag, GetCooldownTime(), Duration);
+	}
+	else
+	{
+		Cooldowns.Clear(CooldownTag);
+	}
+
+	CooldownChanged(CooldownTag);
 }
 
-bool UNoctAbilityComponent::HasAbilityActive(const FGameplayTag TagToCheck) const
+void UNoctAbilityComponent::StartGroupCooldown(const FGameplayTag CooldownGroupTag, const float Duration)
 {
-	return ActiveAbilityTags.HasTagExact(TagToCheck);
+	StartCooldown(CooldownGroupTag, Duration);
 }
 
-bool UNoctAbilityComponent::HasAbilityBlocked(const FGameplayTag TagToCheck) const
+void UNoctAbilityComponent::SpendCharge(const FGameplayTag CooldownTag, const int32 MaxCharges, const float RechargeTime, const ENoctChargeRechargePolicy RechargePolicy)
 {
-	return BlockedAbilityTags.HasTagExact(TagToCheck);
+	if (CurrentPrediction)
+	{
+		CurrentPrediction->RecordCooldown(CooldownTag, Cooldowns);
+	}
+
+	Cooldowns.SpendCharge(CooldownTag, GetCooldownTime(), MaxCharges, RechargeTime, RechargePolicy);
+
+	CooldownChanged(CooldownTag);
 }
 
-bool UNoctAbilityComponent::UnlockAbilityByTag(const FGameplayTag AbilityTag)
+void UNoctAbilityComponent::CooldownChanged(const FGameplayTag CooldownTag)
 {
-	if(UnlockedAbilityTags.HasTagExact(AbilityTag))
+	if (IsReplicatingState())
 	{
-		return false;
+		ReplicatedCooldowns.SetCooldown(CooldownTag, Cooldowns.Find(CooldownTag));
 	}
 
-	UnlockedAbilityTags.AddTag(AbilityTag);
-	return true;
+	UpdateTickEnabled();
 }
 
-bool UNoctAbilityComponent::UnlockAbilityByClass(const TSubclassOf<UNoctAbility> AbilityClass)
+int32 UNoctAbilityComponent::GetAbilityCharges(const FGameplayTag AbilityTag) const
 {
-	bool bValidAbility = false;
-	if (AbilityClass)
+	const double Now = GetCooldownTime();
+	if (const FNoctCooldownEntry* Entry = Cooldowns.Find(AbilityTag); Entry && Entry->MaxCharges > 0)
 	{
-		if (auto DefaultAbility = AbilityClass->GetDefaultObject<UNoctAbility>())
-		{
-			bValidAbility = ! UnlockedAbilityTags.HasTagExact(DefaultAbility->AbilityTag);
-		}
+		return Entry->GetCharges(Now);
 	}
 
-	if (bValidAbility)
+	// Nothing spent yet, or no charges at all
+	if (Cooldowns.IsOnCooldown(AbilityTag, Now))
 	{
-		if (auto NewAbility = NewObject<UNoctAbility>(this, AbilityClass))
-		{
-			Abilities.Add(NewAbility);
-			NewAbility->AbilityAddedToOwner();
-			UnlockedAbilityTags.AddTag(NewAbility->AbilityTag);
-		}
+		return 0;
 	}
 
-	return bValidAbility;
+	const UNoctAbility* Ability = FindAbilitySettingsByTag(AbilityTag);
+	return Ability ? Ability->MaxCharges : 0;
 }
 
-
-void UNoctAbilityComponent::ActivateAbilityByTag(const FGameplayTag AbilityTag)
+const UNoctAbility* UNoctAbilityComponent::FindAbilitySettingsByTag(const FGameplayTag AbilityTag) const
 {
-	for (auto& Ability : Abilities)
+	if (const UNoctAbility* Ability = FindAbilityByTag(AbilityTag))
 	{
-		if(Ability->AbilityTag.MatchesTagExact(AbilityTag) && Ability->CanActivateAbility())
-			Ability->ActivateAbility();
+		return Ability;
 	}
+
+	const FNoctPendingAbility* PendingAbility = PendingAbilities.FindByPredicate([AbilityTag](const FNoctPendingAbility& Entry)
+	{
+		return Entry.AbilityTag == AbilityTag;
+	});
+	return PendingAbility ? PendingAbility->AbilityClass.GetDefaultObject() : nullptr;
 }
 
-void UNoctAbilityComponent::CancelAbilityByTag(const FGameplayTag GameplayTag)
+float UNoctAbilityComponent::GetNextChargeTimeRemaining(const FGameplayTag AbilityTag) const
 {
-	for (auto& Ability : Abilities)
+	const FNoctCooldownEntry* Entry = Cooldowns.Find(AbilityTag);
+	if (!Entry || Entry->MaxCharges == 0)
 	{
-		if(Ability->AbilityTag.MatchesTagExact(GameplayTag))
-		{
-			if(Ability->bIsActive)
-				Ability->CancelAbility();
-		}
+		return 0.0f;
 	}
+
+	const double Now = GetCooldownTime();
+	const double NextChargeTime = Entry->GetNextChargeTime(Now);
+	return NextChargeTime > 0.0 ? static_cast<float>(NextChargeTime - Now) : 0.0f;
 }
 
-void UNoctAbilityComponent::FinishAbilityByTag(const FGameplayTag GameplayTag)
+void UNoctAbilityComponent::ProcessExpiredCooldowns(const double Now)
 {
-	for (auto& Ability : Abilities)
+	if (!Cooldowns.HasPendingExpiry())
 	{
-		if(Ability->AbilityTag.MatchesTagExact(GameplayTag))
-		{
-			if(Ability->bIsActive)
-				Ability->FinishAbility();
-		}
+		return;
 	}
-}
 
-void UNoctAbilityComponent::RemoveAbilityByTag(const FGameplayTag GameplayTag)
-{
-	for (auto& Ability : Abilities)
+	TArray<FGameplayTag, TInlineAllocator<8>> ExpiredTags;
+	Cooldowns.CollectExpired(Now, ExpiredTags);
+
+	if (ExpiredTags.IsEmpty())
+	{
+		return;
+	}
+
+	FGameplayTagContainer FinishedCooldownTags;
+	for (const FGameplayTag& Tag : ExpiredTags)
+	{
+		FinishedCooldownTags.AddTagFast(Tag);
+	}
+
+	// The cooldowns have already ended, only telling anyone about it can wait
+	if (SignificanceTier != ENoctSignificanceTier::High)
 	{
-		if(Ability->AbilityTag.MatchesTagExact(GameplayTag))
+		if (UNoctAbilitySubsystem* Subsystem = UNoctAbilitySubsystem::Get(GetWorld()))
 		{
-			Ability->AbilityRemovedFromOwner();
-			Abilities.Remove(Ability);
-			UnlockedAbilityTags.RemoveTag(Ability->AbilityTag);
+			Subsystem->DeferCooldownNotifications(this, FinishedCooldownTags);
+			return;
 		}
 	}
+
+	NotifyCooldownsFinished(FinishedCooldownTags);
 }
 
-FGameplayTagContainer UNoctAbilityComponent::GetAbilitiesOnCooldown()
+void UNoctAbilityComponent::NotifyCooldownsFinished(const FGameplayTagContainer& FinishedCooldownTags)
 {
-	FGameplayTagContainer Tags;
-	
-	for (auto& Ability : Abilities)
+	// An ability is only ready again once neither its own cooldown nor its group's is running,
+	// whichever of the two ended last is the one that finishes it
+	const double Now = GetCooldownTime();
+	TArray<UNoctAbility*, TInlineAllocator<8>> FinishedAbilities;
+	for (const FGameplayTag& Tag : FinishedCooldownTags)
 	{
-		if(Ability->CooldownActive())
+		if (UNoctAbility* Ability = FindAbilityByTag(Tag))
 		{
-			Tags.AddTagFast(Ability->AbilityTag);
+			if (!Ability->CooldownGroupTag.IsValid() || !Cooldowns.IsOnCooldown(Ability->CooldownGroupTag, Now))
+			{
+				FinishedAbilities.AddUnique(Ability);
+			}
+		}
+
+		if (const TArray<UNoctAbility*>* GroupAbilities = AbilitiesByCooldownGroup.Find(Tag))
+		{
+			for (UNoctAbility* Ability : *GroupAbilities)
+			{
+				if (!Cooldowns.IsOnCooldown(Ability->AbilityTag, Now))
+				{
+					FinishedAbilities.AddUnique(Ability);
+				}
+			}
 		}
 	}
-	
-	return Tags;
+
+	for (UNoctAbility* Ability : FinishedAbilities)
+	{
+		FNoctAbilityBindingScope BindingScope(this, Ability);
+		Ability->FinishCooldown();
+	}
+
+	OnCooldownsFinished.Broadcast(FinishedCooldownTags);
 }
 
-bool UNoctAbilityComponent::IsAbilityOnCooldown(const FGameplayTag GameplayTag)
+double UNoctAbilityComponent::GetCooldownTime() const
 {
-	for (auto& Ability : Abilities)
+	// Server time only when end times are replicated, so they mean the same thing on every machine.
+	// Otherwise world time, like effects and tasks, without following the game state's re-synced offset.
+	if (bReplicateAbilityState && GetIsReplicated() && GetNetMode() != NM_Standalone)
 	{
-		if(GameplayTag == Ability->AbilityTag && Ability->CooldownActive())
+		if (const AGameStateBase* GameState = GetWorld()->GetGameState())
 		{
-			return true;
+			return GameState->GetServerWorldTimeSeconds();
 		}
 	}
-
-	return false;
+	return GetWorld()->GetTimeSeconds();
 }
 
 bool UNoctAbilityComponent::BlockAbilities(const FGameplayTagContainer AbilityTag)
@@ -153,36 +1710,83 @@ bool UNoctAbilityComponent::BlockAbilities(const FGameplayTagContainer AbilityTa
 		return false;
 	}
 
-	BlockedAbilityTags.AppendTags(AbilityTag);
+	for (const FGameplayTag& Tag : AbilityTag)
+	{
+		SetBlockedTag(Tag, true);
+	}
 	return true;
 }
 
 void UNoctAbilityComponent::UnblockAbility(const FGameplayTag AbilityTag)
 {
-	if(HasEffectBlocked(AbilityTag))
+	SetBlockedTag(AbilityTag, false);
+}
+
+void UNoctAbilityComponent::UnblockAbilities(const FGameplayTagContainer AbilityTags)
+{
+	for (const FGameplayTag& Tag : AbilityTags)
 	{
-		BlockedAbilityTags.RemoveTag(AbilityTag);
+		SetBlockedTag(Tag, false);
 	}
 }
 
-void UNoctAbilityComponent::UnblockAbilities(const FGameplayTagContainer AbilityTags)
+void UNoctAbilityComponent::CancelAbilities(const FGameplayTagContainer& AbilityTag)
 {
-	if(BlockedAbilityTags.HasAnyExact(AbilityTags))
+	// Nothing under any of the tags is active, which is the common case for effects applied to many actors at once
+	if (AbilityTag.IsEmpty() || !ActiveAbilityTags.HasAny(AbilityTag))
+	{
+		return;
+	}
+
+	// Gather first, cancelling can run Blueprint code that adds or removes abilities
+	TArray<UNoctAbility*, TInlineAllocator<16>> AbilitiesToCancel;
+	
+	for (const FGameplayTag& Tag : AbilityTag)
+	{
+		if (const TArray<UNoctAbility*>* AbilitiesUnderTag = AbilitiesByParentTag.Find(Tag))
+		{
+			for (UNoctAbility* Ability : *AbilitiesUnderTag)
+			{
+				if(IsAbilityActive(Ability))
+					AbilitiesToCancel.AddUnique(Ability);
+			}
+		}
+	}
+
+	for (UNoctAbility* Ability : AbilitiesToCancel)
 	{
-		BlockedAbilityTags.RemoveTags(AbilityTags);
+		FNoctAbilityBindingScope BindingScope(this, Ability);
+		if(Ability->bIsActive)
+			Ability->CancelAbility();
 	}
 }
 
-void UNoctAbilityComponent::CancelAbilities(const FGameplayTagContainer AbilityTag)
+void UNoctAbilityComponent::CancelAbilitiesByQuery(const FGameplayTagQuery& Query)
 {
-	for (const auto& Ability : Abilities)
+	if (Query.IsEmpty() || ActiveAbilityTags.IsEmpty())
+	{
+		return;
+	}
+
+	// Only active abilities can be cancelled, and ActiveAbilityTags holds exactly their tags
+	TArray<UNoctAbility*, TInlineAllocator<16>> AbilitiesToCancel;
+	for (const FGameplayTag& Tag : ActiveAbilityTags)
 	{
-		if(Ability->AbilityTag.MatchesAny(AbilityTag))
+		if (Query.Matches(Tag.GetSingleTagContainer()))
 		{
-			if(Ability->bIsActive)
-				Ability->CancelAbility();
+			if (UNoctAbility* Ability = FindAbilityByTag(Tag))
+			{
+				AbilitiesToCancel.AddUnique(Ability);
+			}
 		}
 	}
+
+	for (UNoctAbility* Ability : AbilitiesToCancel)
+	{
+		FNoctAbilityBindingScope BindingScope(this, Ability);
+		if(Ability->bIsActive)
+			Ability->CancelAbility();
+	}
 }
 
 bool UNoctAbilityComponent::HasEffectActive(const FGameplayTag TagToCheck) const
@@ -197,61 +1801,278 @@ bool UNoctAbilityComponent::HasEffectBlocked(const FGameplayTag TagToCheck) cons
 
 bool UNoctAbilityComponent::AddEffectByClass(const TSubclassOf<UNoctEffect> EffectToAdd)
 {
-	if(ActiveEffectsTags.HasTagExact(EffectToAdd.GetDefaultObject()->EffectTag))
+	return AddEffectBySpec(UNoctEffect::MakeEffectSpec(EffectToAdd));
+}
+
+bool UNoctAbilityComponent::AddEffectBySpec(const FNoctEffectSpec& Spec)
+{
+	if(!Spec.IsValid() || !CanApplyEffect(Spec))
 	{
 		return false;
 	}
 
-	const auto NewEffect = NewObject<UNoctEffect>(this, EffectToAdd);
+	return ApplyEffectInternal(Spec);
+}
+
+bool UNoctAbilityComponent::ApplyEffectInternal(const FNoctEffectSpec& Spec)
+{
+	bool bFromPool = false;
+	const auto NewEffect = AcquireEffect(Spec.EffectClass, &bFromPool);
 
-	if(NewEffect)
+	if(!NewEffect)
 	{
-		ActiveEffects.Add(NewEffect);
+		return false;
 	}
 
+	NewEffect->InitializeFromSpec(Spec);
+	ActiveEffects.Add(NewEffect);
+
+	INC_DWORD_STAT(STAT_NoctEffectsApplied);
+	INC_DWORD_STAT(STAT_NoctActiveEffects);
+	NOCT_TRACE_EFFECT_APPLIED(NewEffect, this, bFromPool);
+	NOCT_RECORD(RecordEffect(ENoctRecordedEventType::EffectApplied, this, NewEffect, Spec.Level));
+	NOCT_RECORD_NESTED_SCOPE();
+
 	NewEffect->EffectApplied();
 	
-	return NewEffect != nullptr;	
+	return true;
+}
+
+bool UNoctAbilityComponent::ResumeEffect(const FNoctEffectSpec& Spec, const FNoctEffectTimeline& Timeline)
+{
+	if(!Spec.IsValid() || !CanApplyEffect(Spec))
+	{
+		return false;
+	}
+
+	bool bFromPool = false;
+	const auto NewEffect = AcquireEffect(Spec.EffectClass, &bFromPool);
+
+	if(!NewEffect || NewEffect->bPermanent)
+	{
+		ReleaseEffect(NewEffect);
+		return false;
+	}
+
+	NewEffect->InitializeFromSpec(Spec);
+	ActiveEffects.Add(NewEffect);
+
+	INC_DWORD_STAT(STAT_NoctActiveEffects);
+	NOCT_TRACE_EFFECT_APPLIED(NewEffect, this, bFromPool);
+
+	NewEffect->EffectResumed(Timeline);
+
+	return true;
+}
+
+bool UNoctAbilityComponent::CanApplyEffect(const FNoctEffectSpec& Spec) const
+{
+	return !BlockedEffectsTags.HasTagExact(Spec.EffectTag) && !ActiveEffectsTags.HasTagExact(Spec.EffectTag);
+}
+
+int32 UNoctAbilityComponent::ApplyEffectSpecToTargets(const FNoctEffectSpec& Spec, const TArray<UNoctAbilityComponent*>& Targets)
+{
+	if(!Spec.IsValid())
+	{
+		return 0;
+	}
+
+	// Filter everything up front so effects applied to earlier targets can't change who is eligible
+	TArray<UNoctAbilityComponent*, TInlineAllocator<64>> ValidTargets;
+	ValidTargets.Reserve(Targets.Num());
+	
+	for (UNoctAbilityComponent* Target : Targets)
+	{
+		if(IsValid(Target) && Target->CanApplyEffect(Spec))
+		{
+			ValidTargets.Add(Target);
+		}
+	}
+
+	int32 NumApplied = 0;
+	for (UNoctAbilityComponent* Target : ValidTargets)
+	{
+		if (Target->ApplyEffectInternal(Spec))
+		{
+			++NumApplied;
+		}
+	}
+
+	return NumApplied;
+}
+
+int32 UNoctAbilityComponent::ApplyEffectToTargets(const TSubclassOf<UNoctEffect> EffectToAdd, const TArray<UNoctAbilityComponent*>& Targets, const int32 Level)
+{
+	return ApplyEffectSpecToTargets(UNoctEffect::MakeEffectSpec(EffectToAdd, Level), Targets);
 }
 
-void UNoctAbilityComponent::RemoveEffect(UNoctEffect* NoctEffect)
+void UNoctAbilityComponent::RemoveEffect(UNoctEffect* NoctEffect, const bool bExpired)
 {
+	if(NoctEffect->bIsActiveAndApplied)
+	{
+		NOCT_RECORD(RecordEffect(ENoctRecordedEventType::EffectRemoved, this, NoctEffect, bExpired ? 1 : 0));
+	}
+	NOCT_RECORD_NESTED_SCOPE();
+
 	if(NoctEffect->bIsActiveAndApplied)
 	{
 		NoctEffect->EffectRemoved(); 
 	}
 	
-	ActiveEffects.Remove(NoctEffect);
+	if(ActiveEffects.Remove(NoctEffect) > 0)
+	{
+		INC_DWORD_STAT(STAT_NoctEffectsRemoved);
+		DEC_DWORD_STAT(STAT_NoctActiveEffects);
+		if(bExpired)
+		{
+			INC_DWORD_STAT(STAT_NoctEffectsExpired);
+		}
+		NOCT_TRACE_EFFECT_REMOVED(NoctEffect, this, bExpired);
+
+		NotifyAbilityTasks(ENoctAbilityTaskType::WaitEffectRemoved, NoctEffect->EffectTag);
+	}
+
+	ReleaseEffect(NoctEffect);
 }
 
-void UNoctAbilityComponent::GetCooldownRemainingForAbility(const FGameplayTag AbilityTag, float& TimeRemaining, float& CooldownDuration)
+void UNoctAbilityComponent::TimedEffectAdded()
+{
+	UpdateTickEnabled();
+}
+
+void UNoctAbilityComponent::AdvanceEffects(const double Now)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NoctAdvanceEffects);
+
+	// Effects can remove themselves, or others, while advancing. Advancing is idempotent for a given time,
+	// so walking backwards and tolerating shifted indices is enough to visit each one at least once.
+	for (int32 Index = ActiveEffects.Num() - 1; Index >= 0; --Index)
+	{
+		if (ActiveEffects.IsValidIndex(Index))
+		{
+			ActiveEffects[Index]->AdvanceTimeline(Now);
+		}
+	}
+}
+
+bool UNoctAbilityComponent::HasTimedWork() const
+{
+	if (Cooldowns.HasPendingExpiry() || !PendingActivations.IsEmpty() || AbilityTasks.HasPolledTasks())
+	{
+		return true;
+	}
+	
+	for (const auto& Effect : ActiveEffects)
+	{
+		if (Effect->IsTimed())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UNoctAbilityComponent::UpdateTickEnabled()
+{
+	const bool bShouldTick = HasTimedWork();
+	if (bShouldTick != IsComponentTickEnabled())
+	{
+		SetComponentTickEnabled(bShouldTick);
+	}
+}
+
+UNoctEffect* UNoctAbilityComponent::AcquireEffect(const TSubclassOf<UNoctEffect> EffectClass, bool* bOutFromPool)
 {
-	if(IsAbilityOnCooldown(AbilityTag))
+	if (FNoctEffectPool* Pool = EffectPool.Find(EffectClass))
 	{
-		for (const auto& Ability : Abilities)
+		if (Pool->FreeEffects.Num() > 0)
 		{
-			if(Ability->AbilityTag.MatchesTagExact(AbilityTag))
+			INC_DWORD_STAT(STAT_NoctEffectPoolHits);
+			DEC_DWORD_STAT(STAT_NoctPooledEffects);
+			if (bOutFromPool)
 			{
-				TimeRemaining = GetWorld()->GetTimerManager().GetTimerRemaining(Ability->CooldownTimer);
-				CooldownDuration = Ability->BaseCooldown;
-				return;
+				*bOutFromPool = true;
 			}
+			return Pool->FreeEffects.Pop(EAllowShrinking::No);
 		}
 	}
+
+	INC_DWORD_STAT(STAT_NoctEffectPoolMisses);
+	const auto NewEffect = NewObject<UNoctEffect>(this, EffectClass);
+	NewEffect->OwningAbilityComponent = this;
+	return NewEffect;
 }
 
-void UNoctAbilityComponent::SetCooldownRemainingForAbility(const FGameplayTag AbilityTag, const float NewTime)
+void UNoctAbilityComponent::ReleaseEffect(UNoctEffect* NoctEffect)
 {
-	for (const auto& Ability : Abilities)
+	if (!NoctEffect || NoctEffect->GetOuter() != this)
+	{
+		return;
+	}
+
+	FNoctEffectPool& Pool = EffectPool.FindOrAdd(NoctEffect->GetClass());
+	if (Pool.FreeEffects.Num() < MaxPooledEffectsPerClass)
+	{
+		NoctEffect->ResetForReuse();
+		Pool.FreeEffects.Add(NoctEffect);
+
+		INC_DWORD_STAT(STAT_NoctPooledEffects);
+		NOCT_TRACE_EFFECT_POOL(this, Pool.FreeEffects.Num());
+	}
+}
+
+void UNoctAbilityComponent::GetCooldownRemainingForAbility(const FGameplayTag AbilityTag, float& TimeRemaining, float& CooldownDuration)
+{
+	TimeRemaining = 0.0f;
+	CooldownDuration = 0.0f;
+
+	const double Now = GetCooldownTime();
+	if(Cooldowns.IsOnCooldown(AbilityTag, Now))
+	{
+		TimeRemaining = Cooldowns.GetRemaining(AbilityTag, Now);
+		CooldownDuration = Cooldowns.Find(AbilityTag)->Duration;
+	}
+
+	// A longer group cooldown is what actually keeps the ability from activating
+	const UNoctAbility* Ability = FindAbilitySettingsByTag(AbilityTag);
+	if(Ability && Ability->CooldownGroupTag.IsValid() && Cooldowns.IsOnCooldown(Ability->CooldownGroupTag, Now))
 	{
-		if (Ability->AbilityTag.MatchesTagExact(AbilityTag))
+		const float GroupRemaining = Cooldowns.GetRemaining(Ability->CooldownGroupTag, Now);
+		if(GroupRemaining > TimeRemaining)
 		{
-			Ability->TriggerCooldown(NewTime);
-			return;
+			TimeRemaining = GroupRemaining;
+			CooldownDuration = Cooldowns.Find(Ability->CooldownGroupTag)->Duration;
 		}
 	}
 }
 
+void UNoctAbilityComponent::SetCooldownRemainingForAbility(const FGameplayTag AbilityTag, const float NewTime)
+{
+	const UNoctAbility* Ability = FindOrCreateAbilityByTag(AbilityTag);
+	if (!Ability)
+	{
+		return;
+	}
+
+	const float Time = NewTime > 0 ? NewTime : Ability->GetScaledCooldown();
+	if (!Ability->HasCharges())
+	{
+		StartCooldown(AbilityTag, Time);
+		return;
+	}
+
+	// Spending a charge would use one up, so only move when the ability is usable again and leave the charges recharging as they were
+	if (CurrentPrediction)
+	{
+		CurrentPrediction->RecordCooldown(AbilityTag, Cooldowns);
+	}
+
+	const double Now = GetCooldownTime();
+	Cooldowns.SetEndTime(AbilityTag, Now, Now + Time);
+
+	CooldownChanged(AbilityTag);
+}
+
 void UNoctAbilityComponent::AbilityCooldownFinished(UNoctAbility* NoctAbility)
 {
 	
@@ -295,16 +2116,41 @@ bool UNoctAbilityComponent::AddAttribute(const FGameplayTag AttributeTag, FNoctA
 	{
 		Attributes.Add(AttributeTag, Attribute);
 		AttributeTags.AddTagFast(AttributeTag);
+		NOCT_RECORD(RecordAttributeAdded(this, AttributeTag, Attribute));
 		return true;
 	}
 	return false;
 }
 
+int32 UNoctAbilityComponent::AddAttributeModifier(const FGameplayTag AttributeTag, const FNoctAttributeModifier& Modifier)
+{
+	FNoctAttribute* Attribute = FindAttribute(AttributeTag);
+	if (!Attribute)
+	{
+		return 0;
+	}
+
+	const int32 Handle = Attribute->AddModifier(Modifier);
+	NOCT_RECORD(RecordModifierAdded(this, AttributeTag, Handle, Modifier));
+	return Handle;
+}
+
+void UNoctAbilityComponent::RemoveAttributeModifier(const FGameplayTag AttributeTag, const int32 Handle)
+{
+	if (FNoctAttribute* Attribute = FindAttribute(AttributeTag))
+	{
+		NOCT_RECORD(RecordModifierRemoved(this, AttributeTag, Handle));
+		Attribute->RemoveModifierByHandle(Handle);
+	}
+}
+
 #ifdef USE_EASY_MULTI_SAVE
 
 void UNoctAbilityComponent::ActorLoaded_Implementation()
 {
-
+	RebuildAbilityIndex();
+	RebuildTagBits();
+	RebuildReplicatedState();
 }
 
 void UNoctAbilityComponent::ActorPreSave_Implementation()
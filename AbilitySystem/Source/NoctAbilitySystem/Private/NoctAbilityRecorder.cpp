@@ -0,0 +1,416 @@
+﻿// Copyright Nocturnum Games 2023 
+
+
+#include "NoctAbilityRecorder.h"
+#include "NoctAbilitySystem.h"
+#include "NoctAbility.h"
+#include "NoctAbilityComponent.h"
+#include "NoctEffect.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+
+FNoctAbilityRecorder* FNoctAbilityRecorder::ActiveRecorder = nullptr;
+int32 FNoctAbilityRecorder::NestingDepth = 0;
+
+static FAutoConsoleCommandWithWorld StartRecordingCommand(
+	TEXT("NoctAbilitySystem.Record.Start"),
+	TEXT("Start recording ability system events in this world"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		FNoctAbilityRecorder::Start(World);
+	}));
+
+static FAutoConsoleCommand StopRecordingCommand(
+	TEXT("NoctAbilitySystem.Record.Stop"),
+	TEXT("Stop recording ability system events and write them to the given file, Saved/NoctRecordings/<Time>.noctrec by default"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const FString FileName = Args.Num() > 0 ? Args[0] : FPaths::ProjectSavedDir() / TEXT("NoctRecordings") / FDateTime::Now().ToString() + TEXT(".noctrec");
+		FNoctAbilityRecorder::Stop(FileName);
+	}));
+
+void FNoctRecordedEvent::Serialize(FArchive& Ar)
+{
+	// The high bit of the type is the nesting
+	uint8 TypeAndNesting = static_cast<uint8>(Type) | (bNested ? 0x80 : 0);
+	Ar << TypeAndNesting;
+	Type = static_cast<ENoctRecordedEventType>(TypeAndNesting & 0x7F);
+	bNested = (TypeAndNesting & 0x80) != 0;
+
+	// Shifted by one so INDEX_NONE packs into a single byte
+	const auto SerializeIndex = [&Ar](int32& Index)
+	{
+		uint32 Packed = static_cast<uint32>(Index + 1);
+		Ar.SerializeIntPacked(Packed);
+		Index = static_cast<int32>(Packed) - 1;
+	};
+	const auto SerializeInt = [&Ar](int32& Value)
+	{
+		uint32 Packed = static_cast<uint32>(Value);
+		Ar.SerializeIntPacked(Packed);
+		Value = static_cast<int32>(Packed);
+	};
+
+	switch (Type)
+	{
+	case ENoctRecordedEventType::NameDefined:
+		SerializeIndex(NameIndex);
+		Ar << Name;
+		return;
+	case ENoctRecordedEventType::FrameStarted:
+		Ar << FloatValue;
+		return;
+	default:
+		break;
+	}
+
+	Ar.SerializeIntPacked(ComponentId);
+
+	switch (Type)
+	{
+	case ENoctRecordedEventType::ComponentAdded:
+		SerializeIndex(NameIndex);
+		SerializeIndex(SecondNameIndex);
+		break;
+	case ENoctRecordedEventType::AttributeAdded:
+		SerializeIndex(NameIndex);
+		Ar << FloatValue;
+		Ar << SecondFloatValue;
+		break;
+	case ENoctRecordedEventType::AbilityUnlocked:
+	case ENoctRecordedEventType::AbilityActivated:
+	case ENoctRecordedEventType::AbilityCancelled:
+	case ENoctRecordedEventType::AbilityFinished:
+	case ENoctRecordedEventType::AbilityActivationRequested:
+	case ENoctRecordedEventType::EffectTriggered:
+		SerializeIndex(NameIndex);
+		break;
+	case ENoctRecordedEventType::EffectApplied:
+	case ENoctRecordedEventType::EffectRemoved:
+		SerializeIndex(NameIndex);
+		SerializeInt(IntValue);
+		break;
+	case ENoctRecordedEventType::ModifierAdded:
+		SerializeIndex(NameIndex);
+		SerializeInt(IntValue);
+		Ar << FloatValue;
+		SerializeIndex(SecondNameIndex);
+		Ar << Flags;
+		Ar << SecondFloatValue;
+		break;
+	case ENoctRecordedEventType::ModifierRemoved:
+		SerializeIndex(NameIndex);
+		SerializeInt(IntValue);
+		break;
+	default:
+		break;
+	}
+}
+
+bool FNoctAbilityRecording::Load(const FString& FileName)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *FileName))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Data);
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	Reader << Magic << Version;
+	if (Magic != FNoctAbilityRecorder::FileMagic || Version == 0 || Version > FNoctAbilityRecorder::FileVersion)
+	{
+		UE_LOG(LogNoctAbilitySystem, Error, TEXT("%s isn't an ability system recording of version %u or older"), *FileName, FNoctAbilityRecorder::FileVersion);
+		return false;
+	}
+
+	Names.Reset();
+	Events.Reset();
+	FrameDeltas.Reset();
+
+	while (!Reader.AtEnd())
+	{
+		FNoctRecordedEvent Event;
+		Event.Serialize(Reader);
+
+		if (Reader.IsError() || Event.Type >= ENoctRecordedEventType::Count)
+		{
+			UE_LOG(LogNoctAbilitySystem, Error, TEXT("%s is corrupt after %d events"), *FileName, Events.Num());
+			return false;
+		}
+
+		switch (Event.Type)
+		{
+		case ENoctRecordedEventType::NameDefined:
+			if (Event.NameIndex >= 0)
+			{
+				if (Event.NameIndex >= Names.Num())
+				{
+					Names.SetNum(Event.NameIndex + 1);
+				}
+				Names[Event.NameIndex] = MoveTemp(Event.Name);
+			}
+			break;
+		case ENoctRecordedEventType::FrameStarted:
+			FrameDeltas.Add(Event.FloatValue);
+			break;
+		default:
+			Event.Frame = FrameDeltas.Num();
+			Events.Add(MoveTemp(Event));
+			break;
+		}
+	}
+
+	return true;
+}
+
+bool FNoctAbilityRecorder::Start(UWorld* World)
+{
+	if (ActiveRecorder || !World)
+	{
+		return false;
+	}
+
+	ActiveRecorder = new FNoctAbilityRecorder(World);
+	UE_LOG(LogNoctAbilitySystem, Display, TEXT("Recording ability system events in %s"), *World->GetName());
+	return true;
+}
+
+bool FNoctAbilityRecorder::Stop(const FString& FileName)
+{
+	if (!ActiveRecorder)
+	{
+		return false;
+	}
+
+	const bool bSaved = FFileHelper::SaveArrayToFile(ActiveRecorder->Data, *FileName);
+	if (bSaved)
+	{
+		UE_LOG(LogNoctAbilitySystem, Display, TEXT("Recorded %u frames, %d bytes, to %s"), ActiveRecorder->Frame, ActiveRecorder->Data.Num(), *FileName);
+	}
+	else
+	{
+		UE_LOG(LogNoctAbilitySystem, Error, TEXT("Couldn't write the recording to %s"), *FileName);
+	}
+
+	delete ActiveRecorder;
+	ActiveRecorder = nullptr;
+	return bSaved;
+}
+
+FNoctAbilityRecorder::FNoctAbilityRecorder(UWorld* InWorld)
+	: World(InWorld)
+	, Writer(Data)
+{
+	uint32 Magic = FileMagic;
+	uint32 Version = FileVersion;
+	Writer << Magic << Version;
+
+	TickStartHandle = FWorldDelegates::OnWorldTickStart.AddRaw(this, &FNoctAbilityRecorder::OnWorldTickStart);
+}
+
+FNoctAbilityRecorder::~FNoctAbilityRecorder()
+{
+	FWorldDelegates::OnWorldTickStart.Remove(TickStartHandle);
+}
+
+void FNoctAbilityRecorder::OnWorldTickStart(UWorld* TickedWorld, ELevelTick TickType, const float DeltaSeconds)
+{
+	if (TickedWorld == World.Get())
+	{
+		FNoctRecordedEvent Event;
+		Event.Type = ENoctRecordedEventType::FrameStarted;
+		Event.FloatValue = DeltaSeconds;
+		Write(Event);
+		++Frame;
+	}
+}
+
+bool FNoctAbilityRecorder::IsRecording(const UNoctAbilityComponent* Component) const
+{
+	return Component && Component->GetWorld() == World.Get();
+}
+
+uint32 FNoctAbilityRecorder::GetComponentId(const UNoctAbilityComponent* Component)
+{
+	if (const uint32* Id = ComponentIds.Find(FObjectKey(Component)))
+	{
+		return *Id;
+	}
+
+	const uint32 Id = ComponentIds.Num() + 1;
+	ComponentIds.Add(FObjectKey(Component), Id);
+
+	// What the component already had, so the replay starts from the same place. Effects active before the recording aren't included.
+	FNoctRecordedEvent Added;
+	Added.Type = ENoctRecordedEventType::ComponentAdded;
+	Added.ComponentId = Id;
+	Added.NameIndex = GetNameIndex(Component->GetOwner() ? Component->GetOwner()->GetClass()->GetPathName() : FString());
+	Added.SecondNameIndex = GetNameIndex(Component->GetClass()->GetPathName());
+	Write(Added);
+
+	for (const TPair<FGameplayTag, FNoctAttribute>& Attribute : Component->Attributes)
+	{
+		FNoctRecordedEvent Event;
+		Event.Type = ENoctRecordedEventType::AttributeAdded;
+		Event.ComponentId = Id;
+		Event.NameIndex = GetNameIndex(Attribute.Key.ToString());
+		Event.FloatValue = Attribute.Value.BaseValue;
+		Event.SecondFloatValue = Attribute.Value.MaxValue;
+		Write(Event);
+	}
+
+	const auto WriteUnlocked = [this, Id](const UClass* AbilityClass)
+	{
+		FNoctRecordedEvent Event;
+		Event.Type = ENoctRecordedEventType::AbilityUnlocked;
+		Event.ComponentId = Id;
+		Event.NameIndex = GetNameIndex(AbilityClass->GetPathName());
+		Write(Event);
+	};
+	for (const UNoctAbility* Ability : Component->Abilities)
+	{
+		if (Ability)
+		{
+			WriteUnlocked(Ability->GetClass());
+		}
+	}
+	for (const FNoctPendingAbility& PendingAbility : Component->PendingAbilities)
+	{
+		if (PendingAbility.AbilityClass)
+		{
+			WriteUnlocked(PendingAbility.AbilityClass);
+		}
+	}
+
+	return Id;
+}
+
+int32 FNoctAbilityRecorder::GetNameIndex(const FString& Name)
+{
+	if (const int32* Index = NameIndices.Find(Name))
+	{
+		return *Index;
+	}
+
+	const int32 Index = NameIndices.Num();
+	NameIndices.Add(Name, Index);
+
+	FNoctRecordedEvent Event;
+	Event.Type = ENoctRecordedEventType::NameDefined;
+	Event.NameIndex = Index;
+	Event.Name = Name;
+	Write(Event);
+	return Index;
+}
+
+void FNoctAbilityRecorder::Write(FNoctRecordedEvent& Event)
+{
+	Event.Serialize(Writer);
+}
+
+void FNoctAbilityRecorder::RecordComponentRemoved(const UNoctAbilityComponent* Component)
+{
+	if (IsRecording(Component) && ComponentIds.Contains(FObjectKey(Component)))
+	{
+		FNoctRecordedEvent Event;
+		Event.Type = ENoctRecordedEventType::ComponentRemoved;
+		Event.bNested = NestingDepth > 0;
+		Event.ComponentId = GetComponentId(Component);
+		Write(Event);
+
+		ComponentIds.Remove(FObjectKey(Component));
+	}
+}
+
+void FNoctAbilityRecorder::RecordAttributeAdded(const UNoctAbilityComponent* Component, const FGameplayTag AttributeTag, const FNoctAttribute& Attribute)
+{
+	if (IsRecording(Component))
+	{
+		FNoctRecordedEvent Event;
+		Event.Type = ENoctRecordedEventType::AttributeAdded;
+		Event.bNested = NestingDepth > 0;
+		Event.ComponentId = GetComponentId(Component);
+		Event.NameIndex = GetNameIndex(AttributeTag.ToString());
+		Event.FloatValue = Attribute.BaseValue;
+		Event.SecondFloatValue = Attribute.MaxValue;
+		Write(Event);
+	}
+}
+
+void FNoctAbilityRecorder::RecordAbilityUnlocked(const UNoctAbilityComponent* Component, const UClass* AbilityClass)
+{
+	if (IsRecording(Component))
+	{
+		FNoctRecordedEvent Event;
+		Event.Type = ENoctRecordedEventType::AbilityUnlocked;
+		Event.bNested = NestingDepth > 0;
+		Event.ComponentId = GetComponentId(Component);
+		Event.NameIndex = GetNameIndex(AbilityClass->GetPathName());
+		Write(Event);
+	}
+}
+
+void FNoctAbilityRecorder::RecordAbility(const ENoctRecordedEventType Type, const UNoctAbilityComponent* Component, const FGameplayTag AbilityTag)
+{
+	if (IsRecording(Component))
+	{
+		FNoctRecordedEvent Event;
+		Event.Type = Type;
+		Event.bNested = NestingDepth > 0;
+		Event.ComponentId = GetComponentId(Component);
+		Event.NameIndex = GetNameIndex(AbilityTag.ToString());
+		Write(Event);
+	}
+}
+
+void FNoctAbilityRecorder::RecordEffect(const ENoctRecordedEventType Type, const UNoctAbilityComponent* Component, const UNoctEffect* Effect, const int32 IntValue)
+{
+	if (IsRecording(Component))
+	{
+		FNoctRecordedEvent Event;
+		Event.Type = Type;
+		Event.bNested = NestingDepth > 0;
+		Event.ComponentId = GetComponentId(Component);
+		Event.NameIndex = GetNameIndex(Effect->GetClass()->GetPathName());
+		Event.IntValue = IntValue;
+		Write(Event);
+	}
+}
+
+void FNoctAbilityRecorder::RecordModifierAdded(const UNoctAbilityComponent* Component, const FGameplayTag AttributeTag, const int32 Handle, const FNoctAttributeModifier& Modifier)
+{
+	if (IsRecording(Component))
+	{
+		FNoctRecordedEvent Event;
+		Event.Type = ENoctRecordedEventType::ModifierAdded;
+		Event.bNested = NestingDepth > 0;
+		Event.ComponentId = GetComponentId(Component);
+		Event.NameIndex = GetNameIndex(AttributeTag.ToString());
+		Event.IntValue = Handle;
+		Event.FloatValue = Modifier.Value;
+		Event.SecondNameIndex = Modifier.StackTag.IsValid() ? GetNameIndex(Modifier.StackTag.ToString()) : INDEX_NONE;
+		Event.Flags = (Modifier.bIsPercentage ? 1 : 0) | (static_cast<uint8>(Modifier.StackingPolicy) << 1);
+		Event.SecondFloatValue = static_cast<float>(Modifier.MaxStacks);
+		Write(Event);
+	}
+}
+
+void FNoctAbilityRecorder::RecordModifierRemoved(const UNoctAbilityComponent* Component, const FGameplayTag AttributeTag, const int32 Handle)
+{
+	if (IsRecording(Component))
+	{
+		FNoctRecordedEvent Event;
+		Event.Type = ENoctRecordedEventType::ModifierRemoved;
+		Event.bNested = NestingDepth > 0;
+		Event.ComponentId = GetComponentId(Component);
+		Event.NameIndex = GetNameIndex(AttributeTag.ToString());
+		Event.IntValue = Handle;
+		Write(Event);
+	}
+}
@@ -0,0 +1,130 @@
+﻿// Copyright Nocturnum Games 2023
+
+
+#include "NoctAbilityReplication.h"
+#include "NoctAbilityComponent.h"
+
+void FNoctReplicatedTagSet::AddTag(const FGameplayTag Tag)
+{
+	const bool bAlreadyAdded = Items.ContainsByPredicate([Tag](const FNoctReplicatedTag& Item)
+	{
+		return Item.Tag == Tag;
+	});
+
+	if (!bAlreadyAdded)
+	{
+		FNoctReplicatedTag& Item = Items.AddDefaulted_GetRef();
+		Item.Tag = Tag;
+		MarkItemDirty(Item);
+	}
+}
+
+void FNoctReplicatedTagSet::RemoveTag(const FGameplayTag Tag)
+{
+	const int32 Index = Items.IndexOfByPredicate([Tag](const FNoctReplicatedTag& Item)
+	{
+		return Item.Tag == Tag;
+	});
+
+	if (Index != INDEX_NONE)
+	{
+		Items.RemoveAtSwap(Index);
+		MarkArrayDirty();
+	}
+}
+
+void FNoctReplicatedTagSet::Reset(const FGameplayTagContainer& Tags)
+{
+	Items.Reset();
+	for (const FGameplayTag& Tag : Tags)
+	{
+		Items.AddDefaulted_GetRef().Tag = Tag;
+	}
+	MarkArrayDirty();
+}
+
+void FNoctReplicatedTagSet::PostReplicatedAdd(const TArrayView<int32>& AddedIndices, int32 FinalSize)
+{
+	if (Owner)
+	{
+		for (const int32 Index : AddedIndices)
+		{
+			Owner->ApplyReplicatedTag(SetType, Items[Index].Tag, true);
+		}
+	}
+}
+
+void FNoctReplicatedTagSet::PreReplicatedRemove(const TArrayView<int32>& RemovedIndices, int32 FinalSize)
+{
+	if (Owner)
+	{
+		for (const int32 Index : RemovedIndices)
+		{
+			Owner->ApplyReplicatedTag(SetType, Items[Index].Tag, false);
+		}
+	}
+}
+
+FNoctCooldownEntry FNoctReplicatedCooldown::ToEntry() const
+{
+	FNoctCooldownEntry Entry;
+	Entry.Tag = Tag;
+	Entry.EndTime = EndTime;
+	Entry.Duration = Duration;
+	Entry.MaxCharges = MaxCharges;
+	Entry.ChargeReadyTimes.Reserve(ChargeReadyTimes.Num());
+	for (const float ReadyTime : ChargeReadyTimes)
+	{
+		Entry.ChargeReadyTimes.Add(ReadyTime);
+	}
+	return Entry;
+}
+
+void FNoctReplicatedCooldownList::SetCooldown(const FGameplayTag Tag, const FNoctCooldownEntry* Entry)
+{
+	FNoctReplicatedCooldown* Item = Items.FindByPredicate([Tag](const FNoctReplicatedCooldown& Existing)
+	{
+		return Existing.Tag == Tag;
+	});
+
+	if (!Item)
+	{
+		Item = &Items.AddDefaulted_GetRef();
+		Item->Tag = Tag;
+	}
+
+	Item->EndTime = Entry ? static_cast<float>(Entry->EndTime) : 0.0f;
+	Item->Duration = Entry ? Entry->Duration : 0.0f;
+	Item->MaxCharges = Entry ? static_cast<uint8>(FMath::Min(Entry->MaxCharges, 255)) : 0;
+	Item->ChargeReadyTimes.Reset();
+	if (Entry)
+	{
+		for (const double ReadyTime : Entry->ChargeReadyTimes)
+		{
+			Item->ChargeReadyTimes.Add(static_cast<float>(ReadyTime));
+		}
+	}
+	MarkItemDirty(*Item);
+}
+
+void FNoctReplicatedCooldownList::PostReplicatedAdd(const TArrayView<int32>& AddedIndices, int32 FinalSize)
+{
+	if (Owner)
+	{
+		for (const int32 Index : AddedIndices)
+		{
+			Owner->ApplyReplicatedCooldown(Items[Index]);
+		}
+	}
+}
+
+void FNoctReplicatedCooldownList::PostReplicatedChange(const TArrayView<int32>& ChangedIndices, int32 FinalSize)
+{
+	if (Owner)
+	{
+		for (const int32 Index : ChangedIndices)
+		{
+			Owner->ApplyReplicatedCooldown(Items[Index]);
+		}
+	}
+}
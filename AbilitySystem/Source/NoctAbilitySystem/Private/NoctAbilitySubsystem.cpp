@@ -0,0 +1,255 @@
+﻿// Copyright Nocturnum Games 2023
+
+
+#include "NoctAbilitySubsystem.h"
+#include "NoctAbilityComponent.h"
+#include "NoctAbilitySystemSettings.h"
+#include "NoctAbilitySystemTrace.h"
+#include "NoctAbilitySystem.h"
+#include "GameFramework/PlayerController.h"
+
+UNoctAbilitySubsystem* UNoctAbilitySubsystem::Get(const UWorld* World)
+{
+	return World ? World->GetSubsystem<UNoctAbilitySubsystem>() : nullptr;
+}
+
+void UNoctAbilitySubsystem::RegisterComponent(UNoctAbilityComponent* Component)
+{
+	Components.AddUnique(Component);
+}
+
+void UNoctAbilitySubsystem::UnregisterComponent(UNoctAbilityComponent* Component)
+{
+	const int32 Index = Components.Find(Component);
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	// Keep the order, a significance pass may be part way through the array
+	Components.RemoveAt(Index);
+	if (NextSignificanceIndex > Index)
+	{
+		--NextSignificanceIndex;
+	}
+}
+
+void UNoctAbilitySubsystem::DeferCooldownNotifications(UNoctAbilityComponent* Component, const FGameplayTagContainer& FinishedCooldownTags)
+{
+	DeferredNotifications.Add({Component, FinishedCooldownTags});
+	
+	INC_DWORD_STAT(STAT_NoctDeferredNotifications);
+	INC_DWORD_STAT(STAT_NoctPendingDeferredNotifications);
+}
+
+void UNoctAbilitySubsystem::QueueCues(UNoctAbilityComponent* Component, const FGameplayTagContainer& CueTags, const ENoctCueEvent Event, const float Magnitude)
+{
+	TArray<FNoctCue>& Cues = PendingCues.FindOrAdd(Component);
+	for (const FGameplayTag& CueTag : CueTags)
+	{
+		Cues.Add({CueTag, Event, Magnitude});
+	}
+}
+
+void UNoctAbilitySubsystem::HandleCues(AActor* Target, const TConstArrayView<FNoctCue> Cues)
+{
+	if (GetWorld()->GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	for (const FNoctCue& Cue : Cues)
+	{
+		for (UNoctCueHandler* Handler : GetCueHandlers(Cue.CueTag))
+		{
+			Handler->HandleCue(Target, Cue);
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_NoctCuesHandled, Cues.Num());
+}
+
+int32 UNoctAbilitySubsystem::GetNumComponentsInTier(const ENoctSignificanceTier Tier) const
+{
+	return NumComponentsInTier[static_cast<int32>(Tier)];
+}
+
+void UNoctAbilitySubsystem::Tick(const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NoctSubsystemTick);
+	
+	const double Deadline = FPlatformTime::Seconds() + GetDefault<UNoctAbilitySystemSettings>()->DeferredWorkBudgetMs * 0.001;
+
+	// Notifications first, they have been waiting the longest
+	FlushDeferredNotifications(Deadline);
+	UpdateSignificance(Deadline);
+
+	// Not budgeted, a cue shown a frame late is a cue shown wrong
+	FlushCues();
+}
+
+TStatId UNoctAbilitySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNoctAbilitySubsystem, STATGROUP_Tickables);
+}
+
+void UNoctAbilitySubsystem::UpdateSignificance(const double Deadline)
+{
+	const UWorld* World = GetWorld();
+	
+	if (NextSignificanceIndex == INDEX_NONE)
+	{
+		if (World->GetTimeSeconds() < NextSignificancePassTime)
+		{
+			return;
+		}
+
+		// Start a new pass
+		ViewLocations.Reset();
+		for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+		{
+			if (const APlayerController* PlayerController = It->Get())
+			{
+				FVector Location;
+				FRotator Rotation;
+				PlayerController->GetPlayerViewPoint(Location, Rotation);
+				ViewLocations.Add(Location);
+			}
+		}
+
+		NextSignificanceIndex = 0;
+		FMemory::Memzero(NumComponentsInTierThisPass);
+	}
+
+	// Always make some progress, even over budget
+	bool bFirst = true;
+	while (NextSignificanceIndex < Components.Num() && (bFirst || FPlatformTime::Seconds() < Deadline))
+	{
+		bFirst = false;
+		
+		UNoctAbilityComponent* Component = Components[NextSignificanceIndex++].Get();
+		if (!Component || !Component->bUseSignificance)
+		{
+			continue;
+		}
+
+		ENoctSignificanceTier Tier = ENoctSignificanceTier::High;
+		if (const AActor* Owner = Component->GetOwner(); Owner && ViewLocations.Num() > 0)
+		{
+			const FVector Location = Owner->GetActorLocation();
+			double NearestDistanceSquared = TNumericLimits<double>::Max();
+			for (const FVector& ViewLocation : ViewLocations)
+			{
+				NearestDistanceSquared = FMath::Min(NearestDistanceSquared, FVector::DistSquared(Location, ViewLocation));
+			}
+			Tier = GetTierForDistanceSquared(NearestDistanceSquared);
+		}
+
+		Component->SetSignificanceTier(Tier);
+		++NumComponentsInTierThisPass[static_cast<int32>(Tier)];
+	}
+
+	if (NextSignificanceIndex >= Components.Num())
+	{
+		NextSignificanceIndex = INDEX_NONE;
+		NextSignificancePassTime = World->GetTimeSeconds() + GetDefault<UNoctAbilitySystemSettings>()->SignificanceUpdateInterval;
+		FMemory::Memcpy(NumComponentsInTier, NumComponentsInTierThisPass);
+
+		SET_DWORD_STAT(STAT_NoctHighSignificanceComponents, NumComponentsInTier[0]);
+		SET_DWORD_STAT(STAT_NoctMediumSignificanceComponents, NumComponentsInTier[1]);
+		SET_DWORD_STAT(STAT_NoctLowSignificanceComponents, NumComponentsInTier[2]);
+	}
+}
+
+void UNoctAbilitySubsystem::FlushDeferredNotifications(const double Deadline)
+{
+	// Always send at least one, so a zero budget or a frame already over it can't leave them waiting forever
+	int32 NumFlushed = 0;
+	while (NumFlushed < DeferredNotifications.Num() && (NumFlushed == 0 || FPlatformTime::Seconds() < Deadline))
+	{
+		// Copied, notifying runs Blueprint code that can defer more
+		const FDeferredNotification Notification = DeferredNotifications[NumFlushed++];
+		if (UNoctAbilityComponent* Component = Notification.Component.Get())
+		{
+			Component->NotifyCooldownsFinished(Notification.FinishedCooldownTags);
+		}
+	}
+
+	if (NumFlushed > 0)
+	{
+		DeferredNotifications.RemoveAt(0, NumFlushed, EAllowShrinking::No);
+		
+		INC_DWORD_STAT_BY(STAT_NoctDeferredNotificationsFlushed, NumFlushed);
+		DEC_DWORD_STAT_BY(STAT_NoctPendingDeferredNotifications, NumFlushed);
+	}
+}
+
+void UNoctAbilitySubsystem::FlushCues()
+{
+	if (PendingCues.IsEmpty())
+	{
+		return;
+	}
+
+	// Moved out first, handlers run Blueprint code that can send more cues
+	TMap<TWeakObjectPtr<UNoctAbilityComponent>, TArray<FNoctCue>> Cues = MoveTemp(PendingCues);
+	PendingCues.Reset();
+
+	for (const TPair<TWeakObjectPtr<UNoctAbilityComponent>, TArray<FNoctCue>>& Batch : Cues)
+	{
+		if (UNoctAbilityComponent* Component = Batch.Key.Get())
+		{
+			Component->SendCues(Batch.Value);
+			INC_DWORD_STAT_BY(STAT_NoctCuesSent, Batch.Value.Num());
+		}
+	}
+}
+
+TConstArrayView<UNoctCueHandler*> UNoctAbilitySubsystem::GetCueHandlers(const FGameplayTag CueTag)
+{
+	if (const TArray<UNoctCueHandler*, TInlineAllocator<2>>* Handlers = CueHandlersByTag.Find(CueTag))
+	{
+		return *Handlers;
+	}
+
+	if (!bCueHandlersCreated)
+	{
+		bCueHandlersCreated = true;
+		for (const TSoftClassPtr<UNoctCueHandler>& HandlerClass : GetDefault<UNoctAbilitySystemSettings>()->CueHandlers)
+		{
+			if (UClass* LoadedClass = HandlerClass.LoadSynchronous())
+			{
+				CueHandlers.Add(NewObject<UNoctCueHandler>(this, LoadedClass));
+			}
+			else if (!HandlerClass.IsNull())
+			{
+				UE_LOG(LogNoctAbilitySystem, Warning, TEXT("Cue handler class %s could not be loaded"), *HandlerClass.ToString());
+			}
+		}
+	}
+
+	TArray<UNoctCueHandler*, TInlineAllocator<2>>& Handlers = CueHandlersByTag.Add(CueTag);
+	for (UNoctCueHandler* Handler : CueHandlers)
+	{
+		if (CueTag.MatchesTag(Handler->CueTag))
+		{
+			Handlers.Add(Handler);
+		}
+	}
+	return Handlers;
+}
+
+ENoctSignificanceTier UNoctAbilitySubsystem::GetTierForDistanceSquared(const double DistanceSquared) const
+{
+	const UNoctAbilitySystemSettings* Settings = GetDefault<UNoctAbilitySystemSettings>();
+	
+	if (DistanceSquared >= FMath::Square(Settings->LowSignificanceDistance))
+	{
+		return ENoctSignificanceTier::Low;
+	}
+	if (DistanceSquared >= FMath::Square(Settings->MediumSignificanceDistance))
+	{
+		return ENoctSignificanceTier::Medium;
+	}
+	return ENoctSignificanceTier::High;
+}
@@ -0,0 +1,106 @@
+﻿// Copyright Nocturnum Games 2023 
+
+
+#include "NoctAbilitySystemTrace.h"
+#include "NoctAbilityComponent.h"
+#include "NoctEffect.h"
+
+DEFINE_STAT(STAT_NoctEffectsApplied);
+DEFINE_STAT(STAT_NoctEffectsRemoved);
+DEFINE_STAT(STAT_NoctEffectsExpired);
+DEFINE_STAT(STAT_NoctEffectsTriggered);
+DEFINE_STAT(STAT_NoctEffectPoolHits);
+DEFINE_STAT(STAT_NoctEffectPoolMisses);
+DEFINE_STAT(STAT_NoctDeferredNotifications);
+DEFINE_STAT(STAT_NoctDeferredNotificationsFlushed);
+DEFINE_STAT(STAT_NoctCuesSent);
+DEFINE_STAT(STAT_NoctCuesHandled);
+DEFINE_STAT(STAT_NoctCosmeticEventsSkipped);
+DEFINE_STAT(STAT_NoctActiveEffects);
+DEFINE_STAT(STAT_NoctPooledEffects);
+DEFINE_STAT(STAT_NoctPendingDeferredNotifications);
+DEFINE_STAT(STAT_NoctHighSignificanceComponents);
+DEFINE_STAT(STAT_NoctMediumSignificanceComponents);
+DEFINE_STAT(STAT_NoctLowSignificanceComponents);
+DEFINE_STAT(STAT_NoctAdvanceEffects);
+DEFINE_STAT(STAT_NoctResolveActivations);
+DEFINE_STAT(STAT_NoctSubsystemTick);
+
+#if NOCT_ABILITY_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_DEFINE(NoctAbilitySystemChannel)
+
+UE_TRACE_EVENT_BEGIN(NoctAbilitySystem, EffectApplied)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, ComponentId)
+	UE_TRACE_EVENT_FIELD(uint32, ActiveEffectCount)
+	UE_TRACE_EVENT_FIELD(bool, FromPool)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, EffectClass)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(NoctAbilitySystem, EffectRemoved)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, ComponentId)
+	UE_TRACE_EVENT_FIELD(uint32, ActiveEffectCount)
+	UE_TRACE_EVENT_FIELD(bool, Expired)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, EffectClass)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(NoctAbilitySystem, EffectTriggered)
+	UE_TRACE_EVENT_FIELD(uint64, StartCycle)
+	UE_TRACE_EVENT_FIELD(uint64, EndCycle)
+	UE_TRACE_EVENT_FIELD(uint32, ComponentId)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, EffectClass)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(NoctAbilitySystem, EffectPool)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, ComponentId)
+	UE_TRACE_EVENT_FIELD(uint32, PooledEffectCount)
+UE_TRACE_EVENT_END()
+
+namespace NoctAbilityTrace
+{
+	void OutputEffectApplied(const UNoctEffect* Effect, const UNoctAbilityComponent* Component, const bool bFromPool)
+	{
+		const FString ClassName = Effect->GetClass()->GetName();
+		UE_TRACE_LOG(NoctAbilitySystem, EffectApplied, NoctAbilitySystemChannel)
+			<< EffectApplied.Cycle(FPlatformTime::Cycles64())
+			<< EffectApplied.ComponentId(Component->GetUniqueID())
+			<< EffectApplied.ActiveEffectCount(Component->ActiveEffects.Num())
+			<< EffectApplied.FromPool(bFromPool)
+			<< EffectApplied.EffectClass(*ClassName, ClassName.Len());
+	}
+
+	void OutputEffectRemoved(const UNoctEffect* Effect, const UNoctAbilityComponent* Component, const bool bExpired)
+	{
+		const FString ClassName = Effect->GetClass()->GetName();
+		UE_TRACE_LOG(NoctAbilitySystem, EffectRemoved, NoctAbilitySystemChannel)
+			<< EffectRemoved.Cycle(FPlatformTime::Cycles64())
+			<< EffectRemoved.ComponentId(Component->GetUniqueID())
+			<< EffectRemoved.ActiveEffectCount(Component->ActiveEffects.Num())
+			<< EffectRemoved.Expired(bExpired)
+			<< EffectRemoved.EffectClass(*ClassName, ClassName.Len());
+	}
+
+	void OutputEffectTriggered(const UNoctEffect* Effect, const uint64 StartCycle, const uint64 EndCycle)
+	{
+		const FString ClassName = Effect->GetClass()->GetName();
+		const uint32 ComponentId = Effect->OwningAbilityComponent ? Effect->OwningAbilityComponent->GetUniqueID() : 0;
+		UE_TRACE_LOG(NoctAbilitySystem, EffectTriggered, NoctAbilitySystemChannel)
+			<< EffectTriggered.StartCycle(StartCycle)
+			<< EffectTriggered.EndCycle(EndCycle)
+			<< EffectTriggered.ComponentId(ComponentId)
+			<< EffectTriggered.EffectClass(*ClassName, ClassName.Len());
+	}
+
+	void OutputEffectPool(const UNoctAbilityComponent* Component, const int32 NumPooled)
+	{
+		UE_TRACE_LOG(NoctAbilitySystem, EffectPool, NoctAbilitySystemChannel)
+			<< EffectPool.Cycle(FPlatformTime::Cycles64())
+			<< EffectPool.ComponentId(Component->GetUniqueID())
+			<< EffectPool.PooledEffectCount(NumPooled);
+	}
+}
+
+#endif
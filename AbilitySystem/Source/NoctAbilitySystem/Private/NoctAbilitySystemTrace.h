@@ -0,0 +1,98 @@
+﻿// Copyright Nocturnum Games 2023 
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+
+class UNoctEffect;
+class UNoctAbilityComponent;
+
+// Insights events for the ability system, compiled out of shipping builds.
+// Enable at runtime with -trace=default,NoctAbilitySystem or Trace.Enable NoctAbilitySystem.
+#define NOCT_ABILITY_TRACE_ENABLED (UE_TRACE_ENABLED && !UE_BUILD_SHIPPING)
+
+DECLARE_STATS_GROUP(TEXT("NoctAbilitySystem"), STATGROUP_NoctAbilitySystem, STATCAT_Advanced);
+
+// Per frame counts
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Effects Applied"), STAT_NoctEffectsApplied, STATGROUP_NoctAbilitySystem, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Effects Removed"), STAT_NoctEffectsRemoved, STATGROUP_NoctAbilitySystem, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Effects Expired"), STAT_NoctEffectsExpired, STATGROUP_NoctAbilitySystem, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Effects Triggered"), STAT_NoctEffectsTriggered, STATGROUP_NoctAbilitySystem, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Effect Pool Hits"), STAT_NoctEffectPoolHits, STATGROUP_NoctAbilitySystem, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Effect Pool Misses"), STAT_NoctEffectPoolMisses, STATGROUP_NoctAbilitySystem, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Deferred Notifications"), STAT_NoctDeferredNotifications, STATGROUP_NoctAbilitySystem, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Deferred Notifications Sent"), STAT_NoctDeferredNotificationsFlushed, STATGROUP_NoctAbilitySystem, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Cues Sent"), STAT_NoctCuesSent, STATGROUP_NoctAbilitySystem, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Cues Handled"), STAT_NoctCuesHandled, STATGROUP_NoctAbilitySystem, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Cosmetic Events Skipped"), STAT_NoctCosmeticEventsSkipped, STATGROUP_NoctAbilitySystem, );
+
+// Running totals
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Active Effects"), STAT_NoctActiveEffects, STATGROUP_NoctAbilitySystem, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pooled Effects"), STAT_NoctPooledEffects, STATGROUP_NoctAbilitySystem, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pending Deferred Notifications"), STAT_NoctPendingDeferredNotifications, STATGROUP_NoctAbilitySystem, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("High Significance Components"), STAT_NoctHighSignificanceComponents, STATGROUP_NoctAbilitySystem, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Medium Significance Components"), STAT_NoctMediumSignificanceComponents, STATGROUP_NoctAbilitySystem, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Low Significance Components"), STAT_NoctLowSignificanceComponents, STATGROUP_NoctAbilitySystem, );
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Advance Effects"), STAT_NoctAdvanceEffects, STATGROUP_NoctAbilitySystem, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Resolve Activations"), STAT_NoctResolveActivations, STATGROUP_NoctAbilitySystem, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Subsystem Tick"), STAT_NoctSubsystemTick, STATGROUP_NoctAbilitySystem, );
+
+#if NOCT_ABILITY_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_EXTERN(NoctAbilitySystemChannel)
+
+namespace NoctAbilityTrace
+{
+	void OutputEffectApplied(const UNoctEffect* Effect, const UNoctAbilityComponent* Component, bool bFromPool);
+	void OutputEffectRemoved(const UNoctEffect* Effect, const UNoctAbilityComponent* Component, bool bExpired);
+	void OutputEffectTriggered(const UNoctEffect* Effect, uint64 StartCycle, uint64 EndCycle);
+	void OutputEffectPool(const UNoctAbilityComponent* Component, int32 NumPooled);
+}
+
+// Times one trigger of an effect, only reading the clock while the channel is enabled
+struct FNoctEffectTriggerTraceScope
+{
+	explicit FNoctEffectTriggerTraceScope(const UNoctEffect* InEffect)
+	{
+		if (UE_TRACE_CHANNELEXPR_IS_ENABLED(NoctAbilitySystemChannel))
+		{
+			Effect = InEffect;
+			StartCycle = FPlatformTime::Cycles64();
+		}
+	}
+
+	~FNoctEffectTriggerTraceScope()
+	{
+		if (Effect)
+		{
+			NoctAbilityTrace::OutputEffectTriggered(Effect, StartCycle, FPlatformTime::Cycles64());
+		}
+	}
+
+	const UNoctEffect* Effect = nullptr;
+	uint64 StartCycle = 0;
+};
+
+#define NOCT_TRACE_EFFECT_APPLIED(Effect, Component, bFromPool) \
+	do { if (UE_TRACE_CHANNELEXPR_IS_ENABLED(NoctAbilitySystemChannel)) { NoctAbilityTrace::OutputEffectApplied(Effect, Component, bFromPool); } } while (0)
+
+#define NOCT_TRACE_EFFECT_REMOVED(Effect, Component, bExpired) \
+	do { if (UE_TRACE_CHANNELEXPR_IS_ENABLED(NoctAbilitySystemChannel)) { NoctAbilityTrace::OutputEffectRemoved(Effect, Component, bExpired); } } while (0)
+
+#define NOCT_TRACE_EFFECT_TRIGGER_SCOPE(Effect) \
+	FNoctEffectTriggerTraceScope PREPROCESSOR_JOIN(NoctEffectTriggerScope, __LINE__)(Effect)
+
+#define NOCT_TRACE_EFFECT_POOL(Component, NumPooled) \
+	do { if (UE_TRACE_CHANNELEXPR_IS_ENABLED(NoctAbilitySystemChannel)) { NoctAbilityTrace::OutputEffectPool(Component, NumPooled); } } while (0)
+
+#else
+
+#define NOCT_TRACE_EFFECT_APPLIED(Effect, Component, bFromPool)
+#define NOCT_TRACE_EFFECT_REMOVED(Effect, Component, bExpired)
+#define NOCT_TRACE_EFFECT_TRIGGER_SCOPE(Effect)
+#define NOCT_TRACE_EFFECT_POOL(Component, NumPooled)
+
+#endif
@@ -0,0 +1,57 @@
+﻿// Copyright Nocturnum Games 2023
+
+
+#include "NoctAbilityTasks.h"
+
+FNoctAbilityTaskHandle FNoctAbilityTaskList::Add(const FNoctAbilityTask& Task)
+{
+	const int32 Index = FreeIndices.Num() > 0 ? FreeIndices.Pop(EAllowShrinking::No) : Tasks.AddDefaulted();
+
+	FNoctAbilityTask& NewTask = Tasks[Index];
+	NewTask = Task;
+	NewTask.Serial = NextSerial;
+
+	// Zero marks a free slot
+	NextSerial = NextSerial == MAX_uint32 ? 1 : NextSerial + 1;
+
+	++NumActive;
+	if (NewTask.IsPolled())
+	{
+		++NumPolled;
+	}
+
+	return FNoctAbilityTaskHandle(Index, NewTask.Serial);
+}
+
+bool FNoctAbilityTaskList::Remove(const FNoctAbilityTaskHandle Handle)
+{
+	if (!Find(Handle))
+	{
+		return false;
+	}
+
+	FNoctAbilityTask& Task = Tasks[Handle.Index];
+	if (Task.IsPolled())
+	{
+		--NumPolled;
+	}
+	--NumActive;
+
+	Task.Serial = 0;
+	FreeIndices.Add(Handle.Index);
+	return true;
+}
+
+int32 FNoctAbilityTaskList::RemoveAll(const FGameplayTag AbilityTag)
+{
+	int32 NumRemoved = 0;
+	for (int32 Index = 0; Index < Tasks.Num() && NumActive > 0; ++Index)
+	{
+		if (Tasks[Index].IsActive() && Tasks[Index].AbilityTag == AbilityTag)
+		{
+			Remove(GetHandle(Index));
+			++NumRemoved;
+		}
+	}
+	return NumRemoved;
+}
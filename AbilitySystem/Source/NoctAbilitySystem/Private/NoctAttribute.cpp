@@ -2,26 +2,29 @@
 
 
 #include "NoctAttribute.h"
+#include "NoctTagContainerRegistry.h"
 
-void FNoctAttribute::AddModifier(const FNoctAttributeModifier& Modifier)
+int32 FNoctAttribute::AddModifier(const FNoctAttributeModifier& Modifier)
 {
-	TArray<FNoctAttributeModifier>& ModifiersArray = Modifier.bIsPercentage ? PercentModifiers : FlatModifiers;
+	TArray<FNoctCompactModifier>& ModifiersArray = Modifier.bIsPercentage ? PercentModifiers : FlatModifiers;
+	FNoctModifierTables& Tables = FNoctModifierTables::Get();
 	
 	// Check if we need to handle stacking
 	if (!Modifier.StackTag.IsValid())
 	{
 		// No stacking, just add the modifier
-		ModifiersArray.Add(Modifier);
+		const int32 Handle = ModifiersArray.Add_GetRef(FNoctCompactModifier::Make(Modifier)).Handle;
 		CurrentValue = CalculateValue();
-		return;
+		return Handle;
 	}
 	
-	// Find existing modifiers with the same stack tag
-	for (int32 i = 0; i < ModifiersArray.Num(); ++i)
+	// Find existing modifiers with the same stack tag. A tag that was never interned can't be on any modifier.
+	const uint16 StackTagIndex = Tables.FindStackTag(Modifier.StackTag);
+	for (int32 i = 0; StackTagIndex != 0 && i < ModifiersArray.Num(); ++i)
 	{
-		FNoctAttributeModifier& ExistingMod = ModifiersArray[i];
+		FNoctCompactModifier& ExistingMod = ModifiersArray[i];
 		
-		if (ExistingMod.StackTag == Modifier.StackTag)
+		if (ExistingMod.StackTagIndex == StackTagIndex)
 		{
 			// Handle the stacking based on the policy
 			switch (Modifier.StackingPolicy)
@@ -33,21 +36,21 @@ void FNoctAttribute::AddModifier(const FNoctAttributeModifier& Modifier)
 					{
 						// Recalculate and return without adding
 						CurrentValue = CalculateValue();
-						return;
+						return ExistingMod.Handle;
 					}
 					
 					// Add to stack count
-					ExistingMod.StackCount++;
+					ExistingMod.StackCount = static_cast<uint16>(FMath::Min<int32>(ExistingMod.StackCount + 1, MAX_uint16));
 					
 					// Increase the value
 					ExistingMod.Value += Modifier.Value;
 					
 					// Copy over any new tags
-					ExistingMod.Tags.AppendTags(Modifier.Tags);
+					ExistingMod.TagSetIndex = FNoctTagContainerRegistry::Get().InternUnion(ExistingMod.TagSetIndex, FNoctTagContainerRegistry::Get().Intern(Modifier.Tags));
 					
 					// Recalculate and return
 					CurrentValue = CalculateValue();
-					return;
+					return ExistingMod.Handle;
 				}
 				case EModifierStackingPolicy::Stack_Max:
 				{
@@ -55,14 +58,14 @@ void FNoctAttribute::AddModifier(const FNoctAttributeModifier& Modifier)
 					if (Modifier.Value > ExistingMod.Value)
 					{
 						ExistingMod.Value = Modifier.Value;
-						ExistingMod.Source = Modifier.Source;
-						ExistingMod.Tags = Modifier.Tags;
-						ExistingMod.StackCount++;
+						ExistingMod.SourceIndex = Tables.InternSource(Modifier.Source);
+						ExistingMod.TagSetIndex = FNoctTagContainerRegistry::Get().Intern(Modifier.Tags);
+						ExistingMod.StackCount = static_cast<uint16>(FMath::Min<int32>(ExistingMod.StackCount + 1, MAX_uint16));
 					}
 					
 					// Recalculate and return
 					CurrentValue = CalculateValue();
-					return;
+					return ExistingMod.Handle;
 				}
 				case EModifierStackingPolicy::Stack_Min:
 				{
@@ -70,24 +73,24 @@ void FNoctAttribute::AddModifier(const FNoctAttributeModifier& Modifier)
 					if (Modifier.Value < ExistingMod.Value)
 					{
 						ExistingMod.Value = Modifier.Value;
-						ExistingMod.Source = Modifier.Source;
-						ExistingMod.Tags = Modifier.Tags;
-						ExistingMod.StackCount++;
+						ExistingMod.SourceIndex = Tables.InternSource(Modifier.Source);
+						ExistingMod.TagSetIndex = FNoctTagContainerRegistry::Get().Intern(Modifier.Tags);
+						ExistingMod.StackCount = static_cast<uint16>(FMath::Min<int32>(ExistingMod.StackCount + 1, MAX_uint16));
 					}
 					
 					// Recalculate and return
 					CurrentValue = CalculateValue();
-					return;
+					return ExistingMod.Handle;
 				}
 				case EModifierStackingPolicy::Stack_Replace:
 				{
 					// Just replace the existing one
-					ExistingMod = Modifier;
+					ExistingMod = FNoctCompactModifier::Make(Modifier);
 					ExistingMod.StackCount = 1;
 					
 					// Recalculate and return
 					CurrentValue = CalculateValue();
-					return;
+					return ExistingMod.Handle;
 				}
 				case EModifierStackingPolicy::Stack_None:
 				default:
@@ -99,55 +102,50 @@ void FNoctAttribute::AddModifier(const FNoctAttributeModifier& Modifier)
 	
 	// If we reached here, either the modifier has Stack_None policy,
 	// or no existing modifier with the same tag was found
-	ModifiersArray.Add(Modifier);
+	const int32 Handle = ModifiersArray.Add_GetRef(FNoctCompactModifier::Make(Modifier)).Handle;
 	
 	// Recalculate the current value
 	CurrentValue = CalculateValue();
+	return Handle;
 }
 
 void FNoctAttribute::RemoveModifiersBySource(UObject* Source)
 {
-	bool bModified = false;
-	
-	// Remove flat modifiers from this source
-	for (int32 i = FlatModifiers.Num() - 1; i >= 0; --i)
+	// A source that was never interned can't be on any modifier
+	const uint32 SourceIndex = FNoctModifierTables::Get().FindSource(Source);
+	if (SourceIndex == 0)
 	{
-		if (FlatModifiers[i].Source == Source)
-		{
-			FlatModifiers.RemoveAt(i);
-			bModified = true;
-		}
+		return;
 	}
 	
-	// Remove percent modifiers from this source
-	for (int32 i = PercentModifiers.Num() - 1; i >= 0; --i)
+	// Remove flat and percent modifiers from this source
+	const int32 NumRemoved = FlatModifiers.RemoveAll([SourceIndex](const FNoctCompactModifier& Modifier)
 	{
-		if (PercentModifiers[i].Source == Source)
-		{
-			PercentModifiers.RemoveAt(i);
-			bModified = true;
-		}
-	}
+		return Modifier.SourceIndex == SourceIndex;
+	}) + PercentModifiers.RemoveAll([SourceIndex](const FNoctCompactModifier& Modifier)
+	{
+		return Modifier.SourceIndex == SourceIndex;
+	});
 	
 	// Only recalculate if we removed something
-	if (bModified)
+	if (NumRemoved > 0)
 	{
 		CurrentValue = CalculateValue();
 	}
 }
 
-void FNoctAttribute::RemoveModifierById(const FGuid& ModifierId)
+void FNoctAttribute::RemoveModifierByHandle(const int32 Handle)
 {
 	bool bModified = false;
 	
 	// Look for the modifier in flat modifiers
 	for (int32 i = 0; i < FlatModifiers.Num(); ++i)
 	{
-		if (FlatModifiers[i].Id == ModifierId)
+		if (FlatModifiers[i].Handle == Handle)
 		{
 			FlatModifiers.RemoveAt(i);
 			bModified = true;
-			break;  // IDs should be unique
+			break;  // Handles are unique
 		}
 	}
 	
@@ -156,11 +154,11 @@ void FNoctAttribute::RemoveModifierById(const FGuid& ModifierId)
 	{
 		for (int32 i = 0; i < PercentModifiers.Num(); ++i)
 		{
-			if (PercentModifiers[i].Id == ModifierId)
+			if (PercentModifiers[i].Handle == Handle)
 			{
 				PercentModifiers.RemoveAt(i);
 				bModified = true;
-				break;  // IDs should be unique
+				break;  // Handles are unique
 			}
 		}
 	}
@@ -174,30 +172,15 @@ void FNoctAttribute::RemoveModifierById(const FGuid& ModifierId)
 
 void FNoctAttribute::RemoveModifiersByTag(const FGameplayTag& Tag)
 {
-	bool bModified = false;
-	
-	// Remove flat modifiers with this tag
-	for (int32 i = FlatModifiers.Num() - 1; i >= 0; --i)
+	// Remove flat and percent modifiers with this tag
+	const auto HasTag = [&Tag](const FNoctCompactModifier& Modifier)
 	{
-		if (FlatModifiers[i].HasTag(Tag))
-		{
-			FlatModifiers.RemoveAt(i);
-			bModified = true;
-		}
-	}
-	
-	// Remove percent modifiers with this tag
-	for (int32 i = PercentModifiers.Num() - 1; i >= 0; --i)
-	{
-		if (PercentModifiers[i].HasTag(Tag))
-		{
-			PercentModifiers.RemoveAt(i);
-			bModified = true;
-		}
-	}
+		return Modifier.TagSetIndex != 0 && Modifier.GetTags().HasTag(Tag);
+	};
+	const int32 NumRemoved = FlatModifiers.RemoveAll(HasTag) + PercentModifiers.RemoveAll(HasTag);
 	
 	// Only recalculate if we removed something
-	if (bModified)
+	if (NumRemoved > 0)
 	{
 		CurrentValue = CalculateValue();
 	}
@@ -205,30 +188,15 @@ void FNoctAttribute::RemoveModifiersByTag(const FGameplayTag& Tag)
 
 void FNoctAttribute::RemoveModifiersByTags(const FGameplayTagContainer& Tags)
 {
-	bool bModified = false;
-	
-	// Remove flat modifiers with any of these tags
-	for (int32 i = FlatModifiers.Num() - 1; i >= 0; --i)
-	{
-		if (FlatModifiers[i].HasAnyTags(Tags))
-		{
-			FlatModifiers.RemoveAt(i);
-			bModified = true;
-		}
-	}
-	
-	// Remove percent modifiers with any of these tags
-	for (int32 i = PercentModifiers.Num() - 1; i >= 0; --i)
+	// Remove flat and percent modifiers with any of these tags
+	const auto HasAnyTags = [&Tags](const FNoctCompactModifier& Modifier)
 	{
-		if (PercentModifiers[i].HasAnyTags(Tags))
-		{
-			PercentModifiers.RemoveAt(i);
-			bModified = true;
-		}
-	}
+		return Modifier.TagSetIndex != 0 && Modifier.GetTags().HasAnyExact(Tags);
+	};
+	const int32 NumRemoved = FlatModifiers.RemoveAll(HasAnyTags) + PercentModifiers.RemoveAll(HasAnyTags);
 	
 	// Only recalculate if we removed something
-	if (bModified)
+	if (NumRemoved > 0)
 	{
 		CurrentValue = CalculateValue();
 	}
@@ -236,66 +204,49 @@ void FNoctAttribute::RemoveModifiersByTags(const FGameplayTagContainer& Tags)
 
 void FNoctAttribute::RemoveStack(const FGameplayTag& StackTag)
 {
-	if (!StackTag.IsValid())
+	const uint16 StackTagIndex = FNoctModifierTables::Get().FindStackTag(StackTag);
+	if (StackTagIndex == 0)
 	{
 		return;
 	}
 	
 	bool bModified = false;
 	
-	// Check flat modifiers first
-	for (int32 i = 0; i < FlatModifiers.Num(); ++i)
+	// Check flat modifiers first, then percent modifiers
+	for (TArray<FNoctCompactModifier>* ModifiersArray : {&FlatModifiers, &PercentModifiers})
 	{
-		FNoctAttributeModifier& Modifier = FlatModifiers[i];
-		if (Modifier.StackTag == StackTag)
+		for (int32 i = 0; i < ModifiersArray->Num(); ++i)
 		{
-			// Decrease stack count
-			Modifier.StackCount--;
-			
-			if (Modifier.StackCount <= 0)
-			{
-				// Remove the modifier if no stacks left
-				FlatModifiers.RemoveAt(i);
-			}
-			else if (Modifier.StackingPolicy == EModifierStackingPolicy::Stack_Add)
+			FNoctCompactModifier& Modifier = (*ModifiersArray)[i];
+			if (Modifier.StackTagIndex == StackTagIndex)
 			{
-				// Decrease the value for additive stacks
-				// For simplicity, we assume each stack adds the same amount
-				Modifier.Value = (Modifier.Value / (Modifier.StackCount + 1)) * Modifier.StackCount;
-			}
-			
-			bModified = true;
-			break;
-		}
-	}
-	
-	// If not found in flat modifiers, check percent modifiers
-	if (!bModified)
-	{
-		for (int32 i = 0; i < PercentModifiers.Num(); ++i)
-		{
-			FNoctAttributeModifier& Modifier = PercentModifiers[i];
-			if (Modifier.StackTag == StackTag)
-			{
-				// Decrease stack count
-				Modifier.StackCount--;
-				
-				if (Modifier.StackCount <= 0)
+				if (Modifier.StackCount <= 1)
 				{
 					// Remove the modifier if no stacks left
-					PercentModifiers.RemoveAt(i);
+					ModifiersArray->RemoveAt(i);
 				}
-				else if (Modifier.StackingPolicy == EModifierStackingPolicy::Stack_Add)
+				else
 				{
-					// Decrease the value for additive stacks
-					// For simplicity, we assume each stack adds the same amount
-					Modifier.Value = (Modifier.Value / (Modifier.StackCount + 1)) * Modifier.StackCount;
+					// Decrease stack count
+					Modifier.StackCount--;
+					
+					if (Modifier.GetStackingPolicy() == EModifierStackingPolicy::Stack_Add)
+					{
+						// Decrease the value for additive stacks
+						// For simplicity, we assume each stack adds the same amount
+						Modifier.Value = (Modifier.Value / (Modifier.StackCount + 1)) * Modifier.StackCount;
+					}
 				}
 				
 				bModified = true;
 				break;
 			}
 		}
+		
+		if (bModified)
+		{
+			break;
+		}
 	}
 	
 	// Only recalculate if we modified something
@@ -307,20 +258,8 @@ void FNoctAttribute::RemoveStack(const FGameplayTag& StackTag)
 
 float FNoctAttribute::CalculateValue()
 {
-	// Start with the base value
-	float FinalValue = BaseValue;
-	
-	// Add all flat modifiers
-	for (const FNoctAttributeModifier& Modifier : FlatModifiers)
-	{
-		FinalValue += Modifier.Value;
-	}
-	
-	// Apply all percentage modifiers
-	for (const FNoctAttributeModifier& Modifier : PercentModifiers)
-	{
-		FinalValue *= (1.0f + Modifier.Value);
-	}
+	// Add all flat modifiers to the base value, then apply all percentage modifiers
+	float FinalValue = (BaseValue + GetFlatModifierSum()) * GetPercentModifierScale();
 	
 	// Cap at max value if positive
 	if (MaxValue > 0 && FinalValue > MaxValue)
@@ -354,26 +293,47 @@ float FNoctAttribute::GetModifierValue() const
 	return CurrentValue - BaseValue;
 }
 
+float FNoctAttribute::GetFlatModifierSum() const
+{
+	float Sum = 0.0f;
+	for (const FNoctCompactModifier& Modifier : FlatModifiers)
+	{
+		Sum += Modifier.Value;
+	}
+	return Sum;
+}
+
+float FNoctAttribute::GetPercentModifierScale() const
+{
+	float Scale = 1.0f;
+	for (const FNoctCompactModifier& Modifier : PercentModifiers)
+	{
+		Scale *= (1.0f + Modifier.Value);
+	}
+	return Scale;
+}
+
 int32 FNoctAttribute::GetStackCount(const FGameplayTag& StackTag) const
 {
-	if (!StackTag.IsValid())
+	const uint16 StackTagIndex = FNoctModifierTables::Get().FindStackTag(StackTag);
+	if (StackTagIndex == 0)
 	{
 		return 0;
 	}
 	
 	// Check flat modifiers first
-	for (const FNoctAttributeModifier& Modifier : FlatModifiers)
+	for (const FNoctCompactModifier& Modifier : FlatModifiers)
 	{
-		if (Modifier.StackTag == StackTag)
+		if (Modifier.StackTagIndex == StackTagIndex)
 		{
 			return Modifier.StackCount;
 		}
 	}
 	
 	// Then check percent modifiers
-	for (const FNoctAttributeModifier& Modifier : PercentModifiers)
+	for (const FNoctCompactModifier& Modifier : PercentModifiers)
 	{
-		if (Modifier.StackTag == StackTag)
+		if (Modifier.StackTagIndex == StackTagIndex)
 		{
 			return Modifier.StackCount;
 		}
@@ -383,25 +343,42 @@ int32 FNoctAttribute::GetStackCount(const FGameplayTag& StackTag) const
 	return 0;
 }
 
+TArray<FNoctAttributeModifier> FNoctAttribute::GetModifiers() const
+{
+	TArray<FNoctAttributeModifier> Result;
+	Result.Reserve(FlatModifiers.Num() + PercentModifiers.Num());
+	
+	for (const FNoctCompactModifier& Modifier : FlatModifiers)
+	{
+		Result.Add(Modifier.Expand());
+	}
+	for (const FNoctCompactModifier& Modifier : PercentModifiers)
+	{
+		Result.Add(Modifier.Expand());
+	}
+	
+	return Result;
+}
+
 TArray<FNoctAttributeModifier> FNoctAttribute::GetModifiersWithTag(const FGameplayTag& Tag) const
 {
 	TArray<FNoctAttributeModifier> Result;
 	
 	// Check flat modifiers
-	for (const FNoctAttributeModifier& Modifier : FlatModifiers)
+	for (const FNoctCompactModifier& Modifier : FlatModifiers)
 	{
-		if (Modifier.HasTag(Tag))
+		if (Modifier.GetTags().HasTag(Tag))
 		{
-			Result.Add(Modifier);
+			Result.Add(Modifier.Expand());
 		}
 	}
 	
 	// Check percent modifiers
-	for (const FNoctAttributeModifier& Modifier : PercentModifiers)
+	for (const FNoctCompactModifier& Modifier : PercentModifiers)
 	{
-		if (Modifier.HasTag(Tag))
+		if (Modifier.GetTags().HasTag(Tag))
 		{
-			Result.Add(Modifier);
+			Result.Add(Modifier.Expand());
 		}
 	}
 	
@@ -413,22 +390,103 @@ TArray<FNoctAttributeModifier> FNoctAttribute::GetModifiersWithAnyTags(const FGa
 	TArray<FNoctAttributeModifier> Result;
 	
 	// Check flat modifiers
-	for (const FNoctAttributeModifier& Modifier : FlatModifiers)
+	for (const FNoctCompactModifier& Modifier : FlatModifiers)
 	{
-		if (Modifier.HasAnyTags(Tags))
+		if (Modifier.GetTags().HasAnyExact(Tags))
 		{
-			Result.Add(Modifier);
+			Result.Add(Modifier.Expand());
 		}
 	}
 	
 	// Check percent modifiers
-	for (const FNoctAttributeModifier& Modifier : PercentModifiers)
+	for (const FNoctCompactModifier& Modifier : PercentModifiers)
 	{
-		if (Modifier.HasAnyTags(Tags))
+		if (Modifier.GetTags().HasAnyExact(Tags))
 		{
-			Result.Add(Modifier);
+			Result.Add(Modifier.Expand());
 		}
 	}
 	
 	return Result;
 }
+
+bool FNoctAttribute::Serialize(FArchive& Ar)
+{
+	if (Ar.IsCountingMemory())
+	{
+		FlatModifiers.CountBytes(Ar);
+		PercentModifiers.CountBytes(Ar);
+		return true;
+	}
+
+	FNoctSerializedAttribute Serialized;
+	Serialized.MaxValue = MaxValue;
+	Serialized.CurrentValue = CurrentValue;
+	Serialized.BaseValue = BaseValue;
+	if (!Ar.IsLoading())
+	{
+		for (const FNoctCompactModifier& Modifier : FlatModifiers)
+		{
+			Serialized.FlatModifiers.Add(Modifier.Expand());
+		}
+		for (const FNoctCompactModifier& Modifier : PercentModifiers)
+		{
+			Serialized.PercentModifiers.Add(Modifier.Expand());
+		}
+	}
+
+	FNoctSerializedAttribute::StaticStruct()->SerializeItem(Ar, &Serialized, nullptr);
+
+	if (Ar.IsLoading())
+	{
+		MaxValue = Serialized.MaxValue;
+		CurrentValue = Serialized.CurrentValue;
+		BaseValue = Serialized.BaseValue;
+
+		// Made directly rather than added, so stacks come back as they were saved instead of stacking again
+		FlatModifiers.Reset(Serialized.FlatModifiers.Num());
+		for (const FNoctAttributeModifier& Modifier : Serialized.FlatModifiers)
+		{
+			FlatModifiers.Add(FNoctCompactModifier::Make(Modifier));
+		}
+		PercentModifiers.Reset(Serialized.PercentModifiers.Num());
+		for (const FNoctAttributeModifier& Modifier : Serialized.PercentModifiers)
+		{
+			PercentModifiers.Add(FNoctCompactModifier::Make(Modifier));
+		}
+	}
+	return true;
+}
+
+bool FNoctAttribute::Identical(const FNoctAttribute* Other, uint32 PortFlags) const
+{
+	// Handles are per session, so they don't count
+	const auto SameModifiers = [](const TArray<FNoctCompactModifier>& A, const TArray<FNoctCompactModifier>& B)
+	{
+		if (A.Num() != B.Num())
+		{
+			return false;
+		}
+		for (int32 i = 0; i < A.Num(); ++i)
+		{
+			if (A[i].Value != B[i].Value
+				|| A[i].SourceIndex != B[i].SourceIndex
+				|| A[i].TagSetIndex != B[i].TagSetIndex
+				|| A[i].StackTagIndex != B[i].StackTagIndex
+				|| A[i].StackCount != B[i].StackCount
+				|| A[i].MaxStacks != B[i].MaxStacks
+				|| A[i].StackingPolicy != B[i].StackingPolicy)
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	return Other
+		&& MaxValue == Other->MaxValue
+		&& CurrentValue == Other->CurrentValue
+		&& BaseValue == Other->BaseValue
+		&& SameModifiers(FlatModifiers, Other->FlatModifiers)
+		&& SameModifiers(PercentModifiers, Other->PercentModifiers);
+}
@@ -0,0 +1,181 @@
+﻿// Copyright Nocturnum Games 2023 
+
+
+#include "NoctCompactModifier.h"
+#include "NoctAbilitySystem.h"
+#include "NoctAttribute.h"
+#include "NoctTagContainerRegistry.h"
+
+FNoctCompactModifier FNoctCompactModifier::Make(const FNoctAttributeModifier& Modifier)
+{
+	FNoctModifierTables& Tables = FNoctModifierTables::Get();
+
+	FNoctCompactModifier Compact;
+	Compact.Value = Modifier.Value;
+	Compact.Handle = Tables.MakeHandle();
+	Compact.SourceIndex = Tables.InternSource(Modifier.Source);
+	Compact.TagSetIndex = FNoctTagContainerRegistry::Get().Intern(Modifier.Tags);
+	Compact.StackTagIndex = Tables.InternStackTag(Modifier.StackTag);
+	Compact.StackCount = static_cast<uint16>(FMath::Clamp(Modifier.StackCount, 0, MAX_uint16));
+	Compact.MaxStacks = static_cast<uint16>(FMath::Clamp(Modifier.MaxStacks, 0, MAX_uint16));
+	Compact.bIsPercentage = Modifier.bIsPercentage;
+	Compact.StackingPolicy = static_cast<uint8>(Modifier.StackingPolicy);
+	return Compact;
+}
+
+FNoctAttributeModifier FNoctCompactModifier::Expand() const
+{
+	FNoctAttributeModifier Modifier(Value, bIsPercentage, GetSource());
+	Modifier.Handle = Handle;
+	Modifier.Tags = GetTags();
+	Modifier.StackTag = GetStackTag();
+	Modifier.StackingPolicy = GetStackingPolicy();
+	Modifier.StackCount = StackCount;
+	Modifier.MaxStacks = MaxStacks;
+	return Modifier;
+}
+
+const FGameplayTagContainer& FNoctCompactModifier::GetTags() const
+{
+	return FNoctTagContainerRegistry::Get().GetContainer(TagSetIndex);
+}
+
+FGameplayTag FNoctCompactModifier::GetStackTag() const
+{
+	return FNoctModifierTables::Get().GetStackTag(StackTagIndex);
+}
+
+UObject* FNoctCompactModifier::GetSource() const
+{
+	return FNoctModifierTables::Get().GetSource(SourceIndex);
+}
+
+FNoctModifierTables& FNoctModifierTables::Get()
+{
+	static FNoctModifierTables Tables;
+	return Tables;
+}
+
+FNoctModifierTables::FNoctModifierTables()
+{
+	Sources.AddDefaulted();
+	StackTags.AddDefaulted();
+}
+
+uint32 FNoctModifierTables::InternSource(const UObject* Source)
+{
+	if (!Source)
+	{
+		return 0;
+	}
+
+	// The key includes the object's serial number, so a new object at a recycled slot gets its own entry
+	const FObjectKey Key(Source);
+
+	// Nearly every call finds a source that's already there
+	{
+		FReadScopeLock ReadLock(Lock);
+		if (const uint32* Index = SourceIndices.Find(Key))
+		{
+			return *Index;
+		}
+	}
+
+	FWriteScopeLock WriteLock(Lock);
+
+	// Another thread may have added it between the locks
+	if (const uint32* Index = SourceIndices.Find(Key))
+	{
+		return *Index;
+	}
+
+	if (FreeSourceSlots.IsEmpty() && Sources.Num() >= ReclaimSourcesAt)
+	{
+		ReclaimStaleSourcesLocked();
+	}
+
+	uint32 Index;
+	if (FreeSourceSlots.Num() > 0)
+	{
+		// Next generation of the slot, so modifiers still holding the old index don't see the new source
+		const uint32 Slot = FreeSourceSlots.Pop(EAllowShrinking::No);
+		Index = Slot | ((Sources[Slot].Index + (1u << 24)) & ~SourceSlotMask);
+	}
+	else
+	{
+		checkf(static_cast<uint32>(Sources.Num()) <= SourceSlotMask, TEXT("Modifier source table is full"));
+		Index = Sources.AddDefaulted();
+	}
+
+	FSourceEntry& Entry = Sources[Index & SourceSlotMask];
+	Entry.Object = Source;
+	Entry.Key = Key;
+	Entry.Index = Index;
+
+	SourceIndices.Add(Key, Index);
+	return Index;
+}
+
+void FNoctModifierTables::ReclaimStaleSources()
+{
+	FWriteScopeLock WriteLock(Lock);
+	ReclaimStaleSourcesLocked();
+}
+
+void FNoctModifierTables::ReclaimStaleSourcesLocked()
+{
+	// Slot 0 is no source
+	for (int32 Slot = 1; Slot < Sources.Num(); ++Slot)
+	{
+		FSourceEntry& Entry = Sources[Slot];
+		if (Entry.Key != FObjectKey() && Entry.Object.IsStale())
+		{
+			SourceIndices.Remove(Entry.Key);
+			Entry.Object.Reset();
+			Entry.Key = FObjectKey();
+			FreeSourceSlots.Add(Slot);
+		}
+	}
+
+	ReclaimSourcesAt = FMath::Max(1024, 2 * (Sources.Num() - FreeSourceSlots.Num()));
+}
+
+SIZE_T FNoctModifierTables::GetAllocatedSize() const
+{
+	FReadScopeLock ReadLock(Lock);
+	return Sources.GetAllocatedSize() + SourceIndices.GetAllocatedSize() + FreeSourceSlots.GetAllocatedSize()
+		+ StackTags.GetAllocatedSize() + StackTagIndices.GetAllocatedSize();
+}
+
+uint16 FNoctModifierTables::InternStackTag(const FGameplayTag& Tag)
+{
+	if (!Tag.IsValid())
+	{
+		return 0;
+	}
+
+	{
+		FReadScopeLock ReadLock(Lock);
+		if (const uint16* Index = StackTagIndices.Find(Tag))
+		{
+			return *Index;
+		}
+	}
+
+	FWriteScopeLock WriteLock(Lock);
+
+	if (const uint16* Index = StackTagIndices.Find(Tag))
+	{
+		return *Index;
+	}
+
+	if (StackTags.Num() > MAX_uint16)
+	{
+		UE_LOG(LogNoctAbilitySystem, Error, TEXT("Modifier stack tag table is full, %s doesn't stack"), *Tag.ToString());
+		return 0;
+	}
+
+	const uint16 Index = static_cast<uint16>(StackTags.Add(Tag));
+	StackTagIndices.Add(Tag, Index);
+	return Index;
+}
@@ -0,0 +1,142 @@
+﻿// Copyright Nocturnum Games 2023 
+
+
+#include "NoctCooldownTable.h"
+#include "Algo/BinarySearch.h"
+
+int32 FNoctCooldownEntry::GetCharges(const double Now) const
+{
+	// Ready times are sorted, everything past the upper bound is still recharging
+	const int32 NumRecharging = ChargeReadyTimes.Num() - Algo::UpperBound(ChargeReadyTimes, Now);
+	return FMath::Max(MaxCharges - NumRecharging, 0);
+}
+
+double FNoctCooldownEntry::GetNextChargeTime(const double Now) const
+{
+	const int32 Index = Algo::UpperBound(ChargeReadyTimes, Now);
+	return ChargeReadyTimes.IsValidIndex(Index) ? ChargeReadyTimes[Index] : 0.0;
+}
+
+void FNoctCooldownTable::Start(const FGameplayTag Tag, const double Now, const float Duration)
+{
+	FNoctCooldownEntry& Entry = FindOrAddEntry(Tag);
+	Entry.EndTime = Now + Duration;
+	Entry.Duration = Duration;
+
+	ActiveTags.AddTag(Tag);
+	ExpiryHeap.HeapPush(FExpiry{ Entry.EndTime, Tag }, FExpiryPredicate());
+}
+
+void FNoctCooldownTable::Clear(const FGameplayTag Tag)
+{
+	if (const int32* Index = IndexByTag.Find(Tag))
+	{
+		Entries[*Index].EndTime = 0.0;
+		Entries[*Index].ChargeReadyTimes.Reset();
+		ActiveTags.RemoveTag(Tag);
+		RemoveExpiries(Tag);
+	}
+}
+
+void FNoctCooldownTable::SpendCharge(const FGameplayTag Tag, const double Now, const int32 MaxCharges, const float RechargeTime, const ENoctChargeRechargePolicy RechargePolicy)
+{
+	FNoctCooldownEntry& Entry = FindOrAddEntry(Tag);
+	Entry.MaxCharges = MaxCharges;
+	Entry.Duration = RechargeTime;
+
+	// Forget the charges that are back
+	const int32 NumReady = Algo::UpperBound(Entry.ChargeReadyTimes, Now);
+	Entry.ChargeReadyTimes.RemoveAt(0, NumReady, EAllowShrinking::No);
+
+	if (Entry.ChargeReadyTimes.Num() >= MaxCharges)
+	{
+		return;
+	}
+
+	const double ReadyTime = RechargePolicy == ENoctChargeRechargePolicy::Sequential && Entry.ChargeReadyTimes.Num() > 0
+		? Entry.ChargeReadyTimes.Last() + RechargeTime
+		: Now + RechargeTime;
+	Entry.ChargeReadyTimes.Insert(ReadyTime, Algo::UpperBound(Entry.ChargeReadyTimes, ReadyTime));
+
+	// Out of charges, on cooldown until the soonest one is back
+	if (Entry.ChargeReadyTimes.Num() == MaxCharges)
+	{
+		Entry.EndTime = Entry.ChargeReadyTimes[0];
+		ActiveTags.AddTag(Tag);
+		ExpiryHeap.HeapPush(FExpiry{ Entry.EndTime, Tag }, FExpiryPredicate());
+	}
+}
+
+void FNoctCooldownTable::SetEndTime(const FGameplayTag Tag, const double Now, const double EndTime)
+{
+	FindOrAddEntry(Tag).EndTime = EndTime;
+
+	if (EndTime > Now)
+	{
+		ActiveTags.AddTag(Tag);
+		ExpiryHeap.HeapPush(FExpiry{ EndTime, Tag }, FExpiryPredicate());
+	}
+	else
+	{
+		ActiveTags.RemoveTag(Tag);
+		RemoveExpiries(Tag);
+	}
+}
+
+void FNoctCooldownTable::Restore(const FNoctCooldownEntry& Entry, const double Now)
+{
+	FindOrAddEntry(Entry.Tag) = Entry;
+	SetEndTime(Entry.Tag, Now, Entry.EndTime);
+}
+
+float FNoctCooldownTable::GetRemaining(const FGameplayTag Tag, const double Now) const
+{
+	const FNoctCooldownEntry* Entry = Find(Tag);
+	return Entry ? static_cast<float>(FMath::Max(Entry->EndTime - Now, 0.0)) : 0.0f;
+}
+
+bool FNoctCooldownTable::PopExpired(const double Now, FGameplayTag& OutTag)
+{
+	while (ExpiryHeap.Num() > 0 && ExpiryHeap.HeapTop().EndTime <= Now)
+	{
+		FExpiry Expiry;
+		ExpiryHeap.HeapPop(Expiry, FExpiryPredicate(), EAllowShrinking::No);
+
+		// Only the newest expiry of a cooldown that is still running counts
+		const FNoctCooldownEntry* Entry = Find(Expiry.Tag);
+		if (Entry && Entry->EndTime == Expiry.EndTime && ActiveTags.HasTagExact(Expiry.Tag))
+		{
+			ActiveTags.RemoveTag(Expiry.Tag);
+			OutTag = Expiry.Tag;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FNoctCooldownTable::RemoveExpiries(const FGameplayTag Tag)
+{
+	const int32 NumRemoved = ExpiryHeap.RemoveAll([Tag](const FExpiry& Expiry)
+	{
+		return Expiry.Tag == Tag;
+	});
+
+	if (NumRemoved > 0)
+	{
+		ExpiryHeap.Heapify(FExpiryPredicate());
+	}
+}
+
+FNoctCooldownEntry& FNoctCooldownTable::FindOrAddEntry(const FGameplayTag Tag)
+{
+	if (const int32* Index = IndexByTag.Find(Tag))
+	{
+		return Entries[*Index];
+	}
+
+	const int32 NewIndex = Entries.AddDefaulted();
+	Entries[NewIndex].Tag = Tag;
+	IndexByTag.Add(Tag, NewIndex);
+	return Entries[NewIndex];
+}
@@ -0,0 +1,15 @@
+﻿// Copyright Nocturnum Games 2023 
+
+
+#include "NoctCue.h"
+
+void UNoctCueHandler::HandleCue(AActor* Target, const FNoctCue& Cue)
+{
+	OnCue(Target, Cue.CueTag, Cue.Event, Cue.Magnitude);
+}
+
+UWorld* UNoctCueHandler::GetWorld() const
+{
+	// Instances live in the subsystem of the world they show cues in, which gives Blueprints a world context
+	return HasAnyFlags(RF_ClassDefaultObject) ? nullptr : GetOuter()->GetWorld();
+}
@@ -3,58 +3,297 @@
 
 #include "NoctEffect.h"
 #include "NoctAbilityComponent.h"
+#include "NoctAbilitySystemTrace.h"
+#include "NoctAbilityRecorder.h"
+#include "UObject/ObjectSaveContext.h"
 
 UNoctEffect::UNoctEffect()
 {
 	OwningAbilityComponent = Cast<UNoctAbilityComponent>(GetOuter());
 }
 
+void UNoctEffect::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	// Instances normally inherit the table from their archetype, this only bakes when that one is missing or stale.
+	// Loaded objects don't have their properties yet, they are baked in PostLoad instead.
+	if (!HasAnyFlags(RF_NeedLoad) && !MagnitudeScalingTable.IsBakedFrom(MagnitudeScalingCurve, MaxLevel))
+	{
+		BakeScalingTables();
+	}
+}
+
+void UNoctEffect::PostLoad()
+{
+	Super::PostLoad();
+
+	// The editor always re-bakes, the curve assets may have been edited since the table was saved
+	if (GIsEditor || !MagnitudeScalingTable.IsBakedFrom(MagnitudeScalingCurve, MaxLevel))
+	{
+		BakeScalingTables();
+	}
+}
+
+void UNoctEffect::PreSave(const FObjectPreSaveContext SaveContext)
+{
+	// Baked on save so cooked class defaults ship with their tables
+	BakeScalingTables();
+
+	Super::PreSave(SaveContext);
+}
+
+#if WITH_EDITOR
+void UNoctEffect::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	BakeScalingTables();
+
+	AppliedTags.SyncFromEditorTags();
+	BlockedTags.SyncFromEditorTags();
+	AbilitiesToCancel.SyncFromEditorTags();
+	CueTags.SyncFromEditorTags();
+}
+#endif
+
+void UNoctEffect::BakeScalingTables()
+{
+	MagnitudeScalingTable.Bake(MagnitudeScalingCurve, MaxLevel);
+}
+
 void UNoctEffect::EffectDurationCompleted()
 {
-	OwningAbilityComponent->RemoveEffect(this);
+	OwningAbilityComponent->RemoveEffect(this, true);
 }
 
 bool UNoctEffect::EffectApplied()
 {
+	const double Now = GetWorld()->GetTimeSeconds();
+	CurrentTriggerTime = Now;
+	
 	if(bPermanent)
 	{
 		NativeEffectTriggered();
 	}
 	else
 	{
-		GetWorld()->GetTimerManager().SetTimer(EffectDurationTimerHandle, this, &UNoctEffect::EffectDurationCompleted, Duration, false);
-		GetWorld()->GetTimerManager().SetTimer(EffectTimerHandle, this, &UNoctEffect::NativeEffectTriggered, TriggerInterval, true);
+		// One shot effects trigger straight away and then only wait out their duration
+		if(bOneShotEffect)
+		{
+			NativeEffectTriggered();
+		}
+		Timeline.Start(Now, Duration, TriggerInterval, !bOneShotEffect);
 	}
 	
-	OnEffectApplied();
+	if(ShouldRunBlueprintEvents())
+	{
+		OnEffectApplied();
+	}
+	SendCues(ENoctCueEvent::Applied);
 
 	bIsActiveAndApplied = true;
 
-	OwningAbilityComponent->CancelAbilities(AbilitiesToCancel);
+	if(!bPermanent)
+	{
+		OwningAbilityComponent->TimedEffectAdded();
+	}
+
+	if(!AbilitiesToCancel.IsEmpty())
+	{
+		OwningAbilityComponent->CancelAbilities(AbilitiesToCancel.Get());
+	}
+	if(!AbilityCancelQuery.IsEmpty())
+	{
+		OwningAbilityComponent->CancelAbilitiesByQuery(AbilityCancelQuery);
+	}
 	
 	return true;
 }
 
 void UNoctEffect::EffectRemoved()
 {
-	// If the effect interval is still running, and close to 0, clear it and trigger the effect one last time.
-	// This is to avoid the effect being removed before the last interval is triggered.
-	if(FMath::IsNearlyZero(GetWorld()->GetTimerManager().GetTimerRemaining(EffectTimerHandle)))
+	if(ShouldRunBlueprintEvents())
 	{
-		NativeEffectTriggered();
+		OnEffectRemoved();
 	}
-
-	GetWorld()->GetTimerManager().ClearTimer(EffectTimerHandle);
-	
-	OnEffectRemoved();
+	SendCues(ENoctCueEvent::Removed);
 	bIsActiveAndApplied = false;
 }
 
+void UNoctEffect::EffectResumed(const FNoctEffectTimeline& InTimeline)
+{
+	Timeline = InTimeline;
+	CurrentTriggerTime = GetWorld()->GetTimeSeconds();
+
+	if(ShouldRunBlueprintEvents())
+	{
+		OnEffectApplied();
+	}
+	SendCues(ENoctCueEvent::Applied);
+
+	bIsActiveAndApplied = true;
+	OwningAbilityComponent->TimedEffectAdded();
+}
+
 void UNoctEffect::NativeEffectTriggered()
 {
+	INC_DWORD_STAT(STAT_NoctEffectsTriggered);
+	NOCT_TRACE_EFFECT_TRIGGER_SCOPE(this);
+	NOCT_RECORD(RecordEffect(ENoctRecordedEventType::EffectTriggered, OwningAbilityComponent, this));
+	NOCT_RECORD_NESTED_SCOPE();
+
+	SendCues(ENoctCueEvent::Triggered);
+
+	// Gameplay, so this runs on dedicated servers too
+	if(bApplyAttributeOperationNatively)
+	{
+		if(FNoctAttribute* Attribute = OwningAbilityComponent->FindAttribute(TargetAttributeTag))
+		{
+			Attribute->BaseValue = ApplyAttributeOperation(AttributeOperation, Attribute->BaseValue, AppliedMagnitude);
+			Attribute->CurrentValue = Attribute->CalculateValue();
+		}
+	}
+
+	if(!ShouldRunBlueprintEvents())
+	{
+		return;
+	}
+
+	// Shows up per effect class under stat uobjects, and as a named scope in Insights
+	FScopeCycleCounterUObject ClassScope(GetClass());
+	
 	OnEffectTriggered();
 }
 
+float UNoctEffect::ApplyAttributeOperation(const ENoctAttributeOperation Operation, const float Value, const float Magnitude)
+{
+	switch (Operation)
+	{
+	case ENoctAttributeOperation::Add:
+		return Value + Magnitude;
+	case ENoctAttributeOperation::Subtract:
+		return Value - Magnitude;
+	case ENoctAttributeOperation::Multiply:
+		return Value * Magnitude;
+	case ENoctAttributeOperation::Divide:
+		return Magnitude != 0.0f ? Value / Magnitude : Value;
+	case ENoctAttributeOperation::Set:
+		return Magnitude;
+	}
+	return Value;
+}
+
+bool UNoctEffect::ShouldRunBlueprintEvents() const
+{
+	// Net mode rather than IsRunningDedicatedServer, so a dedicated server started from the editor skips them too
+	const UWorld* World = GetWorld();
+	if(bCosmeticBlueprintEvents && World && World->GetNetMode() == NM_DedicatedServer)
+	{
+		INC_DWORD_STAT(STAT_NoctCosmeticEventsSkipped);
+		return false;
+	}
+	return true;
+}
+
+void UNoctEffect::SendCues(const ENoctCueEvent Event) const
+{
+	if(CueTags.IsEmpty())
+	{
+		return;
+	}
+
+	if (UNoctAbilitySubsystem* Subsystem = UNoctAbilitySubsystem::Get(GetWorld()))
+	{
+		Subsystem->QueueCues(OwningAbilityComponent, CueTags.Get(), Event, AppliedMagnitude);
+	}
+}
+
+void UNoctEffect::AdvanceTimeline(const double Now)
+{
+	if(!IsTimed())
+	{
+		return;
+	}
+
+	// Catch up on every trigger that came due since the last advance, in order and with their scheduled times
+	const bool bStillApplied = Timeline.Advance(Now, [this](const double TriggerTime)
+	{
+		CurrentTriggerTime = TriggerTime;
+		NativeEffectTriggered();
+
+		// The trigger itself may have removed the effect
+		return bIsActiveAndApplied;
+	});
+
+	if(!bStillApplied)
+	{
+		return;
+	}
+
+	if(Timeline.IsExpired(Now))
+	{
+		EffectDurationCompleted();
+	}
+}
+
+FNoctEffectSpec UNoctEffect::MakeEffectSpec(const TSubclassOf<UNoctEffect> EffectClass, const int32 InLevel)
+{
+	FNoctEffectSpec Spec;
+
+	if (const UNoctEffect* DefaultEffect = EffectClass ? EffectClass->GetDefaultObject<UNoctEffect>() : nullptr)
+	{
+		Spec.EffectClass = EffectClass;
+		Spec.Level = InLevel > 0 ? FMath::Min(InLevel, DefaultEffect->MaxLevel) : DefaultEffect->Level;
+		Spec.Magnitude = DefaultEffect->GetMagnitudeAtLevel(Spec.Level);
+		Spec.EffectTag = DefaultEffect->EffectTag;
+	}
+
+	return Spec;
+}
+
+void UNoctEffect::InitializeFromSpec(const FNoctEffectSpec& Spec)
+{
+	Level = Spec.Level;
+	AppliedMagnitude = Spec.Magnitude;
+}
+
+void UNoctEffect::ResetForReuse()
+{
+	// Blueprints are free to change any of the effect's properties while it is applied,
+	// so put every non transient property back to the class default before reuse.
+	const UNoctEffect* DefaultEffect = GetClass()->GetDefaultObject<UNoctEffect>();
+	for (TFieldIterator<FProperty> It(GetClass()); It; ++It)
+	{
+		if (!It->HasAnyPropertyFlags(CPF_Transient))
+		{
+			It->CopyCompleteValue_InContainer(this, DefaultEffect);
+		}
+	}
+
+	OwningAbilityComponent = Cast<UNoctAbilityComponent>(GetOuter());
+}
+
+void FNoctEffectTimeline::Start(const double Now, const float InDuration, const float InTriggerInterval, const bool bPeriodic)
+{
+	StartTime = Now;
+	Duration = InDuration;
+	TriggerInterval = InTriggerInterval;
+	TriggersFired = 0;
+	TotalTriggers = bPeriodic && TriggerInterval > 0.0f ? FMath::FloorToInt32(Duration / TriggerInterval + UE_KINDA_SMALL_NUMBER) : 0;
+}
+
+int32 FNoctEffectTimeline::GetTriggersDue(const double Now) const
+{
+	if(TriggersFired >= TotalTriggers)
+	{
+		return 0;
+	}
+
+	const int32 TriggersElapsed = FMath::FloorToInt32((Now - StartTime) / TriggerInterval + UE_KINDA_SMALL_NUMBER);
+	return FMath::Clamp(TriggersElapsed, 0, TotalTriggers) - TriggersFired;
+}
+
 UWorld* UNoctEffect::GetWorld() const
 {
 	return OwningAbilityComponent ? OwningAbilityComponent->GetWorld() : nullptr;
@@ -0,0 +1,47 @@
+﻿// Copyright Nocturnum Games 2023
+
+
+#include "NoctPrediction.h"
+
+FNoctPredictionKey FNoctPredictionKey::MakeNext(const FNoctPredictionKey Previous)
+{
+	FNoctPredictionKey Next;
+	Next.Value = Previous.Value == MAX_int32 ? 1 : Previous.Value + 1;
+	return Next;
+}
+
+void FNoctPredictionRecord::RecordCooldown(const FGameplayTag Tag, const FNoctCooldownTable& CooldownTable)
+{
+	const bool bAlreadyRecorded = Cooldowns.ContainsByPredicate([Tag](const FNoctPredictedCooldown& Cooldown)
+	{
+		return Cooldown.Entry.Tag == Tag;
+	});
+
+	if (bAlreadyRecorded)
+	{
+		return;
+	}
+
+	// A tag without an entry is restored as an empty one, which is the same as no cooldown
+	FNoctPredictedCooldown& Cooldown = Cooldowns.AddDefaulted_GetRef();
+	if (const FNoctCooldownEntry* Entry = CooldownTable.Find(Tag))
+	{
+		Cooldown.Entry = *Entry;
+	}
+	Cooldown.Entry.Tag = Tag;
+}
+
+void FNoctPredictionRecord::RecordAttributeDelta(const FGameplayTag AttributeTag, const float Delta)
+{
+	if (FNoctPredictedAttributeDelta* Existing = AttributeDeltas.FindByPredicate([AttributeTag](const FNoctPredictedAttributeDelta& Entry)
+	{
+		return Entry.AttributeTag == AttributeTag;
+	}))
+	{
+		Existing->Delta += Delta;
+	}
+	else
+	{
+		AttributeDeltas.Add({AttributeTag, Delta});
+	}
+}
@@ -0,0 +1,31 @@
+﻿// Copyright Nocturnum Games 2023 
+
+
+#include "NoctScalingTable.h"
+#include "HAL/IConsoleManager.h"
+
+#if WITH_EDITOR
+bool FNoctScalingTable::bReadCurvesLive = false;
+
+static FAutoConsoleVariableRef CVarReadScalingCurvesLive(
+	TEXT("NoctAbilitySystem.ReadScalingCurvesLive"),
+	FNoctScalingTable::bReadCurvesLive,
+	TEXT("Evaluate level scaling curves directly instead of their baked tables, so curve edits show up while playing in editor."));
+#endif
+
+void FNoctScalingTable::Bake(UCurveFloat* Curve, const int32 MaxLevel)
+{
+	SourceCurve = Curve;
+	Values.Reset();
+
+	if (!Curve)
+	{
+		return;
+	}
+
+	Values.SetNumUninitialized(GetNumLevels(MaxLevel));
+	for (int32 Level = 0; Level < Values.Num(); ++Level)
+	{
+		Values[Level] = Curve->GetFloatValue(Level);
+	}
+}
@@ -0,0 +1,118 @@
+﻿// Copyright Nocturnum Games 2023 
+
+
+#include "NoctSharedTagContainer.h"
+#include "NoctTagContainerRegistry.h"
+#include "UObject/PropertyTag.h"
+
+FNoctSharedTagContainer::FNoctSharedTagContainer(const FGameplayTagContainer& Tags)
+{
+	Set(Tags);
+}
+
+const FGameplayTagContainer& FNoctSharedTagContainer::Get() const
+{
+	return FNoctTagContainerRegistry::Get().GetContainer(Index);
+}
+
+void FNoctSharedTagContainer::Set(const FGameplayTagContainer& Tags)
+{
+	Index = FNoctTagContainerRegistry::Get().Intern(Tags);
+#if WITH_EDITORONLY_DATA
+	EditorTags = Tags;
+#endif
+}
+
+void FNoctSharedTagContainer::AddTag(const FGameplayTag& Tag)
+{
+	if (!Get().HasTagExact(Tag))
+	{
+		FGameplayTagContainer Tags = Get();
+		Tags.AddTag(Tag);
+		Set(Tags);
+	}
+}
+
+void FNoctSharedTagContainer::RemoveTag(const FGameplayTag& Tag)
+{
+	if (Get().HasTagExact(Tag))
+	{
+		FGameplayTagContainer Tags = Get();
+		Tags.RemoveTag(Tag);
+		Set(Tags);
+	}
+}
+
+void FNoctSharedTagContainer::AppendTags(const FGameplayTagContainer& Tags)
+{
+	if (!Tags.IsEmpty())
+	{
+		FNoctTagContainerRegistry& Registry = FNoctTagContainerRegistry::Get();
+		Index = Registry.InternUnion(Index, Registry.Intern(Tags));
+#if WITH_EDITORONLY_DATA
+		EditorTags = Get();
+#endif
+	}
+}
+
+void FNoctSharedTagContainer::Reset()
+{
+	Set(FGameplayTagContainer::EmptyContainer);
+}
+
+bool FNoctSharedTagContainer::Serialize(FArchive& Ar)
+{
+	FGameplayTagContainer Tags = Get();
+	FGameplayTagContainer::StaticStruct()->SerializeItem(Ar, &Tags, nullptr);
+
+	if (Ar.IsLoading())
+	{
+		Set(Tags);
+	}
+	return true;
+}
+
+bool FNoctSharedTagContainer::SerializeFromMismatchedTag(const FPropertyTag& Tag, FStructuredArchive::FSlot Slot)
+{
+	// Saved before the property was shared
+	if (Tag.Type == NAME_StructProperty && Tag.StructName == FGameplayTagContainer::StaticStruct()->GetFName())
+	{
+		FGameplayTagContainer Tags;
+		FGameplayTagContainer::StaticStruct()->SerializeItem(Slot, &Tags, nullptr);
+		Set(Tags);
+		return true;
+	}
+	return false;
+}
+
+bool FNoctSharedTagContainer::Identical(const FNoctSharedTagContainer* Other, uint32 PortFlags) const
+{
+	return Other && Index == Other->Index;
+}
+
+bool FNoctSharedTagContainer::ExportTextItem(FString& ValueStr, const FNoctSharedTagContainer& DefaultValue, UObject* Parent, const int32 PortFlags, UObject* ExportRootScope) const
+{
+	FGameplayTagContainer::StaticStruct()->ExportText(ValueStr, &Get(), &DefaultValue.Get(), Parent, PortFlags, ExportRootScope);
+	return true;
+}
+
+bool FNoctSharedTagContainer::ImportTextItem(const TCHAR*& Buffer, const int32 PortFlags, UObject* Parent, FOutputDevice* ErrorText)
+{
+	FGameplayTagContainer Tags;
+	const TCHAR* Result = FGameplayTagContainer::StaticStruct()->ImportText(Buffer, &Tags, Parent, PortFlags, ErrorText, FGameplayTagContainer::StaticStruct()->GetName());
+	if (!Result)
+	{
+		return false;
+	}
+
+	Buffer = Result;
+	Set(Tags);
+	return true;
+}
+
+#if WITH_EDITOR
+void FNoctSharedTagContainer::SyncFromEditorTags()
+{
+	Index = FNoctTagContainerRegistry::Get().Intern(EditorTags);
+}
+#endif
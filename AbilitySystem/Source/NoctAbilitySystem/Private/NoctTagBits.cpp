@@ -0,0 +1,69 @@
+﻿// Copyright Nocturnum Games 2023 
+
+
+#include "NoctTagBits.h"
+#include "GameplayTagsManager.h"
+#include "NoctAbilitySystemSettings.h"
+
+const FNoctTagBitRegistry& FNoctTagBitRegistry::Get()
+{
+	static FNoctTagBitRegistry Registry;
+	return Registry;
+}
+
+FNoctTagBitRegistry::FNoctTagBitRegistry()
+{
+	const UGameplayTagsManager& TagsManager = UGameplayTagsManager::Get();
+	
+	for (const FGameplayTag& IndexedTag : GetDefault<UNoctAbilitySystemSettings>()->IndexedTags)
+	{
+		FGameplayTagContainer TagAndChildren = TagsManager.RequestGameplayTagChildren(IndexedTag);
+		TagAndChildren.AddTagFast(IndexedTag);
+
+		for (const FGameplayTag& Tag : TagAndChildren)
+		{
+			if (!BitByTag.Contains(Tag))
+			{
+				BitByTag.Add(Tag, Tags.Add(Tag));
+			}
+		}
+	}
+}
+
+bool FNoctTagBitRegistry::MakeExactBits(const FGameplayTagContainer& Container, FNoctTagBits& OutBits) const
+{
+	OutBits.Reset();
+	
+	bool bAllRegistered = true;
+	for (const FGameplayTag& Tag : Container)
+	{
+		const int32 Index = GetBitIndex(Tag);
+		if (Index != INDEX_NONE)
+		{
+			OutBits.SetBit(Index);
+		}
+		else
+		{
+			bAllRegistered = false;
+		}
+	}
+	return bAllRegistered;
+}
+
+void FNoctTagBitRegistry::MakeHierarchicalBits(const FGameplayTagContainer& Container, FNoctTagBits& OutBits) const
+{
+	OutBits.Reset();
+
+	if (Container.IsEmpty())
+	{
+		return;
+	}
+	
+	for (int32 Index = 0; Index < Tags.Num(); ++Index)
+	{
+		if (Tags[Index].MatchesAny(Container))
+		{
+			OutBits.SetBit(Index);
+		}
+	}
+}
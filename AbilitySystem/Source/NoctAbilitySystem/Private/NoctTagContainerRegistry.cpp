@@ -0,0 +1,137 @@
+﻿// Copyright Nocturnum Games 2023 
+
+
+#include "NoctTagContainerRegistry.h"
+#include "NoctAbilitySystem.h"
+
+FNoctTagContainerRegistry& FNoctTagContainerRegistry::Get()
+{
+	static FNoctTagContainerRegistry Registry;
+	return Registry;
+}
+
+FNoctTagContainerRegistry::FNoctTagContainerRegistry()
+{
+	// Index 0, the empty container
+	Chunks[0] = MakeUnique<FGameplayTagContainer[]>(FirstChunkSize);
+	NumContainers = 1;
+}
+
+uint32 FNoctTagContainerRegistry::Intern(const FGameplayTagContainer& Container)
+{
+	if (Container.IsEmpty())
+	{
+		return 0;
+	}
+
+	const uint32 Hash = HashContainer(Container);
+
+	const auto FindExisting = [this, Hash, &Container]() -> int32
+	{
+		for (auto It = IndicesByHash.CreateConstKeyIterator(Hash); It; ++It)
+		{
+			if (GetContainer(It.Value()) == Container)
+			{
+				return It.Value();
+			}
+		}
+		return INDEX_NONE;
+	};
+
+	// Nearly every call finds a container that's already there
+	{
+		FReadScopeLock ReadLock(Lock);
+		const int32 Existing = FindExisting();
+		if (Existing != INDEX_NONE)
+		{
+			return static_cast<uint32>(Existing);
+		}
+	}
+
+	FWriteScopeLock WriteLock(Lock);
+
+	// Another thread may have added it between the locks
+	const int32 Existing = FindExisting();
+	if (Existing != INDEX_NONE)
+	{
+		return static_cast<uint32>(Existing);
+	}
+
+	// Carrying on with the wrong tags would silently change what gets blocked and cancelled
+	if (NumContainers >= MaxContainers)
+	{
+		UE_LOG(LogNoctAbilitySystem, Fatal, TEXT("Tag container registry is full, all %d indices are taken. Couldn't intern %s"), MaxContainers, *Container.ToStringSimple());
+	}
+
+	const uint32 Index = static_cast<uint32>(NumContainers);
+	int32 ChunkIndex;
+	uint32 Slot;
+	Locate(Index, ChunkIndex, Slot);
+
+	TUniquePtr<FGameplayTagContainer[]>& Chunk = Chunks[ChunkIndex];
+	if (!Chunk)
+	{
+		Chunk = MakeUnique<FGameplayTagContainer[]>(FirstChunkSize << ChunkIndex);
+	}
+	Chunk[Slot] = Container;
+	++NumContainers;
+
+	IndicesByHash.Add(Hash, Index);
+	return Index;
+}
+
+uint32 FNoctTagContainerRegistry::InternUnion(const uint32 IndexA, const uint32 IndexB)
+{
+	if (IndexA == IndexB || IndexB == 0)
+	{
+		return IndexA;
+	}
+	if (IndexA == 0)
+	{
+		return IndexB;
+	}
+
+	FGameplayTagContainer Union = GetContainer(IndexA);
+	Union.AppendTags(GetContainer(IndexB));
+	return Intern(Union);
+}
+
+int32 FNoctTagContainerRegistry::Num() const
+{
+	FReadScopeLock ReadLock(Lock);
+	return NumContainers;
+}
+
+SIZE_T FNoctTagContainerRegistry::GetAllocatedSize() const
+{
+	FReadScopeLock ReadLock(Lock);
+
+	SIZE_T Size = IndicesByHash.GetAllocatedSize();
+	for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ++ChunkIndex)
+	{
+		Size += Chunks[ChunkIndex] ? (SIZE_T(FirstChunkSize) << ChunkIndex) * sizeof(FGameplayTagContainer) : 0;
+	}
+	for (int32 Index = 0; Index < NumContainers; ++Index)
+	{
+		Size += GetContainerAllocatedSize(GetContainer(static_cast<uint32>(Index)));
+	}
+	return Size;
+}
+
+SIZE_T FNoctTagContainerRegistry::GetContainerAllocatedSize(const FGameplayTagContainer& Container)
+{
+	// The parent tags aren't exposed, but they are what the container and its parents have beyond the explicit tags
+	const int32 NumParentTags = Container.GetGameplayTagParents().Num() - Container.Num();
+	return Container.GetGameplayTagArray().GetAllocatedSize() + NumParentTags * sizeof(FGameplayTag);
+}
+
+uint32 FNoctTagContainerRegistry::HashContainer(const FGameplayTagContainer& Container)
+{
+	// Summed so the order tags were added in doesn't matter, like container equality
+	uint32 Hash = 0;
+	for (const FGameplayTag& Tag : Container)
+	{
+		Hash += GetTypeHash(Tag) * 0x9E3779B1u;
+	}
+	return HashCombineFast(Hash, Container.Num());
+}
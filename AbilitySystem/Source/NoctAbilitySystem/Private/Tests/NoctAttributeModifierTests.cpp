@@ -0,0 +1,148 @@
+﻿// Copyright Nocturnum Games 2023 
+
+
+#include "NoctAttribute.h"
+#include "NoctEffect.h"
+#include "NoctTagContainerRegistry.h"
+#include "GameplayTagsManager.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/ObjectReader.h"
+#include "Serialization/ObjectWriter.h"
+#include "UObject/StrongObjectPtr.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace NoctAttributeModifierTests
+{
+	constexpr auto TestFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext
+		| EAutomationTestFlags::ServerContext | EAutomationTestFlags::CommandletContext | EAutomationTestFlags::EngineFilter;
+
+	// Tag sets of one or two of the project's tags, empty if the project has none
+	TArray<FGameplayTagContainer> MakeTagSets(const int32 NumSets)
+	{
+		FGameplayTagContainer AllTags;
+		UGameplayTagsManager::Get().RequestAllGameplayTags(AllTags, true);
+		const TArray<FGameplayTag>& Tags = AllTags.GetGameplayTagArray();
+
+		TArray<FGameplayTagContainer> TagSets;
+		for (int32 Index = 0; Index < NumSets && Tags.Num() > 0; ++Index)
+		{
+			FGameplayTagContainer& TagSet = TagSets.AddDefaulted_GetRef();
+			TagSet.AddTag(Tags[Index % Tags.Num()]);
+			if (Index % 2 == 1)
+			{
+				TagSet.AddTag(Tags[(Index * 7 + 3) % Tags.Num()]);
+			}
+		}
+		return TagSets;
+	}
+
+	SIZE_T GetTablesAllocatedSize()
+	{
+		return FNoctModifierTables::Get().GetAllocatedSize() + FNoctTagContainerRegistry::Get().GetAllocatedSize();
+	}
+}
+
+/**
+ * Heap memory of 10,000 modifiers from 1,000 sources with 50 tag sets, stored compact compared to stored as
+ * FNoctAttributeModifier the way attributes held them before. The shared tables count with what they grew by.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNoctAttributeModifierMemoryTest, "NoctAbilitySystem.Attribute.ModifierMemory", NoctAttributeModifierTests::TestFlags)
+
+bool FNoctAttributeModifierMemoryTest::RunTest(const FString& Parameters)
+{
+	using namespace NoctAttributeModifierTests;
+
+	constexpr int32 NumModifiers = 10000;
+	constexpr int32 NumSources = 1000;
+
+	TArray<TStrongObjectPtr<UNoctEffect>> Sources;
+	for (int32 Index = 0; Index < NumSources; ++Index)
+	{
+		Sources.Emplace(NewObject<UNoctEffect>());
+	}
+	const TArray<FGameplayTagContainer> TagSets = MakeTagSets(50);
+
+	const SIZE_T TablesBefore = GetTablesAllocatedSize();
+
+	FNoctAttribute Attribute;
+	Attribute.Initialize(100.0f, 1000.0f);
+	for (int32 Index = 0; Index < NumModifiers; ++Index)
+	{
+		FNoctAttributeModifier Modifier(0.01f, Index % 4 == 0, Sources[Index % NumSources].Get());
+		if (TagSets.Num() > 0)
+		{
+			Modifier.Tags = TagSets[Index % TagSets.Num()];
+		}
+		Attribute.AddModifier(Modifier);
+	}
+
+	const SIZE_T TableBytes = GetTablesAllocatedSize() - TablesBefore;
+	const SIZE_T CompactBytes = Attribute.FlatModifiers.GetAllocatedSize() + Attribute.PercentModifiers.GetAllocatedSize();
+
+	const TArray<FNoctAttributeModifier> Modifiers = Attribute.GetModifiers();
+	TestEqual(TEXT("Modifiers"), Modifiers.Num(), NumModifiers);
+
+	SIZE_T FullBytes = Modifiers.GetAllocatedSize();
+	for (const FNoctAttributeModifier& Modifier : Modifiers)
+	{
+		FullBytes += FNoctTagContainerRegistry::GetContainerAllocatedSize(Modifier.Tags);
+	}
+
+	AddInfo(FString::Printf(TEXT("%d modifiers, %d sources, %d tag sets"), NumModifiers, NumSources, TagSets.Num()));
+	AddInfo(FString::Printf(TEXT("Full: %llu bytes (%d inline per modifier)"), static_cast<uint64>(FullBytes), static_cast<int32>(sizeof(FNoctAttributeModifier))));
+	AddInfo(FString::Printf(TEXT("Compact: %llu bytes (%d inline per modifier) + %llu bytes of table growth"),
+		static_cast<uint64>(CompactBytes), static_cast<int32>(sizeof(FNoctCompactModifier)), static_cast<uint64>(TableBytes)));
+
+	TestTrue(TEXT("Compact modifiers use less memory"), CompactBytes + TableBytes < FullBytes);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNoctAttributeSerializeModifiersTest, "NoctAbilitySystem.Attribute.SerializeModifiers", NoctAttributeModifierTests::TestFlags)
+
+bool FNoctAttributeSerializeModifiersTest::RunTest(const FString& Parameters)
+{
+	using namespace NoctAttributeModifierTests;
+
+	const TStrongObjectPtr<UNoctEffect> Source(NewObject<UNoctEffect>());
+	const TArray<FGameplayTagContainer> TagSets = MakeTagSets(1);
+
+	FNoctAttribute Attribute;
+	Attribute.Initialize(50.0f, 200.0f);
+	Attribute.AddModifier(FNoctAttributeModifier(10.0f, false, Source.Get()));
+
+	// Stacked twice if the project has a tag to stack on
+	FNoctAttributeModifier Percent(0.5f, true);
+	if (TagSets.Num() > 0)
+	{
+		Percent.Tags = TagSets[0];
+		Percent.StackTag = TagSets[0].First();
+		Attribute.AddModifier(Percent);
+	}
+	Attribute.AddModifier(Percent);
+
+	TArray<uint8> Bytes;
+	FObjectWriter Writer(Bytes);
+	FNoctAttribute::StaticStruct()->SerializeItem(Writer, &Attribute, nullptr);
+
+	FNoctAttribute Loaded;
+	FObjectReader Reader(Bytes);
+	FNoctAttribute::StaticStruct()->SerializeItem(Reader, &Loaded, nullptr);
+
+	TestTrue(TEXT("Loaded attribute is identical"), Loaded.Identical(&Attribute, 0));
+	TestEqual(TEXT("Current value"), Loaded.CurrentValue, Attribute.CurrentValue);
+	TestEqual(TEXT("Recalculated value"), Loaded.CalculateValue(), Attribute.CalculateValue());
+
+	const TArray<FNoctAttributeModifier> Modifiers = Attribute.GetModifiers();
+	const TArray<FNoctAttributeModifier> LoadedModifiers = Loaded.GetModifiers();
+	if (TestEqual(TEXT("Modifiers"), LoadedModifiers.Num(), Modifiers.Num()))
+	{
+		TestTrue(TEXT("Source"), LoadedModifiers[0].Source == Source.Get());
+		TestEqual(TEXT("Stack count"), LoadedModifiers[1].StackCount, Modifiers[1].StackCount);
+		TestTrue(TEXT("Tags"), LoadedModifiers[1].Tags == Modifiers[1].Tags);
+		TestTrue(TEXT("Loaded modifiers get new handles"), LoadedModifiers[0].Handle != Modifiers[0].Handle);
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
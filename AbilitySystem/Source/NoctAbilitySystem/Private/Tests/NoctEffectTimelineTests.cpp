@@ -0,0 +1,138 @@
+﻿// Copyright Nocturnum Games 2023 
+
+
+#include "NoctEffect.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace NoctEffectTimelineTests
+{
+	constexpr auto TestFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext
+		| EAutomationTestFlags::ServerContext | EAutomationTestFlags::CommandletContext | EAutomationTestFlags::EngineFilter;
+
+	// Far from zero, so the double start time and float interval mix the way they do late in a session
+	constexpr double StartTime = 1234.5678;
+
+	struct FRunResult
+	{
+		int32 TriggersFired = 0;
+		double LastTriggerTime = 0.0;
+		double ExpiryTime = 0.0;
+	};
+
+	// Advance the timeline in fixed frames through the same loop UNoctEffect::AdvanceTimeline uses, until it expires
+	FRunResult Run(FNoctEffectTimeline& Timeline, const double FrameTime)
+	{
+		FRunResult Result;
+		for (int32 Frame = 1; ; ++Frame)
+		{
+			// Multiplied rather than accumulated, so both frame times land on the same instants
+			const double Now = StartTime + Frame * FrameTime;
+			Timeline.Advance(Now, [&Result](const double TriggerTime)
+			{
+				Result.LastTriggerTime = TriggerTime;
+				++Result.TriggersFired;
+				return true;
+			});
+
+			if (Timeline.IsExpired(Now))
+			{
+				Result.ExpiryTime = Now;
+				return Result;
+			}
+		}
+	}
+
+	struct FTimelineCase
+	{
+		float Duration;
+		float TriggerInterval;
+		int32 ExpectedTriggers;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNoctEffectTimelineFrameTimeTest, "NoctAbilitySystem.EffectTimeline.SameTotalsAt1msAnd500msFrames", NoctEffectTimelineTests::TestFlags)
+
+bool FNoctEffectTimelineFrameTimeTest::RunTest(const FString& Parameters)
+{
+	using namespace NoctEffectTimelineTests;
+
+	// Intervals shorter than, equal to and longer than the short frame, and ones that don't divide the long frame
+	const FTimelineCase Cases[] =
+	{
+		{ 1.0f, 0.001f, 1000 },
+		{ 10.0f, 0.5f, 20 },
+		{ 10.0f, 1.0f, 10 },
+		{ 2.5f, 0.3f, 8 },
+	};
+
+	for (const FTimelineCase& Case : Cases)
+	{
+		const FString Context = FString::Printf(TEXT("%.3f s every %.3f s"), Case.Duration, Case.TriggerInterval);
+
+		FNoctEffectTimeline ShortFrames;
+		ShortFrames.Start(StartTime, Case.Duration, Case.TriggerInterval, true);
+		FNoctEffectTimeline LongFrames = ShortFrames;
+
+		const FRunResult ShortResult = Run(ShortFrames, 0.001);
+		const FRunResult LongResult = Run(LongFrames, 0.5);
+
+		TestEqual(FString::Printf(TEXT("%s: triggers at 1 ms frames"), *Context), ShortResult.TriggersFired, Case.ExpectedTriggers);
+		TestEqual(FString::Printf(TEXT("%s: triggers at 500 ms frames"), *Context), LongResult.TriggersFired, Case.ExpectedTriggers);
+		TestEqual(FString::Printf(TEXT("%s: last trigger time"), *Context), LongResult.LastTriggerTime, ShortResult.LastTriggerTime);
+		TestEqual(FString::Printf(TEXT("%s: no triggers due after expiry"), *Context), LongFrames.GetTriggersDue(LongResult.ExpiryTime + 1.0), 0);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNoctEffectTimelineCatchUpTest, "NoctAbilitySystem.EffectTimeline.CatchUpAfterLongFrame", NoctEffectTimelineTests::TestFlags)
+
+bool FNoctEffectTimelineCatchUpTest::RunTest(const FString& Parameters)
+{
+	using namespace NoctEffectTimelineTests;
+
+	FNoctEffectTimeline Timeline;
+	Timeline.Start(StartTime, 10.0f, 1.0f, true);
+
+	TestEqual(TEXT("Nothing due before the first interval"), Timeline.GetTriggersDue(StartTime + 0.5), 0);
+
+	// A 5.5 second hitch, the five missed triggers are due at once and keep their scheduled times
+	const int32 TriggersDue = Timeline.GetTriggersDue(StartTime + 5.5);
+	TestEqual(TEXT("Triggers due after the hitch"), TriggersDue, 5);
+	for (int32 Index = 0; Index < TriggersDue; ++Index)
+	{
+		TestTrue(TEXT("Missed trigger keeps its scheduled time"), FMath::IsNearlyEqual(Timeline.GetNextTriggerTime(), StartTime + Index + 1.0, 1.0e-6));
+		++Timeline.TriggersFired;
+	}
+	TestEqual(TEXT("Nothing due after catching up"), Timeline.GetTriggersDue(StartTime + 5.5), 0);
+
+	// A hitch past the end only fires what is left, never more than the total
+	TestEqual(TEXT("Remaining triggers after a hitch past the end"), Timeline.GetTriggersDue(StartTime + 60.0), 5);
+	TestTrue(TEXT("Expired after the hitch"), Timeline.IsExpired(StartTime + 60.0));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNoctEffectTimelineOneShotTest, "NoctAbilitySystem.EffectTimeline.OneShotExpiry", NoctEffectTimelineTests::TestFlags)
+
+bool FNoctEffectTimelineOneShotTest::RunTest(const FString& Parameters)
+{
+	using namespace NoctEffectTimelineTests;
+
+	// One shot effects trigger when applied, the timeline only waits out their duration
+	FNoctEffectTimeline Timeline;
+	Timeline.Start(StartTime, 2.0f, 0.5f, false);
+	TestEqual(TEXT("No timed triggers"), Timeline.TotalTriggers, 0);
+
+	const FRunResult Result = Run(Timeline, 1.0 / 30.0);
+	TestEqual(TEXT("Triggers fired"), Result.TriggersFired, 0);
+	TestFalse(TEXT("Not expired before the duration"), Timeline.IsExpired(StartTime + 1.9));
+	TestTrue(TEXT("Expired at the end of the duration"), Timeline.IsExpired(StartTime + 2.0));
+	TestTrue(TEXT("Expired within a frame of the duration"), Result.ExpiryTime >= StartTime + 2.0 - UE_KINDA_SMALL_NUMBER && Result.ExpiryTime < StartTime + 2.0 + 1.0 / 30.0);
+
+	return true;
+}
+
+#endif
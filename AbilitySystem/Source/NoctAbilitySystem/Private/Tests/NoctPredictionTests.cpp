@@ -0,0 +1,149 @@
+﻿// Copyright Nocturnum Games 2023
+
+
+#include "NoctAbility.h"
+#include "NoctAbilityComponent.h"
+#include "NoctAttribute.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameplayTagsManager.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace NoctPredictionTests
+{
+	constexpr auto TestFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext
+		| EAutomationTestFlags::ServerContext | EAutomationTestFlags::CommandletContext | EAutomationTestFlags::EngineFilter;
+
+	constexpr float StartingCostValue = 100.0f;
+	constexpr float Cost = 10.0f;
+
+	// What a rejected prediction has to put back
+	struct FSnapshot
+	{
+		bool bActive = false;
+		bool bActiveTag = false;
+		int32 Charges = 0;
+		TArray<double> ChargeReadyTimes;
+		double EndTime = 0.0;
+		bool bGroupOnCooldown = false;
+		float CostBaseValue = 0.0f;
+
+		static FSnapshot Take(UNoctAbilityComponent* Component, const UNoctAbility* Ability, const FGameplayTag CostTag)
+		{
+			FSnapshot Snapshot;
+			Snapshot.bActive = Ability->bIsActive;
+			Snapshot.bActiveTag = Component->ActiveAbilityTags.HasTagExact(Ability->AbilityTag);
+			Snapshot.Charges = Component->GetAbilityCharges(Ability->AbilityTag);
+			if (const FNoctCooldownEntry* Entry = Component->Cooldowns.Find(Ability->AbilityTag))
+			{
+				Snapshot.ChargeReadyTimes = Entry->ChargeReadyTimes;
+				Snapshot.EndTime = Entry->EndTime;
+			}
+			Snapshot.bGroupOnCooldown = Component->Cooldowns.IsOnCooldown(Ability->CooldownGroupTag, Component->GetCooldownTime());
+			Snapshot.CostBaseValue = Component->FindAttribute(CostTag)->BaseValue;
+			return Snapshot;
+		}
+	};
+
+	void TestRestored(FAutomationTestBase& Test, const TCHAR* What, const FSnapshot& Expected, const FSnapshot& Actual)
+	{
+		Test.TestEqual(FString::Printf(TEXT("%s: active"), What), Actual.bActive, Expected.bActive);
+		Test.TestEqual(FString::Printf(TEXT("%s: active tag"), What), Actual.bActiveTag, Expected.bActiveTag);
+		Test.TestEqual(FString::Printf(TEXT("%s: charges"), What), Actual.Charges, Expected.Charges);
+		Test.TestTrue(FString::Printf(TEXT("%s: charge ready times"), What), Actual.ChargeReadyTimes == Expected.ChargeReadyTimes);
+		Test.TestEqual(FString::Printf(TEXT("%s: cooldown end time"), What), Actual.EndTime, Expected.EndTime);
+		Test.TestEqual(FString::Printf(TEXT("%s: group cooldown"), What), Actual.bGroupOnCooldown, Expected.bGroupOnCooldown);
+		Test.TestEqual(FString::Printf(TEXT("%s: cost attribute base value"), What), Actual.CostBaseValue, Expected.CostBaseValue);
+	}
+}
+
+/**
+ * Predicts the activation of an ability with a cost, charges and a cooldown group, has the server reject it and checks
+ * everything the prediction changed is back as it was. Once with the ability still active when the rejection arrives,
+ * and once with it already finished, which spends a charge and starts the group cooldown outside of the prediction.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNoctPredictionRollbackTest, "NoctAbilitySystem.Prediction.RejectRollsBack", NoctPredictionTests::TestFlags)
+
+bool FNoctPredictionRollbackTest::RunTest(const FString& Parameters)
+{
+	using namespace NoctPredictionTests;
+
+	FGameplayTagContainer AllTags;
+	UGameplayTagsManager::Get().RequestAllGameplayTags(AllTags, true);
+	const TArray<FGameplayTag>& Tags = AllTags.GetGameplayTagArray();
+	if (Tags.Num() < 3)
+	{
+		AddWarning(TEXT("Needs at least three gameplay tags in the project, skipped"));
+		return true;
+	}
+	const FGameplayTag AbilityTag = Tags[0];
+	const FGameplayTag GroupTag = Tags[1];
+	const FGameplayTag CostTag = Tags[2];
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("NoctPredictionTest"));
+	AActor* Actor = World->SpawnActor<AActor>();
+	UNoctAbilityComponent* Component = NewObject<UNoctAbilityComponent>(Actor);
+	Component->RegisterComponent();
+
+	FNoctAttribute CostAttribute;
+	CostAttribute.Initialize(StartingCostValue, StartingCostValue);
+	Component->AddAttribute(CostTag, CostAttribute);
+
+	// The base class has no tag to unlock it by, so it's set up after being added and the lookups rebuilt
+	Component->UnlockAbilityByClass(UNoctAbility::StaticClass());
+	UNoctAbility* Ability = Component->Abilities.Last();
+	Ability->AbilityTag = AbilityTag;
+	Ability->BaseCooldown = 5.0f;
+	Ability->MaxCharges = 2;
+	Ability->CooldownGroupTag = GroupTag;
+	Ability->GroupCooldown = 3.0f;
+	Ability->CostAttributeTag = CostTag;
+	Ability->CostValue = Cost;
+	Ability->bCommitCostNatively = true;
+	Component->RebuildAbilityIndex();
+
+	// One charge already recharging, so the restored cooldown entry isn't just an empty one
+	Component->SpendCharge(AbilityTag, Ability->MaxCharges, Ability->BaseCooldown, Ability->RechargePolicy);
+	const FSnapshot Before = FSnapshot::Take(Component, Ability, CostTag);
+	TestEqual(TEXT("Charges before predicting"), Before.Charges, 1);
+
+	// Rejected while the ability is still active, the rollback cancels it
+	{
+		const FNoctPredictionKey Key = Component->PredictActivation(Ability);
+		if (TestTrue(TEXT("Prediction made while active"), Key.IsValid()))
+		{
+			const FSnapshot Predicted = FSnapshot::Take(Component, Ability, CostTag);
+			TestTrue(TEXT("Predicted activation is active"), Predicted.bActive && Predicted.bActiveTag);
+			TestEqual(TEXT("Predicted activation paid its cost"), Predicted.CostBaseValue, StartingCostValue - Cost);
+
+			Component->ClientRejectPrediction_Implementation(Key);
+			TestRestored(*this, TEXT("Rejected while active"), Before, FSnapshot::Take(Component, Ability, CostTag));
+		}
+	}
+
+	// Rejected after the ability finished, which spent the last charge and started the group cooldown
+	{
+		const FNoctPredictionKey Key = Component->PredictActivation(Ability);
+		if (TestTrue(TEXT("Prediction made after finishing"), Key.IsValid()))
+		{
+			{
+				FNoctAbilityBindingScope BindingScope(Component, Ability);
+				Ability->FinishAbility();
+			}
+
+			const FSnapshot Finished = FSnapshot::Take(Component, Ability, CostTag);
+			TestEqual(TEXT("Finishing spent the last charge"), Finished.Charges, 0);
+			TestTrue(TEXT("Finishing started the group cooldown"), Finished.bGroupOnCooldown);
+
+			Component->ClientRejectPrediction_Implementation(Key);
+			TestRestored(*this, TEXT("Rejected after finishing"), Before, FSnapshot::Take(Component, Ability, CostTag));
+		}
+	}
+
+	World->DestroyWorld(false);
+	return true;
+}
+
+#endif
@@ -7,10 +7,73 @@
 #include "InputActionValue.h"
 #include "UObject/Object.h"
 #include "Curves/CurveFloat.h"
+#include "NoctScalingTable.h"
+#include "NoctSharedTagContainer.h"
+#include "NoctTagBits.h"
+#include "NoctAbilityTasks.h"
+#include "NoctCooldownTable.h"
 #include "NoctAbility.generated.h"
 
 class UInputAction;
 class UNoctAbilityComponent;
+struct FNoctAttribute;
+
+UENUM(BlueprintType)
+enum class ENoctAbilityInstancingPolicy : uint8
+{
+	// Each ability component creates its own instance of the ability
+	InstancedPerActor,
+	// The class default object runs the ability for every component, with the per actor state kept on the component.
+	// For stateless abilities used by large numbers of actors. Anything the ability needs to remember between calls
+	// has to live in FNoctAbilityState, the cooldown table or the owning actor.
+	NonInstanced
+};
+
+// An extra attribute cost on top of an ability's main cost
+USTRUCT(BlueprintType)
+struct FNoctAbilityCost
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	FGameplayTag AttributeTag;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	float Value = 0.0f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	float ValuePerLevel = 0.0f;
+
+	float GetValueAtLevel(const int32 Level) const
+	{
+		return Value + ValuePerLevel * (Level - 1);
+	}
+};
+
+/**
+ * The per actor state of a non-instanced ability, stored on the owning component.
+ * Cooldowns are already per component, in the component's cooldown table.
+ */
+USTRUCT(BlueprintType)
+struct FNoctAbilityState
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	FGameplayTag AbilityTag;
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	bool bIsActive = false;
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	int32 Level = 1;
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	FInputActionValue CurrentInputValue;
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	TArray<float> CommittedCosts;
+};
  /**
   *
   */
@@ -22,6 +85,28 @@ public:
 
 	UNoctAbility();
 
+	virtual void PostInitProperties() override;
+	virtual void PostLoad() override;
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	ENoctAbilityInstancingPolicy InstancingPolicy = ENoctAbilityInstancingPolicy::InstancedPerActor;
+
+	bool IsInstanced() const
+	{
+		return InstancingPolicy == ENoctAbilityInstancingPolicy::InstancedPerActor;
+	}
+
+	// Swap the per actor state of a non-instanced ability in and out
+	void LoadState(const FNoctAbilityState& State);
+	void StoreState(FNoctAbilityState& State) const;
+
+	// Put the ability back into its default state so the component can hand it out again
+	void ResetForReuse();
+
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem|Input")
 	TObjectPtr<UInputAction> ActivationAction;
 
@@ -43,11 +128,33 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
 	FGameplayTag AbilityTag;
 
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
-	FGameplayTagContainer BlockingTags;
+	/**
+	 * BlockingTags and CancelTags used to be BlueprintReadOnly properties. Blueprint graphs that read them
+	 * need their variable nodes replaced with these getters, which return the same container.
+	 */
+	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem")
+	const FGameplayTagContainer& GetBlockingTags() const
+	{
+		return BlockingTags.Get();
+	}
+
+	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem")
+	const FGameplayTagContainer& GetCancelTags() const
+	{
+		return CancelTags.Get();
+	}
 
+	// Give this instance its own blocking tags, keeping the compiled tag bits in step
+	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem")
+	void SetBlockingTags(const FGameplayTagContainer& Tags);
+
+	// Give this instance its own cancel tags, keeping the compiled tag bits in step
+	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem")
+	void SetCancelTags(const FGameplayTagContainer& Tags);
+
+	// When several activations are requested in the same frame, higher priorities activate first
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
-	FGameplayTagContainer CancelTags;
+	int32 ActivationPriority = 0;
 
  	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
  	bool bAutoActivateOnAdd = false;
@@ -60,6 +167,42 @@ public:
 
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
 	float BaseCooldown = 0;
+
+	// Optional multiplier on BaseCooldown by level
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	UCurveFloat* CooldownScalingCurve = nullptr;
+
+	// Abilities sharing a group tag share one cooldown, stored once on the component under the group tag.
+	// Starting this ability's cooldown also starts the group's, and no ability in the group can activate while it runs.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem|Cooldown Group")
+	FGameplayTag CooldownGroupTag;
+
+	// Length of the group cooldown this ability starts, 0 uses the ability's own cooldown
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem|Cooldown Group", meta = (EditCondition = "CooldownGroupTag.IsValid()", ClampMin = 0, Units = "s"))
+	float GroupCooldown = 0.0f;
+
+	// More than 1 gives the ability charges, each recharging in GetScaledCooldown.
+	// The ability is only on cooldown once every charge is spent.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem|Charges", meta = (ClampMin = 1))
+	int32 MaxCharges = 1;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem|Charges", meta = (EditCondition = "MaxCharges > 1"))
+	ENoctChargeRechargePolicy RechargePolicy = ENoctChargeRechargePolicy::Sequential;
+
+	bool HasCharges() const
+	{
+		return MaxCharges > 1;
+	}
+
+	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem")
+	float GetScaledCooldown() const
+	{
+		if (CooldownScalingCurve)
+		{
+			return BaseCooldown * CooldownScalingTable.Evaluate(CooldownScalingCurve, Level);
+		}
+		return BaseCooldown;
+	}
 	
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "NoctAbilitySystem")
 	bool bIsActive = false;
@@ -67,6 +210,10 @@ public:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
 	int Level = 1;
 
+	// Highest level the scaling curves are baked for
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	int MaxLevel = 5;
+
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem|Cost")
 	FGameplayTag CostAttributeTag;  // Points to EVE attribute
 
@@ -85,13 +232,50 @@ public:
 		// If we have a curve, use it for scaling based on level
 		if (CostScalingCurve)
 		{
-			return CostValue * CostScalingCurve->GetFloatValue(Level);
+			return CostValue * CostScalingTable.Evaluate(CostScalingCurve, Level);
 		}
 		// Otherwise use the linear scaling factor
 		return CostValue + (CostScalingPerLevel * (Level - 1));
 	}
 
-	FTimerHandle CooldownTimer;
+	// Costs on further attributes, paid together with the main cost
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem|Cost")
+	TArray<FNoctAbilityCost> AdditionalCosts;
+
+	// Check and pay costs from the owning component's attributes. Off by default, as abilities that already pay
+	// their cost in Blueprint would be charged twice.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem|Cost")
+	bool bCommitCostNatively = false;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem|Cost", meta = (EditCondition = "bCommitCostNatively"))
+	bool bRefundCostOnCancel = true;
+
+	// What was paid on the last activation, one entry per cost with the main cost first
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem|Cost")
+	TArray<float> CommittedCosts;
+
+	// True if the base values of the owner's attributes can pay every cost. Costs on an attribute the owner doesn't have can't be paid.
+	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem|Cost")
+	bool CanAffordCost();
+
+	// Pay every cost at once, or none of them. Taken from the attributes' base value.
+	bool CommitCost();
+
+	// Give back what the last CommitCost took
+	void RefundCost();
+
+	// Re-bake the level tables. Only needed if a scaling curve or max level is changed at runtime.
+	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem")
+	void BakeScalingTables();
+
+	bool AreScalingTablesBaked() const;
+
+	// Scaling curves baked for levels 0 to MaxLevel
+	UPROPERTY()
+	FNoctScalingTable CostScalingTable;
+
+	UPROPERTY()
+	FNoctScalingTable CooldownScalingTable;
 
 	// Parent functions to handle ability flow
 	// These allow us to not require calling super functions from abilities
@@ -101,15 +285,20 @@ public:
 	UFUNCTION(BlueprintCallable, DisplayName="Activate Ability")
 	void ActivateAbility();
 
+	// Used by the component's activation queue, which cancels for the whole batch up front
+	void ActivateAbilityWithoutCancel();
+
 	UFUNCTION(BlueprintCallable, DisplayName="Finish Ability")
 	void FinishAbility();
 
 	UFUNCTION(BlueprintCallable, DisplayName="Cancel Ability")
 	void CancelAbility();
 
+	// Called by the owning component when this ability's cooldown ends
 	UFUNCTION()
 	void FinishCooldown();
 
+	// Start the cooldown on the owning component's cooldown table, or spend a charge for abilities with charges
 	void TriggerCooldown(float CooldownOverride = 0);
 
 	// Native Events
@@ -141,6 +330,39 @@ public:
 	UFUNCTION(BlueprintImplementableEvent)
 	void OnAbilityCooldownFinished();
 
+	// Ability tasks. Only run while the ability is active, finishing or cancelling the ability ends them without completing.
+	// Each completes once, through AbilityTaskCompleted and OnAbilityTaskCompleted.
+	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem|Tasks")
+	FNoctAbilityTaskHandle WaitDelay(float Duration);
+
+	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem|Tasks")
+	FNoctAbilityTaskHandle WaitInputReleased();
+
+	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem|Tasks")
+	FNoctAbilityTaskHandle WaitAttributeChange(FGameplayTag AttributeTag, ENoctAttributeThreshold Threshold, float ThresholdValue = 0.0f);
+
+	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem|Tasks")
+	FNoctAbilityTaskHandle WaitEffectRemoved(FGameplayTag EffectTag);
+
+	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem|Tasks")
+	FNoctAbilityTaskHandle WaitTagAdded(FGameplayTag Tag);
+
+	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem|Tasks")
+	void CancelAbilityTask(FNoctAbilityTaskHandle Handle);
+
+	// Called by the owning component. Value is the attribute's value for attribute changes, otherwise the time waited.
+	void NativeAbilityTaskCompleted(FNoctAbilityTaskHandle Handle, ENoctAbilityTaskType TaskType, float Value);
+
+	virtual void AbilityTaskCompleted(FNoctAbilityTaskHandle Handle, ENoctAbilityTaskType TaskType, float Value) {};
+
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnAbilityTaskCompleted(FNoctAbilityTaskHandle Handle, ENoctAbilityTaskType TaskType, float Value);
+
+	// Called on the owning client when the server refused an activation the client predicted.
+	// The activation has already been cancelled and its cooldown and cost put back.
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnAbilityPredictionRejected();
+
  	// INPUT STUFF
  	UFUNCTION()
  	virtual void InputActionStarted(const struct FInputActionValue& Value);
@@ -172,8 +394,20 @@ public:
 
 	virtual bool CanActivateAbility();
 
+	// True if any of BlockingTags is active on the owning component
+	bool IsBlockedByActiveAbilities() const;
+
+	// False when it is known that none of CancelTags is active, so activating can skip the cancel pass
+	bool MayCancelActiveAbilities() const;
+
+	// Precompile AbilityTag, BlockingTags and CancelTags into bits, done when the ability is added to a component
+	void CompileTagBits();
+
 	virtual UWorld* GetWorld() const override;
 
+	// False, with a warning, for a non-instanced ability called outside of its component
+	bool IsBoundToComponent() const;
+
 	// Owning Component used to control abilities
 	UPROPERTY(visibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
 	TObjectPtr<UNoctAbilityComponent> OwningAbilityComponent;
@@ -183,4 +417,49 @@ public:
 
  	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem")
  	ACharacter* GetOwningCharacter() const;
+
+private:
+	void ActivateAbilityInternal(bool bCancelAbilities);
+
+	// Start a task for this ability on the owning component, invalid if the ability isn't active
+	FNoctAbilityTaskHandle StartTask(FNoctAbilityTask& Task);
+
+	int32 GetNumCosts() const
+	{
+		return 1 + AdditionalCosts.Num();
+	}
+
+	float GetCostValue(int32 CostIndex) const;
+	
+	FGameplayTag GetCostAttributeTag(const int32 CostIndex) const
+	{
+		return CostIndex == 0 ? CostAttributeTag : AdditionalCosts[CostIndex - 1].AttributeTag;
+	}
+
+	// The attribute paying each cost, main cost first, null where the owner doesn't have it.
+	// Only valid until the owner's attributes change, so found again for every check.
+	void ResolveCostAttributes(TArray<FNoctAttribute*, TInlineAllocator<2>>& OutAttributes);
+
+	bool CanAffordCostFrom(TConstArrayView<FNoctAttribute*> Attributes) const;
+
+	// Where each cost attribute was in the owner's attribute map the last time it was found.
+	// Anything can add to or remove from the map, so an id is only used while it still holds the cost's tag.
+	TArray<FSetElementId, TInlineAllocator<2>> CostAttributeIds;
+	const UNoctAbilityComponent* CostAttributesComponent = nullptr;
+
+	// Shared with every other ability that has the same tags. Private so every change goes through
+	// SetBlockingTags and SetCancelTags, which recompile the bits below.
+	UPROPERTY(EditDefaultsOnly, Category = "NoctAbilitySystem")
+	FNoctSharedTagContainer BlockingTags;
+
+	UPROPERTY(EditDefaultsOnly, Category = "NoctAbilitySystem")
+	FNoctSharedTagContainer CancelTags;
+
+	FNoctTagBits BlockingTagBits;
+
+	// Every registered tag that CancelTags would match
+	FNoctTagBits CancelTagBits;
+
+	int32 AbilityTagBit = INDEX_NONE;
+	bool bBlockingTagsCompiled = false;
 };
@@ -6,6 +6,14 @@
 #include "GameplayTagContainer.h"
 #include "Components/ActorComponent.h"
 #include "NoctAttribute.h"
+#include "NoctEffect.h"
+#include "NoctCooldownTable.h"
+#include "NoctTagBits.h"
+#include "NoctAbility.h"
+#include "NoctPrediction.h"
+#include "NoctAbilityReplication.h"
+#include "NoctAbilitySubsystem.h"
+#include "InputTriggers.h"
 
 #ifdef USE_EASY_MULTI_SAVE
 #include <EMSActorSaveInterface.h>
@@ -17,6 +25,98 @@
 
 class UNoctEffect;
 class UNoctAbility;
+class UInputAction;
+class UEnhancedInputComponent;
+struct FInputActionInstance;
+
+// Removed effect instances kept around for reuse, one pool per effect class
+USTRUCT()
+struct FNoctEffectPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UNoctEffect>> FreeEffects;
+};
+
+// Removed ability instances kept around for reuse, one pool per ability class
+USTRUCT()
+struct FNoctAbilityPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UNoctAbility>> FreeAbilities;
+};
+
+// An ability that was unlocked with lazy instancing and hasn't been created yet
+USTRUCT(BlueprintType)
+struct FNoctPendingAbility
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem", SaveGame)
+	TSubclassOf<UNoctAbility> AbilityClass;
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem", SaveGame)
+	FGameplayTag AbilityTag;
+};
+
+// An ability listening to an input action through the component's input router
+USTRUCT()
+struct FNoctInputRouteTarget
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FGameplayTag AbilityTag;
+
+	UPROPERTY()
+	bool bAllowInputTriggered = false;
+};
+
+// One input action bound on the owner's input component, and the abilities its events are routed to
+USTRUCT()
+struct FNoctInputRoute
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TObjectPtr<UInputAction> Action;
+
+	// In the order the abilities were registered, which is the order they receive events in
+	UPROPERTY(Transient)
+	TArray<FNoctInputRouteTarget> Targets;
+
+	// Started, Completed and Canceled are bound with the route, Triggered only while a target wants it
+	TArray<uint32, TInlineAllocator<3>> BindingHandles;
+	uint32 TriggeredBindingHandle = 0;
+	
+	bool WantsTriggered() const;
+};
+
+/**
+ * While in scope, binds a non-instanced ability's class default object to a component and that component's state for it.
+ * Every call a component makes into one of its abilities goes through one of these.
+ * Does nothing for instanced abilities, or if the ability is already bound to the component.
+ */
+struct NOCTABILITYSYSTEM_API FNoctAbilityBindingScope
+{
+	FNoctAbilityBindingScope(UNoctAbilityComponent* InComponent, UNoctAbility* InAbility);
+	~FNoctAbilityBindingScope();
+
+	UE_NONCOPYABLE(FNoctAbilityBindingScope);
+
+private:
+	UNoctAbilityComponent* Component = nullptr;
+	UNoctAbility* Ability = nullptr;
+	
+	// What the ability was bound to before, restored when the scope ends
+	UNoctAbilityComponent* PreviousComponent = nullptr;
+	FNoctAbilityState PreviousState;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FNoctCooldownsFinishedEvent, const FGameplayTagContainer&, FinishedCooldownTags);
 
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class NOCTABILITYSYSTEM_API UNoctAbilityComponent : public UActorComponent
@@ -33,14 +133,36 @@ public:
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
+	// Only ticks while there is timed work to advance, such as effects waiting on their timeline
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
 	UFUNCTION(BlueprintCallable)
 	void AbilityCooldownFinished(UNoctAbility* NoctAbility);
 
 	// Abilities
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
 	TArray<TSubclassOf<UNoctAbility>> DefaultAbilities;
+
+	// Unlocking an instanced ability only records its class, the ability is created on its first activation or input.
+	// Abilities that auto activate when added are always created right away.
+	UPROPERTY(EditDefaultsOnly, Category = "NoctAbilitySystem")
+	bool bLazyAbilityInstancing = false;
+
+	// Unlocked abilities that haven't been created yet, these count as unlocked but aren't in Abilities
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem", SaveGame)
+	TArray<FNoctPendingAbility> PendingAbilities;
+
+	// Removed abilities are reset and reused when an ability of the same class is unlocked again
+	UPROPERTY(EditDefaultsOnly, Category = "NoctAbilitySystem", meta = (ClampMin = 0))
+	int32 MaxPooledAbilitiesPerClass = 1;
+
+	UPROPERTY(Transient)
+	TMap<TSubclassOf<UNoctAbility>, FNoctAbilityPool> AbilityPool;
 	
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem", SaveGame)
 	FGameplayTagContainer UnlockedAbilityTags;
@@ -56,6 +178,57 @@ public:
 
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem", SaveGame)
 	TArray<TObjectPtr<UNoctEffect>> ActiveEffects;
+
+	// Mirror the ability tag containers as bits for the tags registered in UNoctAbilitySystemSettings::IndexedTags.
+	// Has no effect when no tags are registered.
+	UPROPERTY(EditDefaultsOnly, Category = "NoctAbilitySystem")
+	bool bUseTagBits = true;
+
+	// Used by abilities as they start and stop, keeps ActiveAbilityTags and its bits in sync
+	void AddActiveAbilityTag(FGameplayTag Tag);
+	void RemoveActiveAbilityTag(FGameplayTag Tag);
+
+	bool UsesTagBits() const
+	{
+		return bTagBitsEnabled;
+	}
+
+	const FNoctTagBits& GetActiveAbilityBits() const
+	{
+		return ActiveAbilityBits;
+	}
+
+	const FNoctTagBits& GetBlockedAbilityBits() const
+	{
+		return BlockedAbilityBits;
+	}
+
+	// Active ability tags that have no bit, while this is above 0 the active bits alone don't describe every active ability
+	int32 GetNumUnindexedActiveAbilityTags() const
+	{
+		return NumUnindexedActiveAbilityTags;
+	}
+
+	// Rebuild the bits from the tag containers, such as after they were restored from a save
+	void RebuildTagBits();
+
+	// Per actor state of the non-instanced abilities in Abilities, whose entries there are their class default objects
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem", SaveGame)
+	TArray<FNoctAbilityState> SharedAbilityStates;
+
+	FNoctAbilityState* FindSharedAbilityState(FGameplayTag AbilityTag);
+
+	// Works for both instanced and non-instanced abilities
+	bool IsAbilityActive(const UNoctAbility* Ability) const;
+
+	// Route an input action's events to an ability. Each action is only bound once on the owner's input component,
+	// no matter how many abilities use it. Registering again updates the ability's entry.
+	void RegisterAbilityInput(UInputAction* Action, FGameplayTag AbilityTag, bool bAllowInputTriggered);
+	void UnregisterAbilityInput(FGameplayTag AbilityTag);
+
+	// Bind every routed action again, such as after the owner's input component was replaced
+	UFUNCTION(BlueprintCallable)
+	void RebindInputRoutes();
 	
 	UFUNCTION(BlueprintPure)
 	bool HasAbilityUnlocked(FGameplayTag TagToCheck) const;
@@ -66,12 +239,54 @@ public:
 	UFUNCTION(BlueprintPure)
 	bool HasAbilityBlocked(FGameplayTag TagToCheck) const;
 
+	// Pending abilities aren't found, use FindOrCreateAbilityByTag to get those too
+	UFUNCTION(BlueprintPure)
+	UNoctAbility* FindAbilityByTag(FGameplayTag AbilityTag) const;
+
+	// Like FindAbilityByTag, but creates the ability if it was unlocked lazily and is still pending
+	UFUNCTION(BlueprintCallable)
+	UNoctAbility* FindOrCreateAbilityByTag(FGameplayTag AbilityTag);
+
 	UFUNCTION(BlueprintCallable)
 	bool UnlockAbilityByClass(TSubclassOf<UNoctAbility> AbilityClass);
 
+	// On an owning client the activation is predicted, see ActivateAbilityPredicted
 	UFUNCTION(BlueprintCallable)
 	void ActivateAbilityByTag(FGameplayTag AbilityTag);
 
+	// Queue an activation, resolved together with every other request this frame on the next tick.
+	// Cancellations from all requests are applied once, then the abilities activate by ActivationPriority.
+	// A request that can't activate yet, such as one made just before its cooldown ends, is retried for InputBufferWindow seconds.
+	UFUNCTION(BlueprintCallable)
+	void RequestActivateAbilityByTag(FGameplayTag AbilityTag);
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "NoctAbilitySystem", meta = (ClampMin = 0, Units = "s"))
+	float InputBufferWindow = 0.15f;
+
+	// Input that auto activates an ability goes through RequestActivateAbilityByTag instead of activating right away.
+	// The activation then happens in the next tick, after OnAbilityInputStarted.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "NoctAbilitySystem")
+	bool bBufferInputActivations = false;
+
+	// Resolve every queued activation request
+	void ResolveActivationRequests(double Now);
+
+	// Ability tasks, started through UNoctAbility's Wait functions and completed from this component's tick or events
+	FNoctAbilityTaskHandle StartAbilityTask(const FNoctAbilityTask& Task);
+	void CancelAbilityTask(FNoctAbilityTaskHandle Handle);
+
+	// End every task of the ability with AbilityTag without completing them
+	void CancelAbilityTasks(FGameplayTag AbilityTag);
+
+	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem|Tasks")
+	int32 GetNumAbilityTasks() const
+	{
+		return AbilityTasks.Num();
+	}
+
+	// Complete every delay and attribute task whose condition holds at Now
+	void ProcessAbilityTasks(double Now);
+
 	UFUNCTION(BlueprintCallable)
 	void CancelAbilityByTag(FGameplayTag GameplayTag);
 
@@ -81,11 +296,49 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void RemoveAbilityByTag(FGameplayTag GameplayTag);
 
-	UFUNCTION(BlueprintCallable)
-	FGameplayTagContainer GetAbilitiesOnCooldown();
+	// Returns the cached set of tags on cooldown, which is only rebuilt when a cooldown starts or ends.
+	// By reference, so native per frame polls don't copy it. Not pure, to keep the exec pins of existing Blueprint calls.
+	UFUNCTION(BlueprintCallable, BlueprintPure = false)
+	const FGameplayTagContainer& GetAbilitiesOnCooldown() const;
 
+	// True while the ability's own cooldown or its cooldown group's is running. Also takes a bare cooldown or group tag.
 	UFUNCTION(BlueprintCallable)
 	bool IsAbilityOnCooldown(FGameplayTag GameplayTag);
+
+	// Cooldowns of every ability on this component
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	FNoctCooldownTable Cooldowns;
+
+	// Broadcast once per frame with every cooldown that finished that frame
+	UPROPERTY(BlueprintAssignable, Category = "NoctAbilitySystem")
+	FNoctCooldownsFinishedEvent OnCooldownsFinished;
+
+	// Start or restart the cooldown for a tag, an ability's or a cooldown group's. A duration of 0 or less clears it, refilling any charges.
+	void StartCooldown(FGameplayTag CooldownTag, float Duration);
+
+	// Put every ability with UNoctAbility::CooldownGroupTag set to this group on cooldown at once
+	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem")
+	void StartGroupCooldown(FGameplayTag CooldownGroupTag, float Duration);
+
+	// Spend a charge of a tag with charges, see FNoctCooldownTable::SpendCharge
+	void SpendCharge(FGameplayTag CooldownTag, int32 MaxCharges, float RechargeTime, ENoctChargeRechargePolicy RechargePolicy);
+
+	// Charges the ability has left. Abilities without charges have 1 while off cooldown.
+	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem|Charges")
+	int32 GetAbilityCharges(FGameplayTag AbilityTag) const;
+
+	// Seconds until the ability's next spent charge is back, 0 when it has every charge or has none
+	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem|Charges")
+	float GetNextChargeTimeRemaining(FGameplayTag AbilityTag) const;
+
+	// Finish every cooldown that has ended by Now, notifying their abilities in one batch
+	void ProcessExpiredCooldowns(double Now);
+
+	// Tell abilities and OnCooldownsFinished listeners about cooldowns that ended. Deferred by the subsystem for insignificant components.
+	void NotifyCooldownsFinished(const FGameplayTagContainer& FinishedCooldownTags);
+
+	// Time base for cooldowns. Server time while ability state is replicated, world time otherwise.
+	double GetCooldownTime() const;
 	
 	// Useful for unlocking features that are not raw abilities. Such as a "double jump" feature.
 	// No point in creating a whole new ability for most things and causing more clutter.
@@ -102,8 +355,13 @@ public:
 	void UnblockAbilities(FGameplayTagContainer AbilityTags);
 	
 
+	// Cancel every active ability under any of the tags, parents included. Only looks at the abilities indexed under them.
 	UFUNCTION(BlueprintCallable)
-	void CancelAbilities(FGameplayTagContainer AbilityTag);
+	void CancelAbilities(const FGameplayTagContainer& AbilityTag);
+
+	// Cancel every active ability whose tag matches the query
+	UFUNCTION(BlueprintCallable)
+	void CancelAbilitiesByQuery(const FGameplayTagQuery& Query);
 
 	UFUNCTION(BlueprintCallable)
 	void GetCooldownRemainingForAbility(FGameplayTag AbilityTag, float& TimeRemaining, float& CooldownDuration);
@@ -111,6 +369,216 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void SetCooldownRemainingForAbility(FGameplayTag AbilityTag, float NewTime);
 
+	// Rebuild the tag lookups from Abilities, such as after the array was restored from a save
+	void RebuildAbilityIndex();
+
+	// Prediction
+	// True on a client whose pawn owns this component, where activations are predicted instead of waiting on the server
+	bool IsPredictingClient() const;
+
+	// Activate locally right away and ask the server to do the same. The tags, cooldowns and attribute costs the activation
+	// changes are recorded, and rolled back if the server refuses. Abilities it cancelled are not restored.
+	void ActivateAbilityPredicted(UNoctAbility* Ability, bool bCancelAbilities = true);
+
+	// The local half of ActivateAbilityPredicted, without asking the server. Returns the key the server's answer is
+	// matched with, invalid if the ability didn't activate and nothing was predicted.
+	FNoctPredictionKey PredictActivation(UNoctAbility* Ability, bool bCancelAbilities = true);
+
+	// Predictions still waiting on the server past this many are treated as confirmed
+	UPROPERTY(EditDefaultsOnly, Category = "NoctAbilitySystem|Prediction", meta = (ClampMin = 1))
+	int32 MaxPendingPredictions = 16;
+
+	// Called by abilities as they change attributes, recorded if a prediction is in progress
+	void RecordPredictedAttributeDelta(FGameplayTag AttributeTag, float Delta);
+
+	UFUNCTION(Server, Reliable)
+	void ServerActivateAbilityPredicted(FGameplayTag AbilityTag, FNoctPredictionKey PredictionKey);
+
+	UFUNCTION(Client, Reliable)
+	void ClientConfirmPrediction(FNoctPredictionKey PredictionKey);
+
+	UFUNCTION(Client, Reliable)
+	void ClientRejectPrediction(FNoctPredictionKey PredictionKey);
+
+	// Called by abilities as they finish or are cancelled. On a predicting client the server's copy is ended the same way,
+	// it doesn't see the input or Blueprint logic that ended it here.
+	void NotifyAbilityEnded(const UNoctAbility* Ability, bool bCancelled);
+
+	UFUNCTION(Server, Reliable)
+	void ServerFinishAbilityPredicted(FGameplayTag AbilityTag);
+
+	UFUNCTION(Server, Reliable)
+	void ServerCancelAbilityPredicted(FGameplayTag AbilityTag);
+
+	// Cues
+	// Show a frame's batch of cues from this component's effects. The server multicasts them, so where they are handled
+	// is up to each machine and a dedicated server never runs a handler.
+	void SendCues(const TArray<FNoctCue>& Cues);
+
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastCues(const TArray<FNoctCue>& Cues);
+
+	// Significance
+	// Let UNoctAbilitySubsystem lower this component's update rate while it is far from every player
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem|Significance")
+	bool bUseSignificance = true;
+
+	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem|Significance")
+	ENoctSignificanceTier GetSignificanceTier() const
+	{
+		return SignificanceTier;
+	}
+
+	// Called by the subsystem, sets the tick interval for the tier
+	void SetSignificanceTier(ENoctSignificanceTier NewTier);
+
+	// Replication
+	// The owning client gets unlocked, blocked and active ability tags and cooldowns as they change.
+	// Other clients only get which abilities are active, as bits for the tags in UNoctAbilitySystemSettings::IndexedTags,
+	// and at most once per NonOwnerReplicationInterval. Owning clients only predict activations while this is set.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem|Replication")
+	bool bReplicateAbilityState = false;
+
+	UPROPERTY(EditDefaultsOnly, Category = "NoctAbilitySystem|Replication", meta = (ClampMin = 0, Units = "s", EditCondition = "bReplicateAbilityState"))
+	float NonOwnerReplicationInterval = 0.25f;
+
+	// Called by the replicated tag sets and cooldown list as changes arrive on a client
+	void ApplyReplicatedTag(ENoctReplicatedTagSet SetType, FGameplayTag Tag, bool bAdded);
+	void ApplyReplicatedCooldown(const FNoctReplicatedCooldown& Cooldown);
+
+	// Rebuild what is replicated from the tag containers and cooldown table, such as after a load
+	void RebuildReplicatedState();
+
+private:
+	void RollbackPrediction(const FNoctPredictionRecord& Record);
+
+	// Replicate a changed cooldown entry and start ticking for its expiry
+	void CooldownChanged(FGameplayTag CooldownTag);
+
+	// Change one unlocked or blocked tag, keeping its bit and replicated set in sync
+	void SetUnlockedTag(FGameplayTag Tag, bool bUnlocked);
+	void SetBlockedTag(FGameplayTag Tag, bool bBlocked);
+
+	// True on a server with clients to replicate to
+	bool IsReplicatingState() const;
+
+	// True on a server whose cues reach clients, whether or not ability state is replicated
+	bool IsMulticastingCues() const;
+
+	// Drop expired entries from LocallyShownCues
+	void PruneLocallyShownCues(double Now);
+
+	UPROPERTY(Replicated)
+	FNoctReplicatedTagSet ReplicatedUnlockedTags;
+
+	UPROPERTY(Replicated)
+	FNoctReplicatedTagSet ReplicatedBlockedTags;
+
+	UPROPERTY(Replicated)
+	FNoctReplicatedTagSet ReplicatedActiveTags;
+
+	UPROPERTY(Replicated)
+	FNoctReplicatedCooldownList ReplicatedCooldowns;
+
+	// Snapshot of ActiveAbilityBits for clients that don't own the component
+	UPROPERTY(ReplicatedUsing = OnRep_ActiveAbilityFlags)
+	TArray<uint64> ReplicatedActiveAbilityFlags;
+
+	UFUNCTION()
+	void OnRep_ActiveAbilityFlags(const TArray<uint64>& PreviousFlags);
+
+	double LastActiveFlagsSnapshotTime = -UE_BIG_NUMBER;
+
+	ENoctSignificanceTier SignificanceTier = ENoctSignificanceTier::High;
+	
+	FNoctPredictionKey LastPredictionKey;
+	TArray<FNoctPredictionRecord> PendingPredictions;
+
+	// The record changes are written to while a prediction is in progress
+	FNoctPredictionRecord* CurrentPrediction = nullptr;
+
+	// Set while a rejected prediction is undone, the server never activated what is cancelled then
+	bool bRollingBackPrediction = false;
+
+	// On the server, abilities the owning client predicted that are still active. Only these can be ended by the client.
+	FGameplayTagContainer PredictedActiveAbilityTags;
+
+	// Cues the owning client has already shown for effects it applied itself, such as predicted ones.
+	// The server multicasts the same cues back, those are matched against this and skipped.
+	struct FNoctLocallyShownCue
+	{
+		FGameplayTag CueTag;
+		ENoctCueEvent Event;
+		double ShownTime;
+	};
+	TArray<FNoctLocallyShownCue> LocallyShownCues;
+	
+	struct FNoctActivationRequest
+	{
+		FGameplayTag AbilityTag;
+		double RequestTime = 0.0;
+	};
+	
+	TArray<FNoctActivationRequest> PendingActivations;
+
+	FNoctAbilityTaskList AbilityTasks;
+
+	// Complete the tasks of Type waiting on a tag that Tag matches. AbilityTag limits it to one ability's tasks.
+	void NotifyAbilityTasks(ENoctAbilityTaskType Type, FGameplayTag Tag, FGameplayTag AbilityTag = FGameplayTag());
+
+	// Free the task's slot, then tell its ability
+	void CompleteAbilityTask(int32 Index, float Value);
+
+	bool IsAbilityTaskConditionMet(const FNoctAbilityTask& Task, double Now, float& OutValue) const;
+	
+	void AddAbility(UNoctAbility* Ability);
+	
+	UNoctAbility* AcquireAbility(TSubclassOf<UNoctAbility> AbilityClass);
+	void ReleaseAbility(UNoctAbility* Ability);
+
+	UPROPERTY(Transient)
+	TArray<FNoctInputRoute> InputRoutes;
+
+	UEnhancedInputComponent* FindInputComponent() const;
+	void BindInputRoute(FNoctInputRoute& Route, UEnhancedInputComponent* InputComponent);
+	void UnbindInputRoute(FNoctInputRoute& Route, UEnhancedInputComponent* InputComponent);
+	void UpdateTriggeredBinding(FNoctInputRoute& Route, UEnhancedInputComponent* InputComponent);
+
+	// The single handler every routed action is bound to
+	void HandleRoutedInput(const FInputActionInstance& Instance);
+	
+	// Forward one input event to an ability, creating it first if it is still pending
+	void DispatchAbilityInput(const FInputActionValue& Value, ETriggerEvent TriggerEvent, FGameplayTag AbilityTag);
+	
+	void IndexAbility(UNoctAbility* Ability);
+	void UnindexAbility(UNoctAbility* Ability);
+
+	// Set or clear the bit for Tag, returns false if the tag has no bit
+	static bool UpdateTagBit(FNoctTagBits& Bits, FGameplayTag Tag, bool bSet);
+	bool TestTagBit(const FNoctTagBits& Bits, FGameplayTag Tag, const FGameplayTagContainer& FallbackContainer) const;
+
+	bool bTagBitsEnabled = false;
+	FNoctTagBits UnlockedAbilityBits;
+	FNoctTagBits BlockedAbilityBits;
+	FNoctTagBits ActiveAbilityBits;
+	int32 NumUnindexedActiveAbilityTags = 0;
+
+	// Exact ability tag to ability, kept in sync with Abilities
+	UPROPERTY(Transient)
+	TMap<FGameplayTag, TObjectPtr<UNoctAbility>> AbilitiesByTag;
+
+	// Each tag in an ability's hierarchy, itself included, to the abilities under it. Used by CancelAbilities.
+	// Entries are always also in Abilities, which keeps them referenced.
+	TMap<FGameplayTag, TArray<UNoctAbility*>> AbilitiesByParentTag;
+
+	// Cooldown group tag to the abilities in it, so the end of a group cooldown reaches its members
+	TMap<FGameplayTag, TArray<UNoctAbility*>> AbilitiesByCooldownGroup;
+
+	// The ability, or the class default object of a pending one, for settings that don't need an instance
+	const UNoctAbility* FindAbilitySettingsByTag(FGameplayTag AbilityTag) const;
+
+public:
+
 
 	// Effects
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem", SaveGame)
@@ -128,6 +596,22 @@ public:
 	UFUNCTION(BlueprintCallable)
 	bool AddEffectByClass(TSubclassOf<UNoctEffect> EffectToAdd);
 
+	UFUNCTION(BlueprintCallable)
+	bool AddEffectBySpec(const FNoctEffectSpec& Spec);
+
+	// False if the effect is blocked on this component or already active
+	UFUNCTION(BlueprintPure)
+	bool CanApplyEffect(const FNoctEffectSpec& Spec) const;
+
+	// Apply one spec to many components, such as every target of an area effect.
+	// Blocked targets are filtered out first, then the effect is applied to the rest using pooled instances.
+	// Returns the number of targets the effect was applied to.
+	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem")
+	static int32 ApplyEffectSpecToTargets(const FNoctEffectSpec& Spec, const TArray<UNoctAbilityComponent*>& Targets);
+
+	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem")
+	static int32 ApplyEffectToTargets(TSubclassOf<UNoctEffect> EffectToAdd, const TArray<UNoctAbilityComponent*>& Targets, int32 Level = 0);
+
 	// Useful to remove effects that are unique, such as "small burn" or "large burn"
 	UFUNCTION(BlueprintCallable)
 	bool RemoveEffectByTagExact(FGameplayTag EffectTag);
@@ -136,7 +620,37 @@ public:
 	UFUNCTION(BlueprintCallable)
 	bool RemoveEffectByTag(FGameplayTag EffectTag);
 
-	void RemoveEffect(UNoctEffect* NoctEffect);
+	// bExpired is set when the effect is removed because its duration ran out
+	void RemoveEffect(UNoctEffect* NoctEffect, bool bExpired = false);
+
+	// Removed effects are reset and reused for the next application of the same class.
+	// Don't hold on to an effect after it has been removed, as it may be handed out again.
+	UPROPERTY(EditDefaultsOnly, Category = "NoctAbilitySystem", meta = (ClampMin = 0))
+	int32 MaxPooledEffectsPerClass = 8;
+
+	UPROPERTY(Transient)
+	TMap<TSubclassOf<UNoctEffect>, FNoctEffectPool> EffectPool;
+
+	UNoctEffect* AcquireEffect(TSubclassOf<UNoctEffect> EffectClass, bool* bOutFromPool = nullptr);
+	void ReleaseEffect(UNoctEffect* NoctEffect);
+
+	// Called by effects with a duration once applied, so the component starts ticking their timeline
+	void TimedEffectAdded();
+
+	// Advance the timeline of every timed effect up to Now
+	void AdvanceEffects(double Now);
+
+	// Add a timed effect that was already running somewhere else, continuing from Timeline instead of starting over
+	bool ResumeEffect(const FNoctEffectSpec& Spec, const FNoctEffectTimeline& Timeline);
+
+private:
+	// Applies a spec that has already passed CanApplyEffect
+	bool ApplyEffectInternal(const FNoctEffectSpec& Spec);
+
+	bool HasTimedWork() const;
+	void UpdateTickEnabled();
+
+public:
 
 	// Attributes
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem", SaveGame)
@@ -147,6 +661,20 @@ public:
 
 	bool AddAttribute(FGameplayTag AttributeTag, FNoctAttribute Attribute);
 
+	// Add a modifier to one of the attributes, returns its handle or 0 if there is no such attribute.
+	// Modifiers added here rather than on the attribute directly show up in recordings.
+	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem")
+	int32 AddAttributeModifier(FGameplayTag AttributeTag, const FNoctAttributeModifier& Modifier);
+
+	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem")
+	void RemoveAttributeModifier(FGameplayTag AttributeTag, int32 Handle);
+
+	// The pointer is only valid until Attributes is next added to or removed from
+	FNoctAttribute* FindAttribute(const FGameplayTag AttributeTag)
+	{
+		return Attributes.Find(AttributeTag);
+	}
+
 #ifdef USE_EASY_MULTI_SAVE
 	// Save Interface
 	virtual void ActorLoaded_Implementation() override;
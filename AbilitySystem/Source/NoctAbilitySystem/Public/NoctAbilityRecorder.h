@@ -0,0 +1,193 @@
+﻿// Copyright Nocturnum Games 2023 
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/ObjectKey.h"
+
+class UNoctAbility;
+class UNoctAbilityComponent;
+class UNoctEffect;
+struct FNoctAttribute;
+struct FNoctAttributeModifier;
+
+// Recording hooks, compiled out of shipping builds.
+// Record with NoctAbilitySystem.Record.Start and NoctAbilitySystem.Record.Stop [File], replay with -run=NoctReplay.
+#define NOCT_ABILITY_RECORDER_ENABLED !UE_BUILD_SHIPPING
+
+enum class ENoctRecordedEventType : uint8
+{
+	// Not an event, the name with NameIndex is Name
+	NameDefined,
+	// Not an event, the next frame of the recorded world started ticking with DeltaSeconds
+	FrameStarted,
+
+	// NameIndex is the actor class, SecondNameIndex the component class
+	ComponentAdded,
+	ComponentRemoved,
+	// NameIndex is the attribute tag, FloatValue the base value, SecondFloatValue the max value
+	AttributeAdded,
+	// NameIndex is the ability class
+	AbilityUnlocked,
+	// NameIndex is the ability tag
+	AbilityActivated,
+	AbilityCancelled,
+	AbilityFinished,
+	// NameIndex is the effect class, IntValue the level
+	EffectApplied,
+	// NameIndex is the effect class, IntValue 1 if it expired
+	EffectRemoved,
+	EffectTriggered,
+	// NameIndex is the attribute tag, IntValue the handle, FloatValue the value, SecondNameIndex the stack tag,
+	// Flags the percentage bit and stacking policy, SecondFloatValue the max stacks
+	ModifierAdded,
+	// NameIndex is the attribute tag, IntValue the handle
+	ModifierRemoved,
+	// NameIndex is the ability tag. Buffered, the activation it leads to happens in a later component tick.
+	AbilityActivationRequested,
+
+	Count
+};
+
+/**
+ * One entry of a recording. Which fields mean what depends on the type, see ENoctRecordedEventType.
+ */
+struct NOCTABILITYSYSTEM_API FNoctRecordedEvent
+{
+	ENoctRecordedEventType Type = ENoctRecordedEventType::NameDefined;
+
+	// Caused by another recorded event or by a component tick, so replaying the cause replays this too
+	bool bNested = false;
+
+	uint8 Flags = 0;
+
+	// Counted from the start of the recording
+	uint32 Frame = 0;
+
+	uint32 ComponentId = 0;
+	int32 NameIndex = INDEX_NONE;
+	int32 SecondNameIndex = INDEX_NONE;
+	int32 IntValue = 0;
+	float FloatValue = 0.0f;
+	float SecondFloatValue = 0.0f;
+
+	// Only for NameDefined
+	FString Name;
+
+	// Reads or writes one entry, most fields are variable length integers
+	void Serialize(FArchive& Ar);
+};
+
+/**
+ * A loaded recording, names resolved and frames split out
+ */
+struct NOCTABILITYSYSTEM_API FNoctAbilityRecording
+{
+	TArray<FString> Names;
+
+	// Frame and component events in the order they happened
+	TArray<FNoctRecordedEvent> Events;
+
+	// DeltaSeconds of each frame
+	TArray<float> FrameDeltas;
+
+	bool Load(const FString& FileName);
+
+	const FString& GetName(const int32 Index) const
+	{
+		static const FString Empty;
+		return Names.IsValidIndex(Index) ? Names[Index] : Empty;
+	}
+};
+
+/**
+ * Writes what happens to the ability components of one world into a compact binary stream.
+ * Frames are marked as the world starts ticking, and each event notes whether it was caused by another recorded event,
+ * so a replay only has to drive the events that came from outside the ability system.
+ */
+class NOCTABILITYSYSTEM_API FNoctAbilityRecorder
+{
+public:
+	static constexpr uint32 FileMagic = 0x524F434E;
+	// Version 2 added AbilityActivationRequested, version 1 recordings still load
+	static constexpr uint32 FileVersion = 2;
+
+	// Null unless a recording is running
+	static FNoctAbilityRecorder* GetActive()
+	{
+		return ActiveRecorder;
+	}
+
+	static bool Start(UWorld* World);
+
+	// Stop recording and write what was recorded, returns false if nothing was recording or the file couldn't be written
+	static bool Stop(const FString& FileName);
+
+	void RecordComponentRemoved(const UNoctAbilityComponent* Component);
+	void RecordAttributeAdded(const UNoctAbilityComponent* Component, FGameplayTag AttributeTag, const FNoctAttribute& Attribute);
+	void RecordAbilityUnlocked(const UNoctAbilityComponent* Component, const UClass* AbilityClass);
+	void RecordAbility(ENoctRecordedEventType Type, const UNoctAbilityComponent* Component, FGameplayTag AbilityTag);
+	void RecordEffect(ENoctRecordedEventType Type, const UNoctAbilityComponent* Component, const UNoctEffect* Effect, int32 IntValue = 0);
+	void RecordModifierAdded(const UNoctAbilityComponent* Component, FGameplayTag AttributeTag, int32 Handle, const FNoctAttributeModifier& Modifier);
+	void RecordModifierRemoved(const UNoctAbilityComponent* Component, FGameplayTag AttributeTag, int32 Handle);
+
+	// Events recorded while one of these is alive are marked nested
+	struct FNestedScope
+	{
+		FNestedScope()
+		{
+			++NestingDepth;
+		}
+
+		~FNestedScope()
+		{
+			--NestingDepth;
+		}
+	};
+
+	~FNoctAbilityRecorder();
+
+private:
+	explicit FNoctAbilityRecorder(UWorld* InWorld);
+
+	void OnWorldTickStart(UWorld* TickedWorld, ELevelTick TickType, float DeltaSeconds);
+
+	bool IsRecording(const UNoctAbilityComponent* Component) const;
+
+	// Id of the component in this recording, announcing it with its attributes and abilities the first time it's seen
+	uint32 GetComponentId(const UNoctAbilityComponent* Component);
+	int32 GetNameIndex(const FString& Name);
+
+	void Write(FNoctRecordedEvent& Event);
+
+	static FNoctAbilityRecorder* ActiveRecorder;
+	static int32 NestingDepth;
+
+	TWeakObjectPtr<UWorld> World;
+	FDelegateHandle TickStartHandle;
+
+	TArray<uint8> Data;
+	FMemoryWriter Writer;
+
+	uint32 Frame = 0;
+	TMap<FObjectKey, uint32> ComponentIds;
+	TMap<FString, int32> NameIndices;
+};
+
+#if NOCT_ABILITY_RECORDER_ENABLED
+
+#define NOCT_RECORD(Call) \
+	do { if (FNoctAbilityRecorder* NoctRecorder = FNoctAbilityRecorder::GetActive()) { NoctRecorder->Call; } } while (0)
+
+#define NOCT_RECORD_NESTED_SCOPE() \
+	FNoctAbilityRecorder::FNestedScope PREPROCESSOR_JOIN(NoctRecordNestedScope, __LINE__)
+
+#else
+
+#define NOCT_RECORD(Call)
+#define NOCT_RECORD_NESTED_SCOPE()
+
+#endif
@@ -0,0 +1,128 @@
+﻿// Copyright Nocturnum Games 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "NoctCooldownTable.h"
+#include "NoctAbilityReplication.generated.h"
+
+class UNoctAbilityComponent;
+
+// Which of the component's ability tag containers a replicated tag set mirrors
+UENUM()
+enum class ENoctReplicatedTagSet : uint8
+{
+	Unlocked,
+	Blocked,
+	Active
+};
+
+USTRUCT()
+struct FNoctReplicatedTag : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FGameplayTag Tag;
+};
+
+/**
+ * Mirror of one of the component's tag containers, replicated as per tag adds and removes instead of the whole container.
+ * Tags serialize as their net index, so a change costs a few bytes.
+ */
+USTRUCT()
+struct NOCTABILITYSYSTEM_API FNoctReplicatedTagSet : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FNoctReplicatedTag> Items;
+
+	// Set by the owning component's constructor, receives the changes on clients.
+	// Not properties, so they aren't overwritten from the archetype.
+	UNoctAbilityComponent* Owner = nullptr;
+	ENoctReplicatedTagSet SetType = ENoctReplicatedTagSet::Unlocked;
+
+	void AddTag(FGameplayTag Tag);
+	void RemoveTag(FGameplayTag Tag);
+	void Reset(const FGameplayTagContainer& Tags);
+
+	void PostReplicatedAdd(const TArrayView<int32>& AddedIndices, int32 FinalSize);
+	void PreReplicatedRemove(const TArrayView<int32>& RemovedIndices, int32 FinalSize);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FNoctReplicatedTag, FNoctReplicatedTagSet>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FNoctReplicatedTagSet> : public TStructOpsTypeTraitsBase2<FNoctReplicatedTagSet>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+// A cooldown as the owning client sees it, the end time is in server world time
+USTRUCT()
+struct FNoctReplicatedCooldown : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FGameplayTag Tag;
+
+	UPROPERTY()
+	float EndTime = 0.0f;
+
+	UPROPERTY()
+	float Duration = 0.0f;
+
+	UPROPERTY()
+	uint8 MaxCharges = 0;
+
+	UPROPERTY()
+	TArray<float> ChargeReadyTimes;
+
+	// The table entry this replicates, with the times back in double
+	FNoctCooldownEntry ToEntry() const;
+};
+
+/**
+ * The component's cooldown table replicated as end times, one item per tag that has been on cooldown.
+ * Items only change when a cooldown starts or is cleared, expiry is worked out by the client from the end time.
+ */
+USTRUCT()
+struct NOCTABILITYSYSTEM_API FNoctReplicatedCooldownList : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FNoctReplicatedCooldown> Items;
+
+	UNoctAbilityComponent* Owner = nullptr;
+
+	// Mirror the table entry for Tag, a null Entry clears the cooldown
+	void SetCooldown(FGameplayTag Tag, const FNoctCooldownEntry* Entry);
+
+	void PostReplicatedAdd(const TArrayView<int32>& AddedIndices, int32 FinalSize);
+	void PostReplicatedChange(const TArrayView<int32>& ChangedIndices, int32 FinalSize);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FNoctReplicatedCooldown, FNoctReplicatedCooldownList>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FNoctReplicatedCooldownList> : public TStructOpsTypeTraitsBase2<FNoctReplicatedCooldownList>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
@@ -0,0 +1,100 @@
+﻿// Copyright Nocturnum Games 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "NoctCue.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NoctAbilitySubsystem.generated.h"
+
+class UNoctAbilityComponent;
+
+// How much an ability component's updates matter, by distance to the nearest player
+UENUM(BlueprintType)
+enum class ENoctSignificanceTier : uint8
+{
+	High,
+	Medium,
+	Low
+};
+
+/**
+ * Knows every ability component in the world and budgets the work that doesn't have to happen right away.
+ * Components far from every player tick less often and have their cooldown notifications deferred,
+ * which are then sent within a per frame time budget. Distances and budgets are in UNoctAbilitySystemSettings.
+ * Cues sent by effects are collected over the frame and sent once per component at the end of it.
+ */
+UCLASS()
+class NOCTABILITYSYSTEM_API UNoctAbilitySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UNoctAbilitySubsystem* Get(const UWorld* World);
+	
+	void RegisterComponent(UNoctAbilityComponent* Component);
+	void UnregisterComponent(UNoctAbilityComponent* Component);
+
+	// Send a component's finished cooldowns later, when the frame budget allows
+	void DeferCooldownNotifications(UNoctAbilityComponent* Component, const FGameplayTagContainer& FinishedCooldownTags);
+
+	// Send a cue for each of CueTags with the next batch of Component's cues
+	void QueueCues(UNoctAbilityComponent* Component, const FGameplayTagContainer& CueTags, ENoctCueEvent Event, float Magnitude);
+
+	// Pass cues to the handlers for their tags. Does nothing on dedicated servers.
+	void HandleCues(AActor* Target, TConstArrayView<FNoctCue> Cues);
+
+	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem")
+	int32 GetNumDeferredNotifications() const
+	{
+		return DeferredNotifications.Num();
+	}
+
+	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem")
+	int32 GetNumComponentsInTier(ENoctSignificanceTier Tier) const;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+private:
+	// Work out the tier of as many components as fit before Deadline, continuing where the last call stopped
+	void UpdateSignificance(double Deadline);
+	void FlushDeferredNotifications(double Deadline);
+	void FlushCues();
+
+	// Handlers for CueTag, created and cached on first use
+	TConstArrayView<UNoctCueHandler*> GetCueHandlers(FGameplayTag CueTag);
+
+	ENoctSignificanceTier GetTierForDistanceSquared(double DistanceSquared) const;
+
+	TArray<TWeakObjectPtr<UNoctAbilityComponent>> Components;
+
+	struct FDeferredNotification
+	{
+		TWeakObjectPtr<UNoctAbilityComponent> Component;
+		FGameplayTagContainer FinishedCooldownTags;
+	};
+
+	// Oldest first
+	TArray<FDeferredNotification> DeferredNotifications;
+
+	// Cues sent this frame, per component
+	TMap<TWeakObjectPtr<UNoctAbilityComponent>, TArray<FNoctCue>> PendingCues;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UNoctCueHandler>> CueHandlers;
+
+	bool bCueHandlersCreated = false;
+
+	// Matching handlers by exact cue tag, kept alive by CueHandlers
+	TMap<FGameplayTag, TArray<UNoctCueHandler*, TInlineAllocator<2>>> CueHandlersByTag;
+
+	// Player view locations for the significance pass in progress
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+	
+	int32 NextSignificanceIndex = INDEX_NONE;
+	double NextSignificancePassTime = 0.0;
+	int32 NumComponentsInTier[3] = {};
+	int32 NumComponentsInTierThisPass[3] = {};
+};
@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
+NOCTABILITYSYSTEM_API DECLARE_LOG_CATEGORY_EXTERN(LogNoctAbilitySystem, Log, All);
+
 class FNoctAbilitySystemModule : public IModuleInterface
 {
 public:
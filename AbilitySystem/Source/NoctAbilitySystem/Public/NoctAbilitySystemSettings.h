@@ -0,0 +1,51 @@
+﻿// Copyright Nocturnum Games 2023 
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "GameplayTagContainer.h"
+#include "NoctCue.h"
+#include "NoctAbilitySystemSettings.generated.h"
+
+/**
+ * Project wide settings for the ability system
+ */
+UCLASS(Config = Game, DefaultConfig, meta = (DisplayName = "Noct Ability System"))
+class NOCTABILITYSYSTEM_API UNoctAbilitySystemSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	// Tags tracked as bits on ability components, so blocking and activation checks are a few word ANDs.
+	// Children of these tags are included. Leave empty to only use the tag containers.
+	UPROPERTY(Config, EditAnywhere, Category = "Tag Bits", meta = (ConfigRestartRequired = true))
+	FGameplayTagContainer IndexedTags;
+
+	// Components further than this from every player update less often
+	UPROPERTY(Config, EditAnywhere, Category = "Significance", meta = (ClampMin = 0, Units = "cm"))
+	float MediumSignificanceDistance = 3000.0f;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Significance", meta = (ClampMin = 0, Units = "cm"))
+	float LowSignificanceDistance = 8000.0f;
+
+	// Tick interval of components in each tier. Timed effects catch up on skipped triggers, so only their timing gets coarser.
+	UPROPERTY(Config, EditAnywhere, Category = "Significance", meta = (ClampMin = 0, Units = "s"))
+	float MediumSignificanceTickInterval = 0.1f;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Significance", meta = (ClampMin = 0, Units = "s"))
+	float LowSignificanceTickInterval = 0.5f;
+
+	// How often significance is worked out again
+	UPROPERTY(Config, EditAnywhere, Category = "Significance", meta = (ClampMin = 0, Units = "s"))
+	float SignificanceUpdateInterval = 0.25f;
+
+	// Time per frame the subsystem may spend on deferred work, anything left over waits for the next frame
+	UPROPERTY(Config, EditAnywhere, Category = "Significance", meta = (ClampMin = 0, Units = "ms"))
+	float DeferredWorkBudgetMs = 0.5f;
+
+	// Handlers for the cues effects send, a cue goes to every handler whose tag it matches.
+	// Only loaded where cues are shown, so dedicated servers never load them.
+	UPROPERTY(Config, EditAnywhere, Category = "Cues")
+	TArray<TSoftClassPtr<UNoctCueHandler>> CueHandlers;
+};
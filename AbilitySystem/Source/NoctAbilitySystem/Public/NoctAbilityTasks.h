@@ -0,0 +1,152 @@
+﻿// Copyright Nocturnum Games 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "NoctAbilityTasks.generated.h"
+
+// What an ability task is waiting for
+UENUM(BlueprintType)
+enum class ENoctAbilityTaskType : uint8
+{
+	// A fixed amount of time
+	WaitDelay,
+	// The ability's activation input being completed or cancelled
+	WaitInputReleased,
+	// An attribute on the owning component changing, or crossing a threshold
+	WaitAttributeChange,
+	// No effect with the tag being applied to the owning component anymore
+	WaitEffectRemoved,
+	// A matching ability tag becoming active on the owning component
+	WaitTagAdded
+};
+
+UENUM(BlueprintType)
+enum class ENoctAttributeThreshold : uint8
+{
+	// Any change from the value the task started with
+	AnyChange,
+	AtOrAbove,
+	AtOrBelow
+};
+
+/**
+ * Refers to one ability task. Task slots are reused, the serial tells a stale handle from the task now in its slot.
+ */
+USTRUCT(BlueprintType)
+struct NOCTABILITYSYSTEM_API FNoctAbilityTaskHandle
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Index = INDEX_NONE;
+
+	UPROPERTY()
+	uint32 Serial = 0;
+
+	FNoctAbilityTaskHandle() = default;
+
+	FNoctAbilityTaskHandle(const int32 InIndex, const uint32 InSerial)
+		: Index(InIndex), Serial(InSerial)
+	{
+	}
+
+	bool IsValid() const
+	{
+		return Index != INDEX_NONE;
+	}
+
+	bool operator==(const FNoctAbilityTaskHandle& Other) const
+	{
+		return Index == Other.Index && Serial == Other.Serial;
+	}
+};
+
+// A wait started by an ability, checked by the owning component
+struct FNoctAbilityTask
+{
+	ENoctAbilityTaskType Type = ENoctAbilityTaskType::WaitDelay;
+
+	// The ability that started the task and is told when it completes
+	FGameplayTag AbilityTag;
+
+	// The attribute, effect or ability tag waited on
+	FGameplayTag Tag;
+
+	double StartTime = 0.0;
+
+	// WaitDelay only
+	float Duration = 0.0f;
+
+	// WaitAttributeChange only
+	ENoctAttributeThreshold Threshold = ENoctAttributeThreshold::AnyChange;
+	float ThresholdValue = 0.0f;
+	float StartValue = 0.0f;
+
+	// Set when the condition already held when the task started, it then completes on the next tick
+	bool bConditionMet = false;
+
+	uint32 Serial = 0;
+
+	bool IsActive() const
+	{
+		return Serial != 0;
+	}
+
+	// Checked every tick rather than completed by an event on the component
+	bool IsPolled() const
+	{
+		return bConditionMet || Type == ENoctAbilityTaskType::WaitDelay || Type == ENoctAbilityTaskType::WaitAttributeChange;
+	}
+};
+
+/**
+ * Every ability task on a component in one array. Finished tasks leave their slot to the next one,
+ * so once the array has grown to the most tasks running at a time, starting and finishing tasks allocates nothing.
+ */
+struct NOCTABILITYSYSTEM_API FNoctAbilityTaskList
+{
+	FNoctAbilityTaskHandle Add(const FNoctAbilityTask& Task);
+
+	// Free the task's slot. False if the handle is stale.
+	bool Remove(FNoctAbilityTaskHandle Handle);
+
+	// Free every task started by the ability with AbilityTag
+	int32 RemoveAll(FGameplayTag AbilityTag);
+
+	const FNoctAbilityTask* Find(const FNoctAbilityTaskHandle Handle) const
+	{
+		return Tasks.IsValidIndex(Handle.Index) && Tasks[Handle.Index].Serial == Handle.Serial ? &Tasks[Handle.Index] : nullptr;
+	}
+
+	FNoctAbilityTaskHandle GetHandle(const int32 Index) const
+	{
+		return FNoctAbilityTaskHandle(Index, Tasks[Index].Serial);
+	}
+
+	// Tasks started from here on have a serial of at least this, so a pass can skip tasks started while it runs
+	uint32 GetNextSerial() const
+	{
+		return NextSerial;
+	}
+
+	int32 Num() const
+	{
+		return NumActive;
+	}
+
+	bool HasPolledTasks() const
+	{
+		return NumPolled > 0;
+	}
+
+	// Indexed by slot, check IsActive before using one
+	TArray<FNoctAbilityTask> Tasks;
+
+private:
+	TArray<int32> FreeIndices;
+	uint32 NextSerial = 1;
+	int32 NumActive = 0;
+	int32 NumPolled = 0;
+};
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "UObject/Object.h"
 #include "GameplayTagContainer.h"
+#include "NoctCompactModifier.h"
 #include "NoctAttribute.generated.h"
 
 /**
@@ -37,9 +38,9 @@ struct FNoctAttributeModifier
 {
 	GENERATED_BODY()
 
-	// Unique identifier for the modifier
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NoctAbilitySystem")
-	FGuid Id = FGuid::NewGuid();
+	// Identifies the modifier once it's added to an attribute, 0 before
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	int32 Handle = 0;
 	
 	// The value of the modifier
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NoctAbilitySystem")
@@ -49,7 +50,8 @@ struct FNoctAttributeModifier
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NoctAbilitySystem")
 	bool bIsPercentage = false;
 
-	// The source of the modifier
+	// The source of the modifier. Once added, an attribute only holds it weakly: the modifier doesn't keep its source
+	// alive and reads back with no source after it's destroyed, so remove modifiers with RemoveModifiersBySource first.
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NoctAbilitySystem")
 	UObject* Source = nullptr;
 	
@@ -75,13 +77,11 @@ struct FNoctAttributeModifier
 	
 	FNoctAttributeModifier()
 	{
-		Id = FGuid::NewGuid();
 	}
 	
 	FNoctAttributeModifier(float InValue, bool bInIsPercentage, UObject* InSource = nullptr)
 		: Value(InValue), bIsPercentage(bInIsPercentage), Source(InSource)
 	{
-		Id = FGuid::NewGuid();
 	}
 	
 	// Add tag to this modifier
@@ -109,8 +109,33 @@ struct FNoctAttributeModifier
 	}
 };
 
+/**
+ * FNoctAttribute the way it's saved, with the modifiers in full under the property names they had before attributes
+ * stored them compact. Data saved either way loads the same.
+ */
+USTRUCT()
+struct FNoctSerializedAttribute
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	float MaxValue = 1;
+
+	UPROPERTY()
+	float CurrentValue = 1;
+
+	UPROPERTY()
+	float BaseValue = 1;
+
+	UPROPERTY()
+	TArray<FNoctAttributeModifier> FlatModifiers;
+
+	UPROPERTY()
+	TArray<FNoctAttributeModifier> PercentModifiers;
+};
+
 USTRUCT(Blueprintable)
-struct FNoctAttribute
+struct NOCTABILITYSYSTEM_API FNoctAttribute
 {
 	GENERATED_BODY()
  
@@ -126,22 +151,21 @@ struct FNoctAttribute
 	UPROPERTY(EditAnywhere, Category = "NoctAbilitySystem")
 	float BaseValue = 1;
 	
-	// Flat modifiers that are added directly to the base value
-	UPROPERTY(EditAnywhere, Category = "NoctAbilitySystem")
-	TArray<FNoctAttributeModifier> FlatModifiers;
+	// Flat modifiers that are added directly to the base value.
+	// Stored compact, use GetModifiers for the full modifiers. Saved and duplicated through Serialize.
+	TArray<FNoctCompactModifier> FlatModifiers;
 	
 	// Percentage modifiers that scale the value after flat modifiers
-	UPROPERTY(EditAnywhere, Category = "NoctAbilitySystem")
-	TArray<FNoctAttributeModifier> PercentModifiers;
+	TArray<FNoctCompactModifier> PercentModifiers;
 	
-	// Add a modifier to the attribute
-	void AddModifier(const FNoctAttributeModifier& Modifier);
+	// Add a modifier to the attribute, returns the handle of the modifier it ended up in
+	int32 AddModifier(const FNoctAttributeModifier& Modifier);
 	
 	// Remove modifiers by source
 	void RemoveModifiersBySource(UObject* Source);
 	
-	// Remove a specific modifier by ID
-	void RemoveModifierById(const FGuid& ModifierId);
+	// Remove a specific modifier by the handle AddModifier returned
+	void RemoveModifierByHandle(int32 Handle);
 	
 	// Remove modifiers with a specific tag
 	void RemoveModifiersByTag(const FGameplayTag& Tag);
@@ -161,12 +185,35 @@ struct FNoctAttribute
 	// Get the combined value of all modifiers
 	float GetModifierValue() const;
 	
+	// Sum of the flat modifiers
+	float GetFlatModifierSum() const;
+	
+	// Product of the percentage modifiers, 1 with none
+	float GetPercentModifierScale() const;
+	
 	// Get the stack count for a specific stacking modifier
 	int32 GetStackCount(const FGameplayTag& StackTag) const;
 	
+	// Get every modifier, flat ones first
+	TArray<FNoctAttributeModifier> GetModifiers() const;
+	
 	// Get modifiers with a specific tag
 	TArray<FNoctAttributeModifier> GetModifiersWithTag(const FGameplayTag& Tag) const;
 	
 	// Get modifiers that match any of the specified tags
 	TArray<FNoctAttributeModifier> GetModifiersWithAnyTags(const FGameplayTagContainer& Tags) const;
+
+	// Saves the modifiers in full as FNoctSerializedAttribute, loading gives them new handles
+	bool Serialize(FArchive& Ar);
+	bool Identical(const FNoctAttribute* Other, uint32 PortFlags) const;
+};
+
+template<>
+struct TStructOpsTypeTraits<FNoctAttribute> : public TStructOpsTypeTraitsBase2<FNoctAttribute>
+{
+	enum
+	{
+		WithSerializer = true,
+		WithIdentical = true,
+	};
 };
@@ -0,0 +1,160 @@
+﻿// Copyright Nocturnum Games 2023 
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Misc/ScopeRWLock.h"
+#include "UObject/ObjectKey.h"
+
+enum class EModifierStackingPolicy : uint8;
+struct FNoctAttributeModifier;
+
+/**
+ * How FNoctAttribute stores a modifier. Everything a modifier usually shares with many others
+ * (its source, tags and stack tag) is an index into FNoctModifierTables, so a modifier is a small value with no allocations.
+ * The source is only referenced weakly, it reads back as null once the object is destroyed.
+ */
+struct NOCTABILITYSYSTEM_API FNoctCompactModifier
+{
+	float Value = 0.0f;
+
+	// Unique for the session, 0 is never used
+	int32 Handle = 0;
+
+	// Index 0 of each table is no source, no tags and no stack tag. See FNoctModifierTables for how source indices are made.
+	uint32 SourceIndex = 0;
+	uint32 TagSetIndex = 0;
+	uint16 StackTagIndex = 0;
+
+	uint16 StackCount = 1;
+
+	// 0 is unlimited
+	uint16 MaxStacks = 0;
+
+	uint8 bIsPercentage : 1;
+	uint8 StackingPolicy : 3;
+
+	FNoctCompactModifier()
+		: bIsPercentage(false)
+		, StackingPolicy(0)
+	{
+	}
+
+	// Interns the modifier's source and tags, and gives it a new handle
+	static FNoctCompactModifier Make(const FNoctAttributeModifier& Modifier);
+
+	// The full modifier back, for Blueprint and debugging
+	FNoctAttributeModifier Expand() const;
+
+	EModifierStackingPolicy GetStackingPolicy() const
+	{
+		return static_cast<EModifierStackingPolicy>(StackingPolicy);
+	}
+
+	const FGameplayTagContainer& GetTags() const;
+	FGameplayTag GetStackTag() const;
+	UObject* GetSource() const;
+};
+
+static_assert(sizeof(FNoctCompactModifier) <= 24, "FNoctCompactModifier is stored per modifier, keep it small");
+
+/**
+ * The shared source and stack tag tables FNoctCompactModifier indexes into. Tag sets live in FNoctTagContainerRegistry.
+ * Stack tags are never removed. Sources are weak, and the slots of destroyed ones are reclaimed as the table grows:
+ * a source index is the slot plus a generation in the top 8 bits, so a modifier still holding the index of a reclaimed
+ * slot reads back a null source rather than whatever took the slot over.
+ * Safe from any thread like FNoctTagContainerRegistry, attributes with default modifiers can be loaded asynchronously.
+ */
+class NOCTABILITYSYSTEM_API FNoctModifierTables
+{
+public:
+	static FNoctModifierTables& Get();
+
+	uint32 InternSource(const UObject* Source);
+
+	// 0 if Source isn't interned, so no modifier can have it
+	uint32 FindSource(const UObject* Source) const
+	{
+		if (!Source)
+		{
+			return 0;
+		}
+
+		FReadScopeLock ReadLock(Lock);
+		const uint32* Index = SourceIndices.Find(FObjectKey(Source));
+		return Index ? *Index : 0;
+	}
+
+	// Null once the object is gone
+	UObject* GetSource(const uint32 Index) const
+	{
+		FReadScopeLock ReadLock(Lock);
+		const FSourceEntry& Entry = Sources[Index & SourceSlotMask];
+		return Entry.Index == Index ? Entry.Object.Get() : nullptr;
+	}
+
+	uint16 InternStackTag(const FGameplayTag& Tag);
+
+	uint16 FindStackTag(const FGameplayTag& Tag) const
+	{
+		if (!Tag.IsValid())
+		{
+			return 0;
+		}
+
+		FReadScopeLock ReadLock(Lock);
+		const uint16* Index = StackTagIndices.Find(Tag);
+		return Index ? *Index : 0;
+	}
+
+	FGameplayTag GetStackTag(const uint16 Index) const
+	{
+		FReadScopeLock ReadLock(Lock);
+		return StackTags[Index];
+	}
+
+	int32 MakeHandle()
+	{
+		FWriteScopeLock WriteLock(Lock);
+		LastHandle = LastHandle == MAX_int32 ? 1 : LastHandle + 1;
+		return LastHandle;
+	}
+
+	// Free the slots of sources that have been destroyed, done automatically when the table doubles in size
+	void ReclaimStaleSources();
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	FNoctModifierTables();
+
+	static constexpr uint32 SourceSlotMask = (1u << 24) - 1;
+
+	struct FSourceEntry
+	{
+		FWeakObjectPtr Object;
+		FObjectKey Key;
+
+		// Slot and generation, what modifiers hold
+		uint32 Index = 0;
+	};
+
+	// ReclaimStaleSources with the write lock already held
+	void ReclaimStaleSourcesLocked();
+
+	TArray<FSourceEntry> Sources;
+	TMap<FObjectKey, uint32> SourceIndices;
+	TArray<uint32> FreeSourceSlots;
+
+	// Sources.Num() at which stale sources are next reclaimed
+	int32 ReclaimSourcesAt = 1024;
+
+	TArray<FGameplayTag> StackTags;
+	TMap<FGameplayTag, uint16> StackTagIndices;
+
+	int32 LastHandle = 0;
+
+	// The arrays reallocate as they grow, so readers take it too
+	mutable FRWLock Lock;
+};
@@ -0,0 +1,141 @@
+﻿// Copyright Nocturnum Games 2023 
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "NoctCooldownTable.generated.h"
+
+UENUM(BlueprintType)
+enum class ENoctChargeRechargePolicy : uint8
+{
+	// One charge recharges at a time, the next one starts once the previous is back
+	Sequential,
+	// Every spent charge recharges on its own, starting when it was spent
+	Parallel
+};
+
+/**
+ * A single cooldown, keyed by the tag of the ability it belongs to.
+ * With charges the entry holds when each spent charge comes back, and is only on cooldown while none are left.
+ */
+USTRUCT(BlueprintType)
+struct FNoctCooldownEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	FGameplayTag Tag;
+
+	// World time the cooldown ends at
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	double EndTime = 0.0;
+
+	// Length the cooldown was started with, the recharge time of one charge with charges
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	float Duration = 0.0f;
+
+	// 0 for a plain cooldown
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	int32 MaxCharges = 0;
+
+	// World time each spent charge is back at, soonest first. Times that have passed are dropped when the next charge is spent.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	TArray<double> ChargeReadyTimes;
+
+	int32 GetCharges(double Now) const;
+
+	// When the next spent charge is back, 0 if none are recharging
+	double GetNextChargeTime(double Now) const;
+};
+
+/**
+ * Every cooldown on an ability component, stored as end times so "is on cooldown" is a time comparison.
+ * Expiry is tracked with a min-heap on end time, so finding what ended this frame only looks at the cooldowns that did.
+ */
+USTRUCT(BlueprintType)
+struct NOCTABILITYSYSTEM_API FNoctCooldownTable
+{
+	GENERATED_BODY()
+
+	// One entry per tag that has ever been on cooldown. Entries are reused when the cooldown restarts.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	TArray<FNoctCooldownEntry> Entries;
+
+	// Tags currently on cooldown. Only changes when a cooldown starts, is cleared or ends.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	FGameplayTagContainer ActiveTags;
+
+	// Start or restart the cooldown for Tag
+	void Start(FGameplayTag Tag, double Now, float Duration);
+
+	// End the cooldown for Tag without it counting as expired. Refills every charge.
+	void Clear(FGameplayTag Tag);
+
+	// Spend one of Tag's charges. Spending the last one puts the tag on cooldown until the next charge is back.
+	void SpendCharge(FGameplayTag Tag, double Now, int32 MaxCharges, float RechargeTime, ENoctChargeRechargePolicy RechargePolicy);
+
+	// Move the end of Tag's cooldown without touching its charges. An end time that has passed takes it off cooldown.
+	void SetEndTime(FGameplayTag Tag, double Now, double EndTime);
+
+	// Overwrite the entry for Entry.Tag, such as with a replicated one or one saved before a prediction
+	void Restore(const FNoctCooldownEntry& Entry, double Now);
+
+	bool IsOnCooldown(const FGameplayTag Tag, const double Now) const
+	{
+		const FNoctCooldownEntry* Entry = Find(Tag);
+		return Entry && Entry->EndTime > Now;
+	}
+
+	float GetRemaining(FGameplayTag Tag, double Now) const;
+
+	const FNoctCooldownEntry* Find(const FGameplayTag Tag) const
+	{
+		const int32* Index = IndexByTag.Find(Tag);
+		return Index ? &Entries[*Index] : nullptr;
+	}
+
+	bool HasPendingExpiry() const
+	{
+		return ExpiryHeap.Num() > 0;
+	}
+
+	// Remove every cooldown that has ended by Now from the active set, adding their tags to OutExpired
+	template <typename AllocatorType>
+	void CollectExpired(const double Now, TArray<FGameplayTag, AllocatorType>& OutExpired)
+	{
+		FGameplayTag ExpiredTag;
+		while (PopExpired(Now, ExpiredTag))
+		{
+			OutExpired.Add(ExpiredTag);
+		}
+	}
+
+private:
+	struct FExpiry
+	{
+		double EndTime;
+		FGameplayTag Tag;
+	};
+
+	struct FExpiryPredicate
+	{
+		bool operator()(const FExpiry& A, const FExpiry& B) const
+		{
+			return A.EndTime < B.EndTime;
+		}
+	};
+
+	FNoctCooldownEntry& FindOrAddEntry(FGameplayTag Tag);
+
+	// Pop the next cooldown that has ended by Now, skipping stale expiries. False once there are none left.
+	bool PopExpired(double Now, FGameplayTag& OutTag);
+
+	// Drop every expiry of Tag, so a cleared cooldown doesn't keep the owner ticking until its old end time
+	void RemoveExpiries(FGameplayTag Tag);
+
+	TMap<FGameplayTag, int32> IndexByTag;
+
+	// Restarted cooldowns leave their old expiry behind, those are skipped when popped. Cleared ones are removed.
+	TArray<FExpiry> ExpiryHeap;
+};
@@ -0,0 +1,61 @@
+﻿// Copyright Nocturnum Games 2023 
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "UObject/Object.h"
+#include "NoctCue.generated.h"
+
+// What happened to the effect that sent a cue
+UENUM(BlueprintType)
+enum class ENoctCueEvent : uint8
+{
+	Applied,
+	Triggered,
+	Removed
+};
+
+/**
+ * One cosmetic event sent by an effect, for cue handlers to show.
+ * Sent to clients in per frame batches, the tag serializes as its net index.
+ */
+USTRUCT(BlueprintType)
+struct NOCTABILITYSYSTEM_API FNoctCue
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "NoctAbilitySystem")
+	FGameplayTag CueTag;
+
+	UPROPERTY(BlueprintReadOnly, Category = "NoctAbilitySystem")
+	ENoctCueEvent Event = ENoctCueEvent::Applied;
+
+	// Magnitude of the effect that sent the cue
+	UPROPERTY(BlueprintReadOnly, Category = "NoctAbilitySystem")
+	float Magnitude = 0.0f;
+};
+
+/**
+ * Shows the particles, sounds and the like for a cue tag and its children.
+ * Add handler classes to UNoctAbilitySystemSettings::CueHandlers, each world that shows cues makes one instance of each.
+ * Never created on dedicated servers.
+ */
+UCLASS(Abstract, Blueprintable, BlueprintType)
+class NOCTABILITYSYSTEM_API UNoctCueHandler : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	// Cues with this tag or one of its children are sent to this handler
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	FGameplayTag CueTag;
+
+	// Calls OnCue, override to show a cue natively
+	virtual void HandleCue(AActor* Target, const FNoctCue& Cue);
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "NoctAbilitySystem")
+	void OnCue(AActor* Target, FGameplayTag Tag, ENoctCueEvent Event, float Magnitude);
+
+	virtual UWorld* GetWorld() const override;
+};
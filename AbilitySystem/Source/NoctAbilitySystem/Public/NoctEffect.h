@@ -5,9 +5,14 @@
 #include "CoreMinimal.h"
 #include "GameplayTagContainer.h"
 #include "UObject/Object.h"
+#include "Curves/CurveFloat.h"
+#include "NoctScalingTable.h"
+#include "NoctSharedTagContainer.h"
+#include "NoctCue.h"
 #include "NoctEffect.generated.h"
 
 class UNoctAbilityComponent;
+class UNoctEffect;
 
 UENUM(BlueprintType)
 enum class ENoctAttributeOperation : uint8
@@ -24,6 +29,102 @@ enum class ENoctAttributeOperation : uint8
 	Set          UMETA(DisplayName = "Set")
 };
 
+/**
+ * Pre-evaluated data for applying an effect class at a given level.
+ * Built once with UNoctEffect::MakeEffectSpec so the class defaults and magnitude scaling
+ * are only read once, no matter how many targets the spec is applied to.
+ */
+USTRUCT(BlueprintType)
+struct FNoctEffectSpec
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NoctAbilitySystem")
+	TSubclassOf<UNoctEffect> EffectClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NoctAbilitySystem")
+	int32 Level = 1;
+
+	// Level scaled magnitude, evaluated when the spec was made
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NoctAbilitySystem")
+	float Magnitude = 0.0f;
+
+	// Copied from the class defaults, used for the block and duplicate checks on each target
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NoctAbilitySystem")
+	FGameplayTag EffectTag;
+
+	bool IsValid() const
+	{
+		return EffectClass != nullptr;
+	}
+};
+
+/**
+ * Fixed step schedule for a timed effect.
+ * Trigger times are derived from the start time rather than accumulated per frame, so an effect always fires
+ * exactly floor(Duration / TriggerInterval) times no matter how long the frames are. Triggers missed during a
+ * hitch are all reported as due on the next advance, each with the time it should have happened at.
+ */
+USTRUCT(BlueprintType)
+struct NOCTABILITYSYSTEM_API FNoctEffectTimeline
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	double StartTime = 0.0;
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	float Duration = 0.0f;
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	float TriggerInterval = 0.0f;
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	int32 TotalTriggers = 0;
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	int32 TriggersFired = 0;
+
+	// Start the timeline. Non periodic timelines only track the duration.
+	void Start(double Now, float InDuration, float InTriggerInterval, bool bPeriodic);
+
+	// Number of triggers that should have fired by Now but haven't yet
+	int32 GetTriggersDue(double Now) const;
+
+	// Fire every trigger that has come due by Now in order, calling OnTrigger with each one's scheduled time.
+	// OnTrigger returns false to stop, such as when the trigger removed its effect. False if it was stopped.
+	template <typename FuncType>
+	bool Advance(const double Now, FuncType&& OnTrigger)
+	{
+		for (int32 TriggersDue = GetTriggersDue(Now); TriggersDue > 0; --TriggersDue)
+		{
+			const double TriggerTime = GetNextTriggerTime();
+			++TriggersFired;
+			if (!OnTrigger(TriggerTime))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// The time the next unfired trigger was scheduled for
+	double GetNextTriggerTime() const
+	{
+		return StartTime + static_cast<double>(TriggersFired + 1) * TriggerInterval;
+	}
+
+	double GetEndTime() const
+	{
+		return StartTime + Duration;
+	}
+
+	bool IsExpired(const double Now) const
+	{
+		return Now >= GetEndTime() - UE_KINDA_SMALL_NUMBER;
+	}
+};
+
 /**
  * 
  */
@@ -35,6 +136,13 @@ class NOCTABILITYSYSTEM_API UNoctEffect : public UObject
 	UNoctEffect();
 	
 public:
+	virtual void PostInitProperties() override;
+	virtual void PostLoad() override;
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
 	UFUNCTION(BlueprintImplementableEvent)
 	void OnEffectApplied();
 
@@ -54,26 +162,71 @@ public:
 
 	UFUNCTION()
 	void EffectRemoved();
+
+	// Continue an effect that was already running elsewhere (e.g. as a Mass entity) from its timeline.
+	// Triggers that already fired don't fire again and abilities aren't cancelled a second time.
+	void EffectResumed(const FNoctEffectTimeline& InTimeline);
 	
 	UFUNCTION()
 	void NativeEffectTriggered();
 
+	// False on dedicated servers when the Blueprint events are marked cosmetic
+	bool ShouldRunBlueprintEvents() const;
+
+	// Queue a cue for each of CueTags, sent with the owning component's next batch
+	void SendCues(ENoctCueEvent Event) const;
+
+	// Fire every trigger that has come due by Now, then complete the effect if its duration has passed.
+	// Driven by the owning component's tick.
+	void AdvanceTimeline(double Now);
+
+	// True while the effect is applied and waiting on its timeline
+	bool IsTimed() const
+	{
+		return bIsActiveAndApplied && !bPermanent;
+	}
+
+	// Build a spec for applying EffectClass to one or many targets. A level of 0 uses the class default level.
+	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem")
+	static FNoctEffectSpec MakeEffectSpec(TSubclassOf<UNoctEffect> EffectClass, int32 InLevel = 0);
+
+	// Copy the per application values of a spec onto this instance
+	void InitializeFromSpec(const FNoctEffectSpec& Spec);
+
+	// Restore this instance to its class defaults so it can be handed out again by the effect pool
+	void ResetForReuse();
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NoctAbilitySystem|Magnitude")
 	UCurveFloat* MagnitudeScalingCurve = nullptr;
 	
-	/** Calculate the final magnitude of the effect with level scaling */
+	/** Final magnitude of the effect with level scaling. Applied instances return the magnitude of their spec,
+	 *  which was evaluated once when the spec was made, class defaults evaluate it for their Level. */
 	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem|Magnitude")
 	float GetFinalMagnitude() const
+	{
+		// Instances are always made by a component and initialized from a spec before they are applied
+		return OwningAbilityComponent ? AppliedMagnitude : GetMagnitudeAtLevel(Level);
+	}
+
+	float GetMagnitudeAtLevel(int32 InLevel) const
 	{
 		// If we have a curve, use it for scaling based on level
 		if (MagnitudeScalingCurve)
 		{
-			return BaseMagnitude * MagnitudeScalingCurve->GetFloatValue(Level);
+			return BaseMagnitude * MagnitudeScalingTable.Evaluate(MagnitudeScalingCurve, InLevel);
 		}
 		// Otherwise use the linear scaling factor
-		return BaseMagnitude + (MagnitudeScalePerLevel * (Level - 1));
+		return BaseMagnitude + (MagnitudeScalePerLevel * (InLevel - 1));
 	}
 
+	// Re-bake the level tables. Only needed if the scaling curve or max level is changed at runtime.
+	UFUNCTION(BlueprintCallable, Category = "NoctAbilitySystem|Magnitude")
+	void BakeScalingTables();
+
+	// MagnitudeScalingCurve baked for levels 0 to MaxLevel
+	UPROPERTY()
+	FNoctScalingTable MagnitudeScalingTable;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NoctAbilitySystem")
 	FGameplayTag EffectTag;
 	
@@ -100,30 +253,84 @@ public:
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NoctAbilitySystem|Level")
 	int32 MaxLevel = 5;
+
+	// Magnitude of the spec this instance was applied with
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem|Magnitude")
+	float AppliedMagnitude = 0.0f;
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NoctAbilitySystem|Target")
 	FGameplayTag TargetAttributeTag;
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NoctAbilitySystem|Magnitude")
 	ENoctAttributeOperation AttributeOperation;
+
+	// Apply AttributeOperation with the applied magnitude to the target attribute's base value on every trigger, before
+	// OnEffectTriggered. Honoured the same way on components and Mass entities, which can't run the Blueprint events
+	// and leave attributes alone without it. Off by default, as effects that change the attribute in Blueprint would do it twice.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem|Magnitude")
+	bool bApplyAttributeOperationNatively = false;
+
+	static float ApplyAttributeOperation(ENoctAttributeOperation Operation, float Value, float Magnitude);
 	
-	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
-	FGameplayTagContainer AppliedTags;
+	// Shared with every other effect that has the same tags, read them in Blueprint with the getters below.
+	// These were BlueprintReadOnly containers, a graph that got one as a variable gets it from its getter now.
+	UPROPERTY(VisibleInstanceOnly, Category = "NoctAbilitySystem")
+	FNoctSharedTagContainer AppliedTags;
 
-	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
-	FGameplayTagContainer BlockedTags;
+	UPROPERTY(VisibleInstanceOnly, Category = "NoctAbilitySystem")
+	FNoctSharedTagContainer BlockedTags;
 
-	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
-	FGameplayTagContainer AbilitiesToCancel;
+	UPROPERTY(VisibleInstanceOnly, Category = "NoctAbilitySystem")
+	FNoctSharedTagContainer AbilitiesToCancel;
+
+	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem")
+	const FGameplayTagContainer& GetAppliedTags() const
+	{
+		return AppliedTags.Get();
+	}
+
+	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem")
+	const FGameplayTagContainer& GetBlockedTags() const
+	{
+		return BlockedTags.Get();
+	}
+
+	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem")
+	const FGameplayTagContainer& GetAbilitiesToCancel() const
+	{
+		return AbilitiesToCancel.Get();
+	}
+
+	// Cosmetic events for this effect, shown by the cue handlers in UNoctAbilitySystemSettings.
+	// Sent as the effect is applied, triggered and removed, and never handled on dedicated servers.
+	UPROPERTY(EditDefaultsOnly, Category = "NoctAbilitySystem|Cues")
+	FNoctSharedTagContainer CueTags;
+
+	UFUNCTION(BlueprintPure, Category = "NoctAbilitySystem|Cues")
+	const FGameplayTagContainer& GetCueTags() const
+	{
+		return CueTags.Get();
+	}
+
+	// OnEffectApplied, OnEffectTriggered and OnEffectRemoved only show things, so dedicated servers skip them.
+	// Anything that changes game state belongs in a native effect or an effect without this set.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "NoctAbilitySystem|Cues")
+	bool bCosmeticBlueprintEvents = false;
+
+	// Active abilities whose tag matches this are cancelled as well when the effect is applied
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NoctAbilitySystem")
+	FGameplayTagQuery AbilityCancelQuery;
 
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
 	bool bIsActiveAndApplied = false;
 	
-	// Loops the OnEffectTriggered event every x seconds.
-	FTimerHandle EffectTimerHandle;
+	// Schedule of the triggers and duration of the effect.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	FNoctEffectTimeline Timeline;
 
-	// Duration of the effect.
-	FTimerHandle EffectDurationTimerHandle;
+	// The time the current trigger was scheduled for. When catching up after a hitch this is earlier than the world time.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
+	double CurrentTriggerTime = 0.0;
 
 	UPROPERTY(visibleInstanceOnly, BlueprintReadOnly, Category = "NoctAbilitySystem")
 	TObjectPtr<UNoctAbilityComponent> OwningAbilityComponent;
@@ -0,0 +1,69 @@
+﻿// Copyright Nocturnum Games 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "NoctCooldownTable.h"
+#include "NoctPrediction.generated.h"
+
+/**
+ * Identifies one client predicted activation, so the server's answer can be matched to what the client did
+ */
+USTRUCT(BlueprintType)
+struct NOCTABILITYSYSTEM_API FNoctPredictionKey
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Value = 0;
+
+	bool IsValid() const
+	{
+		return Value != 0;
+	}
+
+	bool operator==(const FNoctPredictionKey& Other) const
+	{
+		return Value == Other.Value;
+	}
+
+	// Next key after Previous, never the invalid key
+	static FNoctPredictionKey MakeNext(FNoctPredictionKey Previous);
+};
+
+// A cooldown as it was before a prediction changed it, charges included
+struct FNoctPredictedCooldown
+{
+	FNoctCooldownEntry Entry;
+};
+
+// A change a prediction made to an attribute's base value
+struct FNoctPredictedAttributeDelta
+{
+	FGameplayTag AttributeTag;
+	float Delta = 0.0f;
+};
+
+/**
+ * Everything a client changed while predicting an activation, kept until the server confirms or rejects it
+ */
+struct NOCTABILITYSYSTEM_API FNoctPredictionRecord
+{
+	FNoctPredictionKey Key;
+	FGameplayTag AbilityTag;
+	double PredictionTime = 0.0;
+
+	TArray<FGameplayTag, TInlineAllocator<2>> AddedActiveTags;
+	TArray<FNoctPredictedCooldown, TInlineAllocator<2>> Cooldowns;
+	TArray<FNoctPredictedAttributeDelta, TInlineAllocator<2>> AttributeDeltas;
+
+	// The ability finished or was cancelled while its activation was being predicted, such as an instant ability.
+	// The server is told after the activation so it gets both in order.
+	bool bEndedDuringActivation = false;
+	bool bCancelledDuringActivation = false;
+
+	// Remember how Tag's cooldown was before the prediction first touched it
+	void RecordCooldown(FGameplayTag Tag, const FNoctCooldownTable& CooldownTable);
+	void RecordAttributeDelta(FGameplayTag AttributeTag, float Delta);
+};
@@ -0,0 +1,61 @@
+﻿// Copyright Nocturnum Games 2023 
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Curves/CurveFloat.h"
+#include "NoctScalingTable.generated.h"
+
+/**
+ * Values of a level scaling curve baked per level, so hot getters read an array instead of evaluating the curve.
+ * Lookups fall back to the curve itself if it has been swapped since baking or the level is outside the table.
+ * The table is used in the editor as well, owners re-bake it on load and when they are edited.
+ */
+USTRUCT()
+struct NOCTABILITYSYSTEM_API FNoctScalingTable
+{
+	GENERATED_BODY()
+
+	// Curve value for each level, indexed by level
+	UPROPERTY()
+	TArray<float> Values;
+
+	// The curve the values were baked from
+	UPROPERTY()
+	TObjectPtr<UCurveFloat> SourceCurve = nullptr;
+
+	// Bake levels 0 to MaxLevel of the curve. A null curve empties the table.
+	void Bake(UCurveFloat* Curve, int32 MaxLevel);
+
+	// True if the table already holds the values for this curve and level range
+	bool IsBakedFrom(const UCurveFloat* Curve, int32 MaxLevel) const
+	{
+		return SourceCurve == Curve && (Curve == nullptr || Values.Num() == GetNumLevels(MaxLevel));
+	}
+
+	// Number of values baked for MaxLevel, levels 0 to MaxLevel with negative levels treated as 0
+	static int32 GetNumLevels(const int32 MaxLevel)
+	{
+		return FMath::Max(MaxLevel, 0) + 1;
+	}
+
+	float Evaluate(const UCurveFloat* Curve, const int32 Level) const
+	{
+#if WITH_EDITOR
+		if (bReadCurvesLive)
+		{
+			return Curve->GetFloatValue(Level);
+		}
+#endif
+		if (Curve == SourceCurve && Values.IsValidIndex(Level))
+		{
+			return Values[Level];
+		}
+		return Curve->GetFloatValue(Level);
+	}
+
+#if WITH_EDITOR
+	// Set by NoctAbilitySystem.ReadScalingCurvesLive, for tuning curve assets while playing in editor without re-baking
+	static bool bReadCurvesLive;
+#endif
+};
@@ -0,0 +1,72 @@
+﻿// Copyright Nocturnum Games 2023 
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "NoctSharedTagContainer.generated.h"
+
+/**
+ * A tag container interned in FNoctTagContainerRegistry, so every object with the same tags points at one shared copy
+ * and instances copy a 4 byte index from their class defaults instead of the container.
+ * The shared copy is never changed: the mutators intern a changed copy, leaving everything else that held the old tags alone.
+ * Serializes as a regular FGameplayTagContainer and loads properties that used to be one.
+ */
+USTRUCT(BlueprintType)
+struct NOCTABILITYSYSTEM_API FNoctSharedTagContainer
+{
+	GENERATED_BODY()
+
+	FNoctSharedTagContainer() = default;
+	explicit FNoctSharedTagContainer(const FGameplayTagContainer& Tags);
+
+	const FGameplayTagContainer& Get() const;
+
+	bool IsEmpty() const
+	{
+		return Index == 0;
+	}
+
+	void Set(const FGameplayTagContainer& Tags);
+	void AddTag(const FGameplayTag& Tag);
+	void RemoveTag(const FGameplayTag& Tag);
+	void AppendTags(const FGameplayTagContainer& Tags);
+	void Reset();
+
+	bool operator==(const FNoctSharedTagContainer& Other) const
+	{
+		return Index == Other.Index;
+	}
+
+	bool Serialize(FArchive& Ar);
+	bool SerializeFromMismatchedTag(const FPropertyTag& Tag, FStructuredArchive::FSlot Slot);
+	bool Identical(const FNoctSharedTagContainer* Other, uint32 PortFlags) const;
+	bool ExportTextItem(FString& ValueStr, const FNoctSharedTagContainer& DefaultValue, UObject* Parent, int32 PortFlags, UObject* ExportRootScope) const;
+	bool ImportTextItem(const TCHAR*& Buffer, int32 PortFlags, UObject* Parent, FOutputDevice* ErrorText);
+
+#if WITH_EDITORONLY_DATA
+	// What the details panel edits, owners call SyncFromEditorTags when it changes
+	UPROPERTY(EditAnywhere, Category = "NoctAbilitySystem")
+	FGameplayTagContainer EditorTags;
+#endif
+
+#if WITH_EDITOR
+	void SyncFromEditorTags();
+#endif
+
+private:
+	uint32 Index = 0;
+};
+
+template<>
+struct TStructOpsTypeTraits<FNoctSharedTagContainer> : public TStructOpsTypeTraitsBase2<FNoctSharedTagContainer>
+{
+	enum
+	{
+		WithSerializer = true,
+		WithStructuredSerializeFromMismatchedTag = true,
+		WithIdentical = true,
+		WithExportTextItem = true,
+		WithImportTextItem = true,
+	};
+};
@@ -0,0 +1,96 @@
+﻿// Copyright Nocturnum Games 2023 
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+
+/**
+ * A dense set of gameplay tags, one bit per tag registered in FNoctTagBitRegistry
+ */
+struct NOCTABILITYSYSTEM_API FNoctTagBits
+{
+	void SetBit(const int32 Index)
+	{
+		const int32 WordIndex = Index >> 6;
+		if (WordIndex >= Words.Num())
+		{
+			Words.SetNumZeroed(WordIndex + 1);
+		}
+		Words[WordIndex] |= 1ull << (Index & 63);
+	}
+
+	void ClearBit(const int32 Index)
+	{
+		const int32 WordIndex = Index >> 6;
+		if (WordIndex < Words.Num())
+		{
+			Words[WordIndex] &= ~(1ull << (Index & 63));
+		}
+	}
+
+	bool TestBit(const int32 Index) const
+	{
+		const int32 WordIndex = Index >> 6;
+		return WordIndex < Words.Num() && (Words[WordIndex] & (1ull << (Index & 63))) != 0;
+	}
+
+	bool Intersects(const FNoctTagBits& Other) const
+	{
+		const int32 NumWords = FMath::Min(Words.Num(), Other.Words.Num());
+		for (int32 WordIndex = 0; WordIndex < NumWords; ++WordIndex)
+		{
+			if (Words[WordIndex] & Other.Words[WordIndex])
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Reset()
+	{
+		Words.Reset();
+	}
+
+	TArray<uint64, TInlineAllocator<4>> Words;
+};
+
+/**
+ * Maps the tags opted in through UNoctAbilitySystemSettings::IndexedTags to bit indices.
+ * Built once on first use, tags outside the registry have no bit and are checked through containers instead.
+ */
+class NOCTABILITYSYSTEM_API FNoctTagBitRegistry
+{
+public:
+	static const FNoctTagBitRegistry& Get();
+
+	bool IsEnabled() const
+	{
+		return Tags.Num() > 0;
+	}
+
+	int32 GetBitIndex(const FGameplayTag& Tag) const
+	{
+		const int32* Index = BitByTag.Find(Tag);
+		return Index ? *Index : INDEX_NONE;
+	}
+
+	// The tag with bit Index, or an invalid tag if there is none
+	FGameplayTag GetTag(const int32 Index) const
+	{
+		return Tags.IsValidIndex(Index) ? Tags[Index] : FGameplayTag();
+	}
+
+	// Set the bit of every tag in Container. Returns false if any of them is not registered.
+	bool MakeExactBits(const FGameplayTagContainer& Container, FNoctTagBits& OutBits) const;
+
+	// Set the bit of every registered tag that matches any tag in Container, the way FGameplayTag::MatchesAny does
+	void MakeHierarchicalBits(const FGameplayTagContainer& Container, FNoctTagBits& OutBits) const;
+
+private:
+	FNoctTagBitRegistry();
+
+	TArray<FGameplayTag> Tags;
+	TMap<FGameplayTag, int32> BitByTag;
+};
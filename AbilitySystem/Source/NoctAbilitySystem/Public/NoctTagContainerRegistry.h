@@ -0,0 +1,69 @@
+﻿// Copyright Nocturnum Games 2023 
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+
+/**
+ * One shared copy of every distinct tag container interned so far, looked up by content hash.
+ * Containers are never removed or changed, so an index stays valid and means the same tags for the whole session.
+ * Index 0 is the empty container. Interning is safe from any thread, since class defaults can be loaded asynchronously.
+ */
+class NOCTABILITYSYSTEM_API FNoctTagContainerRegistry
+{
+public:
+	// Far more than fit in memory, every container is at least one allocation
+	static constexpr int32 MaxContainers = MAX_int32;
+
+	static FNoctTagContainerRegistry& Get();
+
+	// Index of the shared copy of Container, added if no equal container has been interned yet. Fatal once MaxContainers are in use.
+	uint32 Intern(const FGameplayTagContainer& Container);
+
+	// Index of the union of two interned containers
+	uint32 InternUnion(uint32 IndexA, uint32 IndexB);
+
+	// Stays valid for the rest of the session. Index has to come from Intern.
+	const FGameplayTagContainer& GetContainer(const uint32 Index) const
+	{
+		int32 Chunk;
+		uint32 Slot;
+		Locate(Index, Chunk, Slot);
+		return Chunks[Chunk][Slot];
+	}
+
+	int32 Num() const;
+
+	SIZE_T GetAllocatedSize() const;
+
+	// Heap memory a container holds on to, its explicit tags plus the parent tags it keeps for matching
+	static SIZE_T GetContainerAllocatedSize(const FGameplayTagContainer& Container);
+
+	// Same for equal containers whatever order their tags were added in
+	static uint32 HashContainer(const FGameplayTagContainer& Container);
+
+private:
+	FNoctTagContainerRegistry();
+
+	// Containers are stored in chunks that never move, so they can be read without locking while others are added.
+	// Each chunk is twice the size of the one before, so a handful of them covers every index.
+	static constexpr uint32 FirstChunkBits = 8;
+	static constexpr uint32 FirstChunkSize = 1u << FirstChunkBits;
+	static constexpr int32 NumChunks = 32 - FirstChunkBits;
+
+	// Chunk N holds FirstChunkSize << N containers, starting at index (FirstChunkSize << N) - FirstChunkSize
+	static void Locate(const uint32 Index, int32& OutChunk, uint32& OutSlot)
+	{
+		const uint32 Offset = Index + FirstChunkSize;
+		const uint32 ChunkBit = FMath::FloorLog2(Offset);
+		OutChunk = static_cast<int32>(ChunkBit - FirstChunkBits);
+		OutSlot = Offset - (1u << ChunkBit);
+	}
+
+	TUniquePtr<FGameplayTagContainer[]> Chunks[NumChunks];
+	int32 NumContainers = 0;
+
+	TMultiMap<uint32, uint32> IndicesByHash;
+	mutable FRWLock Lock;
+};
@@ -10,6 +10,8 @@ public class NoctAbilitySystemEditor : ModuleRules
             new string[]
             {
                 "Core",
+                "GameplayTags",
+                "NoctAbilitySystem"
             }
         );
 
@@ -19,7 +21,8 @@ public class NoctAbilitySystemEditor : ModuleRules
                 "CoreUObject",
                 "Engine",
                 "Slate",
-                "SlateCore"
+                "SlateCore",
+                "EnhancedInput"
             }
         );
     }
@@ -0,0 +1,247 @@
+﻿// Copyright Nocturnum Games 2023
+
+
+#include "NoctReplayCommandlet.h"
+#include "NoctAbilityComponent.h"
+#include "NoctAbilityRecorder.h"
+#include "NoctSimulationWorld.h"
+#include "Engine/World.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogNoctReplay, Log, All);
+
+namespace
+{
+	// Drives one run of a recording, mapping recorded components and modifier handles to the replayed ones
+	struct FNoctReplay
+	{
+		FNoctReplay(UWorld* InWorld, const FNoctAbilityRecording& InRecording)
+			: World(InWorld)
+			, Recording(InRecording)
+		{
+		}
+
+		void Apply(const FNoctRecordedEvent& Event)
+		{
+			if (Event.Type == ENoctRecordedEventType::ComponentAdded)
+			{
+				AddComponent(Event);
+				return;
+			}
+
+			UNoctAbilityComponent* Component = Components.FindRef(Event.ComponentId);
+			if (!IsValid(Component))
+			{
+				return;
+			}
+
+			switch (Event.Type)
+			{
+			case ENoctRecordedEventType::ComponentRemoved:
+				Component->GetOwner()->Destroy();
+				Components.Remove(Event.ComponentId);
+				break;
+			case ENoctRecordedEventType::AttributeAdded:
+			{
+				FNoctAttribute Attribute;
+				Attribute.Initialize(Event.FloatValue, Event.SecondFloatValue);
+				Component->AddAttribute(GetTag(Event.NameIndex), Attribute);
+				break;
+			}
+			case ENoctRecordedEventType::AbilityUnlocked:
+				Component->UnlockAbilityByClass(GetClass<UNoctAbility>(Event.NameIndex));
+				break;
+			case ENoctRecordedEventType::AbilityActivated:
+				Component->ActivateAbilityByTag(GetTag(Event.NameIndex));
+				break;
+			case ENoctRecordedEventType::AbilityCancelled:
+				Component->CancelAbilityByTag(GetTag(Event.NameIndex));
+				break;
+			case ENoctRecordedEventType::AbilityFinished:
+				Component->FinishAbilityByTag(GetTag(Event.NameIndex));
+				break;
+			case ENoctRecordedEventType::AbilityActivationRequested:
+				Component->RequestActivateAbilityByTag(GetTag(Event.NameIndex));
+				break;
+			case ENoctRecordedEventType::EffectApplied:
+				Component->AddEffectBySpec(UNoctEffect::MakeEffectSpec(GetClass<UNoctEffect>(Event.NameIndex), Event.IntValue));
+				break;
+			case ENoctRecordedEventType::EffectRemoved:
+				// Expiry happens on its own as the world ticks
+				if (Event.IntValue == 0)
+				{
+					RemoveEffect(Component, GetClass<UNoctEffect>(Event.NameIndex));
+				}
+				break;
+			case ENoctRecordedEventType::ModifierAdded:
+			{
+				FNoctAttributeModifier Modifier(Event.FloatValue, (Event.Flags & 1) != 0);
+				Modifier.StackTag = GetTag(Event.SecondNameIndex);
+				Modifier.StackingPolicy = static_cast<EModifierStackingPolicy>(Event.Flags >> 1);
+				Modifier.MaxStacks = static_cast<int32>(Event.SecondFloatValue);
+				ModifierHandles.Add(MakeTuple(Event.ComponentId, Event.IntValue), Component->AddAttributeModifier(GetTag(Event.NameIndex), Modifier));
+				break;
+			}
+			case ENoctRecordedEventType::ModifierRemoved:
+				if (const int32* Handle = ModifierHandles.Find(MakeTuple(Event.ComponentId, Event.IntValue)))
+				{
+					Component->RemoveAttributeModifier(GetTag(Event.NameIndex), *Handle);
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+	private:
+		void AddComponent(const FNoctRecordedEvent& Event)
+		{
+			UClass* ActorClass = GetClass<AActor>(Event.NameIndex);
+			UClass* ComponentClass = GetClass<UNoctAbilityComponent>(Event.SecondNameIndex);
+
+			FActorSpawnParameters SpawnParameters;
+			SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+			AActor* Actor = World->SpawnActor(ActorClass ? ActorClass : AActor::StaticClass(), nullptr, nullptr, SpawnParameters);
+			if (!Actor)
+			{
+				return;
+			}
+
+			UNoctAbilityComponent* Component = Actor->FindComponentByClass<UNoctAbilityComponent>();
+			if (!Component)
+			{
+				Component = NewObject<UNoctAbilityComponent>(Actor, ComponentClass ? ComponentClass : UNoctAbilityComponent::StaticClass());
+				Actor->AddInstanceComponent(Component);
+				Component->RegisterComponent();
+			}
+			Components.Add(Event.ComponentId, Component);
+		}
+
+		static void RemoveEffect(UNoctAbilityComponent* Component, const UClass* EffectClass)
+		{
+			for (UNoctEffect* Effect : Component->ActiveEffects)
+			{
+				if (Effect && Effect->GetClass() == EffectClass)
+				{
+					Component->RemoveEffect(Effect);
+					return;
+				}
+			}
+		}
+
+		FGameplayTag GetTag(const int32 NameIndex) const
+		{
+			const FString& Name = Recording.GetName(NameIndex);
+			return Name.IsEmpty() ? FGameplayTag() : FGameplayTag::RequestGameplayTag(FName(*Name), false);
+		}
+
+		template<typename T>
+		UClass* GetClass(const int32 NameIndex)
+		{
+			UClass*& Class = Classes.FindOrAdd(NameIndex);
+			if (!Class && !Recording.GetName(NameIndex).IsEmpty())
+			{
+				Class = LoadObject<UClass>(nullptr, *Recording.GetName(NameIndex));
+			}
+			return Class && Class->IsChildOf(T::StaticClass()) ? Class : nullptr;
+		}
+
+		UWorld* World;
+		const FNoctAbilityRecording& Recording;
+
+		TMap<uint32, UNoctAbilityComponent*> Components;
+		TMap<TPair<uint32, int32>, int32> ModifierHandles;
+		TMap<int32, UClass*> Classes;
+	};
+}
+
+UNoctReplayCommandlet::UNoctReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UNoctReplayCommandlet::Main(const FString& Params)
+{
+	FString RecordingPath;
+	if (!FParse::Value(*Params, TEXT("Recording="), RecordingPath))
+	{
+		UE_LOG(LogNoctReplay, Error, TEXT("No recording given, pass -Recording=File.noctrec"));
+		return 1;
+	}
+
+	FNoctAbilityRecording Recording;
+	if (!Recording.Load(RecordingPath))
+	{
+		UE_LOG(LogNoctReplay, Error, TEXT("Couldn't load recording %s"), *RecordingPath);
+		return 1;
+	}
+
+	int32 NumRuns = 1;
+	FParse::Value(*Params, TEXT("Runs="), NumRuns);
+	NumRuns = FMath::Max(NumRuns, 1);
+
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("NoctSimulation") / FPaths::GetBaseFilename(RecordingPath) + TEXT("_Replay.csv");
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	FString Csv = TEXT("Run,Frame,GameThreadMs,ReplayedEvents,UObjects\n");
+
+	for (int32 Run = 0; Run < NumRuns; ++Run)
+	{
+		UWorld* World = NoctSimulationWorld::Create(TEXT("NoctReplay"));
+
+		// Scoped so nothing points into the world once it's destroyed
+		{
+			FNoctReplay Replay(World, Recording);
+
+			double TotalGameThreadMs = 0.0;
+			int32 EventIndex = 0;
+
+			// Events of frame N happened after N frames had started ticking, frame 0 being before the first one
+			for (int32 Frame = 0; Frame <= Recording.FrameDeltas.Num(); ++Frame)
+			{
+				const double FrameStartTime = FPlatformTime::Seconds();
+				int32 NumReplayed = 0;
+
+				for (; EventIndex < Recording.Events.Num() && Recording.Events[EventIndex].Frame == static_cast<uint32>(Frame); ++EventIndex)
+				{
+					const FNoctRecordedEvent& Event = Recording.Events[EventIndex];
+					if (!Event.bNested)
+					{
+						Replay.Apply(Event);
+						++NumReplayed;
+					}
+				}
+
+				if (Recording.FrameDeltas.IsValidIndex(Frame))
+				{
+					World->Tick(LEVELTICK_All, Recording.FrameDeltas[Frame]);
+					++GFrameCounter;
+				}
+
+				const double GameThreadMs = (FPlatformTime::Seconds() - FrameStartTime) * 1000.0;
+				TotalGameThreadMs += GameThreadMs;
+
+				Csv += FString::Printf(TEXT("%d,%d,%.3f,%d,%d\n"), Run, Frame, GameThreadMs, NumReplayed, GUObjectArray.GetObjectArrayNumMinusAvailable());
+			}
+
+			UE_LOG(LogNoctReplay, Display, TEXT("Run %d: %d frames, %.3f ms average game thread time"),
+				Run, Recording.FrameDeltas.Num(), TotalGameThreadMs / FMath::Max(Recording.FrameDeltas.Num(), 1));
+		}
+
+		NoctSimulationWorld::Destroy(World);
+	}
+
+	if (!FFileHelper::SaveStringToFile(Csv, *OutputPath))
+	{
+		UE_LOG(LogNoctReplay, Error, TEXT("Couldn't write %s"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogNoctReplay, Display, TEXT("Replayed %s %d times. Written to %s"), *RecordingPath, NumRuns, *OutputPath);
+	return 0;
+}
@@ -0,0 +1,291 @@
+﻿// Copyright Nocturnum Games 2023
+
+
+#include "NoctSimulationCommandlet.h"
+#include "NoctSimulationScenario.h"
+#include "NoctSimulationWorld.h"
+#include "NoctAbilityComponent.h"
+#include "Engine/World.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "UObject/StrongObjectPtr.h"
+#include "UObject/UObjectHash.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogNoctSimulation, Log, All);
+
+UNoctSimulationCommandlet::UNoctSimulationCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UNoctSimulationCommandlet::Main(const FString& Params)
+{
+	FString ScenarioPath;
+	if (!FParse::Value(*Params, TEXT("Scenario="), ScenarioPath))
+	{
+		UE_LOG(LogNoctSimulation, Error, TEXT("No scenario given, pass -Scenario=/Game/Path/Scenario"));
+		return 1;
+	}
+
+	// Commandlets keep nothing alive through the garbage collections between frames, so hold on to the scenario.
+	// That also keeps its classes loaded, including the effect classes the specs below are made from.
+	const TStrongObjectPtr<UNoctSimulationScenario> Scenario(LoadObject<UNoctSimulationScenario>(nullptr, *ScenarioPath));
+	if (!Scenario)
+	{
+		UE_LOG(LogNoctSimulation, Error, TEXT("Couldn't load scenario %s"), *ScenarioPath);
+		return 1;
+	}
+
+	int32 NumActors = Scenario->NumActors;
+	int32 NumFrames = Scenario->NumFrames;
+	FParse::Value(*Params, TEXT("Actors="), NumActors);
+	FParse::Value(*Params, TEXT("Frames="), NumFrames);
+
+	ENoctSimulatedInstancing Instancing = Scenario->AbilityInstancing;
+	FString InstancingName;
+	if (FParse::Value(*Params, TEXT("Instancing="), InstancingName))
+	{
+		const int64 Value = StaticEnum<ENoctSimulatedInstancing>()->GetValueByNameString(InstancingName);
+		if (Value == INDEX_NONE)
+		{
+			UE_LOG(LogNoctSimulation, Error, TEXT("Unknown instancing %s, use Eager or Lazy"), *InstancingName);
+			return 1;
+		}
+		Instancing = static_cast<ENoctSimulatedInstancing>(Value);
+	}
+
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("NoctSimulation") / Scenario->GetName() + TEXT(".csv");
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	const bool bDedicatedServer = Scenario->bDedicatedServer || FParse::Param(*Params, TEXT("DedicatedServer"));
+	UWorld* World = NoctSimulationWorld::Create(TEXT("NoctSimulation"), bDedicatedServer);
+	if (bDedicatedServer && World->GetNetMode() != NM_DedicatedServer)
+	{
+		UE_LOG(LogNoctSimulation, Error, TEXT("Couldn't run as a dedicated server, the world failed to listen"));
+		NoctSimulationWorld::Destroy(World);
+		return 1;
+	}
+
+	// Spawning includes BeginPlay and the unlocks, which is what lazy instancing changes
+	const int32 SpawnStartObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+	const uint64 SpawnStartUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	const double SpawnStartTime = FPlatformTime::Seconds();
+	TArray<UNoctAbilityComponent*> Components;
+	SpawnActors(World, *Scenario, NumActors, Instancing, Components);
+	const double SpawnMs = (FPlatformTime::Seconds() - SpawnStartTime) * 1000.0;
+	UE_LOG(LogNoctSimulation, Display, TEXT("Spawned %d actors in %.1f ms"), Components.Num(), SpawnMs);
+
+	if (Components.IsEmpty())
+	{
+		NoctSimulationWorld::Destroy(World);
+		return 1;
+	}
+
+	const FString StartupCsv = FString::Printf(TEXT("Actors,Instancing,SpawnMs,SpawnMsPerActor,UObjectsAdded,ComponentBytes,UsedPhysicalMBAdded\n%d,%s,%.3f,%.4f,%d,%lld,%.1f\n"),
+		Components.Num(),
+		*StaticEnum<ENoctSimulatedInstancing>()->GetNameStringByValue(static_cast<int64>(Instancing)),
+		SpawnMs,
+		SpawnMs / Components.Num(),
+		GUObjectArray.GetObjectArrayNumMinusAvailable() - SpawnStartObjects,
+		MeasureComponentMemory(Components, Scenario->NumMemorySamples),
+		(static_cast<double>(FPlatformMemory::GetStats().UsedPhysical) - static_cast<double>(SpawnStartUsedPhysical)) / (1024.0 * 1024.0));
+
+	const FString StartupOutputPath = FPaths::GetBaseFilename(OutputPath, false) + TEXT("_Startup.csv");
+	if (!FFileHelper::SaveStringToFile(StartupCsv, *StartupOutputPath))
+	{
+		UE_LOG(LogNoctSimulation, Error, TEXT("Couldn't write %s"), *StartupOutputPath);
+	}
+
+	TArray<FNoctEffectSpec> EffectSpecs;
+	for (const FNoctSimulatedEffect& Effect : Scenario->Effects)
+	{
+		EffectSpecs.Add(UNoctEffect::MakeEffectSpec(Effect.EffectClass, Effect.Level));
+	}
+
+	// Fractional activations and applications carry over, so low rates still happen at the right average
+	TArray<double> ActivationDebt;
+	ActivationDebt.SetNumZeroed(Scenario->Activations.Num());
+	TArray<double> EffectDebt;
+	EffectDebt.SetNumZeroed(Scenario->Effects.Num());
+
+	int32 NextActivationActor = 0;
+	int32 NextEffectTarget = 0;
+	TArray<UNoctAbilityComponent*> Targets;
+
+	FString Csv = TEXT("Frame,GameThreadMs,Activations,EffectApplications,UObjects,ComponentBytes,UsedPhysicalMB,GarbageCollectionMs\n");
+	double TotalGameThreadMs = 0.0;
+
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		const double FrameStartTime = FPlatformTime::Seconds();
+		int32 NumActivations = 0;
+		int32 NumApplications = 0;
+
+		for (int32 Index = 0; Index < Scenario->Activations.Num(); ++Index)
+		{
+			const FNoctSimulatedActivation& Activation = Scenario->Activations[Index];
+			ActivationDebt[Index] += Activation.ActivationsPerSecond * Components.Num() * Scenario->FrameDeltaTime;
+			for (; ActivationDebt[Index] >= 1.0; ActivationDebt[Index] -= 1.0)
+			{
+				Components[NextActivationActor]->ActivateAbilityByTag(Activation.AbilityTag);
+				NextActivationActor = (NextActivationActor + 1) % Components.Num();
+				++NumActivations;
+			}
+		}
+
+		for (int32 Index = 0; Index < Scenario->Effects.Num(); ++Index)
+		{
+			const FNoctSimulatedEffect& Effect = Scenario->Effects[Index];
+			EffectDebt[Index] += Effect.ApplicationsPerSecond * Scenario->FrameDeltaTime;
+			for (; EffectDebt[Index] >= 1.0; EffectDebt[Index] -= 1.0)
+			{
+				Targets.Reset();
+				for (int32 Target = 0; Target < FMath::Min(Effect.TargetsPerApplication, Components.Num()); ++Target)
+				{
+					Targets.Add(Components[NextEffectTarget]);
+					NextEffectTarget = (NextEffectTarget + 1) % Components.Num();
+				}
+				UNoctAbilityComponent::ApplyEffectSpecToTargets(EffectSpecs[Index], Targets);
+				++NumApplications;
+			}
+		}
+
+		World->Tick(LEVELTICK_All, Scenario->FrameDeltaTime);
+		++GFrameCounter;
+
+		const double GameThreadMs = (FPlatformTime::Seconds() - FrameStartTime) * 1000.0;
+		TotalGameThreadMs += GameThreadMs;
+
+		double GarbageCollectionMs = 0.0;
+		if (Scenario->GarbageCollectionInterval > 0 && (Frame + 1) % Scenario->GarbageCollectionInterval == 0)
+		{
+			const double GarbageCollectionStartTime = FPlatformTime::Seconds();
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+			GarbageCollectionMs = (FPlatformTime::Seconds() - GarbageCollectionStartTime) * 1000.0;
+		}
+
+		Csv += FString::Printf(TEXT("%d,%.3f,%d,%d,%d,%lld,%.1f,%.3f\n"),
+			Frame,
+			GameThreadMs,
+			NumActivations,
+			NumApplications,
+			GUObjectArray.GetObjectArrayNumMinusAvailable(),
+			MeasureComponentMemory(Components, Scenario->NumMemorySamples),
+			FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0),
+			GarbageCollectionMs);
+	}
+
+	NoctSimulationWorld::Destroy(World);
+
+	if (!FFileHelper::SaveStringToFile(Csv, *OutputPath))
+	{
+		UE_LOG(LogNoctSimulation, Error, TEXT("Couldn't write %s"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogNoctSimulation, Display, TEXT("%d frames with %d actors%s, %.3f ms average game thread time. Written to %s"),
+		NumFrames, Components.Num(), bDedicatedServer ? TEXT(" on a dedicated server") : TEXT(""), TotalGameThreadMs / FMath::Max(NumFrames, 1), *OutputPath);
+	return 0;
+}
+
+void UNoctSimulationCommandlet::SpawnActors(UWorld* World, const UNoctSimulationScenario& Scenario, const int32 NumActors, const ENoctSimulatedInstancing Instancing, TArray<UNoctAbilityComponent*>& OutComponents) const
+{
+	const UClass* ActorClass = Scenario.ActorClass ? Scenario.ActorClass.Get() : AActor::StaticClass();
+	const TSubclassOf<UNoctAbilityComponent> ComponentClass = Scenario.ComponentClass ? Scenario.ComponentClass : TSubclassOf<UNoctAbilityComponent>(UNoctAbilityComponent::StaticClass());
+
+	const auto ApplyInstancing = [Instancing](UNoctAbilityComponent* Component)
+	{
+		if (Instancing != ENoctSimulatedInstancing::ComponentDefault)
+		{
+			Component->bLazyAbilityInstancing = Instancing == ENoctSimulatedInstancing::Lazy;
+		}
+	};
+
+	bool bWarnedLateComponent = false;
+	OutComponents.Reserve(NumActors);
+	for (int32 Index = 0; Index < NumActors; ++Index)
+	{
+		// Deferred, as the world has already begun play and BeginPlay unlocks the default abilities
+		AActor* Actor = World->SpawnActorDeferred<AActor>(const_cast<UClass*>(ActorClass), FTransform::Identity, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+		if (!Actor)
+		{
+			continue;
+		}
+
+		// Components the actor class creates natively exist by now
+		UNoctAbilityComponent* Component = Actor->FindComponentByClass<UNoctAbilityComponent>();
+		if (Component)
+		{
+			ApplyInstancing(Component);
+		}
+
+		Actor->FinishSpawning(FTransform::Identity);
+
+		if (!Component)
+		{
+			Component = Actor->FindComponentByClass<UNoctAbilityComponent>();
+			if (Component)
+			{
+				// Added by the Blueprint's construction script, which only runs in FinishSpawning, after which BeginPlay has already unlocked its default abilities
+				if (Instancing != ENoctSimulatedInstancing::ComponentDefault && !bWarnedLateComponent)
+				{
+					UE_LOG(LogNoctSimulation, Warning, TEXT("%s adds its ability component in Blueprint, -Instancing only applies to the scenario's abilities and not to its default abilities"), *ActorClass->GetName());
+					bWarnedLateComponent = true;
+				}
+				ApplyInstancing(Component);
+			}
+			else
+			{
+				Component = NewObject<UNoctAbilityComponent>(Actor, ComponentClass);
+				Actor->AddInstanceComponent(Component);
+
+				// Set before registering, so the default abilities unlocked in BeginPlay use it as well
+				ApplyInstancing(Component);
+				Component->RegisterComponent();
+			}
+		}
+
+		for (const TPair<FGameplayTag, FNoctAttribute>& Attribute : Scenario.Attributes)
+		{
+			Component->AddAttribute(Attribute.Key, Attribute.Value);
+		}
+		for (const TSubclassOf<UNoctAbility>& Ability : Scenario.Abilities)
+		{
+			Component->UnlockAbilityByClass(Ability);
+		}
+
+		OutComponents.Add(Component);
+	}
+}
+
+int64 UNoctSimulationCommandlet::MeasureComponentMemory(const TArray<UNoctAbilityComponent*>& Components, const int32 NumSamples)
+{
+	const int32 NumMeasured = FMath::Min(NumSamples, Components.Num());
+	if (NumMeasured == 0)
+	{
+		return 0;
+	}
+
+	int64 TotalBytes = 0;
+	TArray<UObject*> Inners;
+	for (int32 Index = 0; Index < NumMeasured; ++Index)
+	{
+		// Spread the samples over every actor, the first ones may not be typical
+		UNoctAbilityComponent* Component = Components[Index * Components.Num() / NumMeasured];
+
+		TotalBytes += FArchiveCountMem(Component).GetMax();
+
+		Inners.Reset();
+		GetObjectsWithOuter(Component, Inners, true);
+		for (UObject* Inner : Inners)
+		{
+			TotalBytes += FArchiveCountMem(Inner).GetMax();
+		}
+	}
+	return TotalBytes / NumMeasured;
+}
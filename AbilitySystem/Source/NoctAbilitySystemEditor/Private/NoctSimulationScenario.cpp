@@ -0,0 +1,4 @@
+﻿// Copyright Nocturnum Games 2023
+
+
+#include "NoctSimulationScenario.h"
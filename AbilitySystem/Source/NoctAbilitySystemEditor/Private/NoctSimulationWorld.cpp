@@ -0,0 +1,42 @@
+﻿// Copyright Nocturnum Games 2023
+
+
+#include "NoctSimulationWorld.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+
+namespace NoctSimulationWorld
+{
+	UWorld* Create(const TCHAR* Name, const bool bDedicatedServer)
+	{
+		UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, Name);
+
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+
+		FURL URL;
+		World->InitializeActorsForPlay(URL);
+
+		// Commandlets aren't clients, so a server net driver makes the net mode NM_DedicatedServer
+		if (bDedicatedServer)
+		{
+			World->Listen(URL);
+		}
+
+		// There is no game mode to start play, so begin it directly
+		World->GetWorldSettings()->NotifyBeginPlay();
+		return World;
+	}
+
+	void Destroy(UWorld* World)
+	{
+		if (World->GetNetDriver())
+		{
+			GEngine->ShutdownWorldNetDriver(World);
+		}
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+}
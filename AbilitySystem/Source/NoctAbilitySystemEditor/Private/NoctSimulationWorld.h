@@ -0,0 +1,16 @@
+﻿// Copyright Nocturnum Games 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+
+// The headless game world the simulation and replay commandlets run in
+namespace NoctSimulationWorld
+{
+	// A dedicated server world listens with a server net driver and has no connections.
+	// Check its net mode afterwards, listening fails if the port is taken.
+	UWorld* Create(const TCHAR* Name, bool bDedicatedServer = false);
+	void Destroy(UWorld* World);
+}
@@ -0,0 +1,24 @@
+﻿// Copyright Nocturnum Games 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "NoctReplayCommandlet.generated.h"
+
+/**
+ * Replays an ability system recording in a headless game world and writes per frame game thread time to CSV,
+ * so a recorded fight can be rerun as a benchmark.
+ * UnrealEditor-Cmd.exe Project.uproject -run=NoctReplay -Recording=File.noctrec [-Runs=N] [-Output=File.csv] -nullrhi
+ * Only events that came from outside the ability system are driven, the rest follow from them and the world ticking.
+ */
+UCLASS()
+class NOCTABILITYSYSTEMEDITOR_API UNoctReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UNoctReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
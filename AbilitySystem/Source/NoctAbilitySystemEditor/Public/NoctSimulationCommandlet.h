@@ -0,0 +1,34 @@
+﻿// Copyright Nocturnum Games 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "NoctSimulationCommandlet.generated.h"
+
+class UNoctSimulationScenario;
+enum class ENoctSimulatedInstancing : uint8;
+class UNoctAbilityComponent;
+
+/**
+ * Runs a UNoctSimulationScenario in a headless game world and writes per frame measurements to CSV.
+ * UnrealEditor-Cmd.exe Project.uproject -run=NoctSimulation -Scenario=/Game/Path/Scenario [-Actors=N] [-Frames=N] [-Instancing=Eager|Lazy] [-Output=File.csv] -nullrhi
+ * The output defaults to Saved/NoctSimulation/<Scenario>.csv. Spawn time and memory are written next to it as <Output>_Startup.csv,
+ * so -Actors=500 -Frames=0 run once with -Instancing=Eager and once with -Instancing=Lazy compares startup of both modes.
+ */
+UCLASS()
+class NOCTABILITYSYSTEMEDITOR_API UNoctSimulationCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UNoctSimulationCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	void SpawnActors(UWorld* World, const UNoctSimulationScenario& Scenario, int32 NumActors, ENoctSimulatedInstancing Instancing, TArray<UNoctAbilityComponent*>& OutComponents) const;
+
+	// Average size of a sample of components, their abilities and effects included
+	static int64 MeasureComponentMemory(const TArray<UNoctAbilityComponent*>& Components, int32 NumSamples);
+};
@@ -0,0 +1,116 @@
+﻿// Copyright Nocturnum Games 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "GameplayTagContainer.h"
+#include "NoctAttribute.h"
+#include "NoctSimulationScenario.generated.h"
+
+class UNoctAbility;
+class UNoctAbilityComponent;
+class UNoctEffect;
+
+// An ability every simulated actor activates at a fixed rate
+USTRUCT()
+struct FNoctSimulatedActivation
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "Simulation")
+	FGameplayTag AbilityTag;
+
+	// Per actor
+	UPROPERTY(EditAnywhere, Category = "Simulation", meta = (ClampMin = 0))
+	float ActivationsPerSecond = 1.0f;
+};
+
+// An effect applied to groups of simulated actors at a fixed rate, like an area of effect hitting a crowd
+USTRUCT()
+struct FNoctSimulatedEffect
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "Simulation")
+	TSubclassOf<UNoctEffect> EffectClass;
+
+	// 0 uses the effect's default level
+	UPROPERTY(EditAnywhere, Category = "Simulation", meta = (ClampMin = 0))
+	int32 Level = 0;
+
+	// Across the whole simulation
+	UPROPERTY(EditAnywhere, Category = "Simulation", meta = (ClampMin = 0))
+	float ApplicationsPerSecond = 10.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Simulation", meta = (ClampMin = 1))
+	int32 TargetsPerApplication = 16;
+};
+
+// How the simulated components create their abilities
+UENUM()
+enum class ENoctSimulatedInstancing : uint8
+{
+	// Whatever bLazyAbilityInstancing is on the component class
+	ComponentDefault,
+	// Every ability is created when it is unlocked
+	Eager,
+	// Abilities are created on their first activation or input
+	Lazy
+};
+
+/**
+ * A load test for UNoctSimulationCommandlet: how many actors to spawn, what they have and what happens to them every frame.
+ */
+UCLASS(BlueprintType)
+class NOCTABILITYSYSTEMEDITOR_API UNoctSimulationScenario : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, Category = "Actors", meta = (ClampMin = 1))
+	int32 NumActors = 1000;
+
+	// Spawned for each simulated actor, the ability component is added to it
+	UPROPERTY(EditAnywhere, Category = "Actors")
+	TSubclassOf<AActor> ActorClass;
+
+	UPROPERTY(EditAnywhere, Category = "Actors")
+	TSubclassOf<UNoctAbilityComponent> ComponentClass;
+
+	UPROPERTY(EditAnywhere, Category = "Actors")
+	TArray<TSubclassOf<UNoctAbility>> Abilities;
+
+	UPROPERTY(EditAnywhere, Category = "Actors")
+	TMap<FGameplayTag, FNoctAttribute> Attributes;
+
+	// Overrides bLazyAbilityInstancing on components the commandlet adds, to compare startup time and memory of both modes.
+	// Components that are already on ActorClass have begun play by then, only Abilities are affected on those.
+	UPROPERTY(EditAnywhere, Category = "Actors")
+	ENoctSimulatedInstancing AbilityInstancing = ENoctSimulatedInstancing::ComponentDefault;
+
+	UPROPERTY(EditAnywhere, Category = "Load")
+	TArray<FNoctSimulatedActivation> Activations;
+
+	UPROPERTY(EditAnywhere, Category = "Load")
+	TArray<FNoctSimulatedEffect> Effects;
+
+	UPROPERTY(EditAnywhere, Category = "Run", meta = (ClampMin = 1))
+	int32 NumFrames = 900;
+
+	UPROPERTY(EditAnywhere, Category = "Run", meta = (ClampMin = 0.001, Units = "s"))
+	float FrameDeltaTime = 1.0f / 30.0f;
+
+	// Force a full garbage collection this often and time it. 0 never collects.
+	UPROPERTY(EditAnywhere, Category = "Run", meta = (ClampMin = 0))
+	int32 GarbageCollectionInterval = 60;
+
+	// Run the world as a dedicated server with no connections, so the work skipped on dedicated servers is skipped here too,
+	// such as cosmetic effect events and cue handling. Same as passing -DedicatedServer.
+	UPROPERTY(EditAnywhere, Category = "Run")
+	bool bDedicatedServer = false;
+
+	// Components sampled for the memory per component column
+	UPROPERTY(EditAnywhere, Category = "Run", meta = (ClampMin = 1))
+	int32 NumMemorySamples = 32;
+};
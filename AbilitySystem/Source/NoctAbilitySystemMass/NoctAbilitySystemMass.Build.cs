@@ -0,0 +1,27 @@
+﻿using UnrealBuildTool;
+
+public class NoctAbilitySystemMass : ModuleRules
+{
+    public NoctAbilitySystemMass(ReadOnlyTargetRules Target) : base(Target)
+    {
+        PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        PublicDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "Core",
+                "GameplayTags",
+                "MassEntity",
+                "NoctAbilitySystem"
+            }
+        );
+
+        PrivateDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "CoreUObject",
+                "Engine"
+            }
+        );
+    }
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+﻿#include "NoctAbilitySystemMass.h"
+
+#define LOCTEXT_NAMESPACE "FNoctAbilitySystemMassModule"
+
+void FNoctAbilitySystemMassModule::StartupModule()
+{
+    
+}
+
+void FNoctAbilitySystemMassModule::ShutdownModule()
+{
+    
+}
+
+#undef LOCTEXT_NAMESPACE
+    
+IMPLEMENT_MODULE(FNoctAbilitySystemMassModule, NoctAbilitySystemMass)
\ No newline at end of file
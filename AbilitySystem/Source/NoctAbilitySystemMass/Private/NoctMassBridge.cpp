@@ -0,0 +1,111 @@
+﻿// Copyright Nocturnum Games 2023
+
+
+#include "NoctMassBridge.h"
+#include "MassEntityManager.h"
+#include "NoctAbilityComponent.h"
+#include "NoctMassFragments.h"
+
+void FNoctMassBridge::AddFragments(FMassEntityManager& EntityManager, const FMassEntityHandle Entity)
+{
+	FMassArchetypeCompositionDescriptor Composition;
+	Composition.Fragments.Add<FNoctMassAttributesFragment>();
+	Composition.Fragments.Add<FNoctMassEffectsFragment>();
+	Composition.Fragments.Add<FNoctMassCooldownsFragment>();
+
+	EntityManager.AddCompositionToEntity_GetDelta(Entity, Composition);
+}
+
+void FNoctMassBridge::CopyEntityToComponent(FMassEntityManager& EntityManager, const FMassEntityHandle Entity, UNoctAbilityComponent& Component)
+{
+	const FNoctMassAttributesFragment* Attributes = EntityManager.GetFragmentDataPtr<FNoctMassAttributesFragment>(Entity);
+	const FNoctMassEffectsFragment* Effects = EntityManager.GetFragmentDataPtr<FNoctMassEffectsFragment>(Entity);
+	const FNoctMassCooldownsFragment* Cooldowns = EntityManager.GetFragmentDataPtr<FNoctMassCooldownsFragment>(Entity);
+
+	if (Attributes && Effects && Cooldowns)
+	{
+		CopyFragmentsToComponent(*Attributes, *Effects, *Cooldowns, EntityManager.GetWorld()->GetTimeSeconds(), Component);
+	}
+}
+
+void FNoctMassBridge::CopyComponentToEntity(UNoctAbilityComponent& Component, FMassEntityManager& EntityManager, const FMassEntityHandle Entity)
+{
+	AddFragments(EntityManager, Entity);
+
+	FNoctMassAttributesFragment* Attributes = EntityManager.GetFragmentDataPtr<FNoctMassAttributesFragment>(Entity);
+	FNoctMassEffectsFragment* Effects = EntityManager.GetFragmentDataPtr<FNoctMassEffectsFragment>(Entity);
+	FNoctMassCooldownsFragment* Cooldowns = EntityManager.GetFragmentDataPtr<FNoctMassCooldownsFragment>(Entity);
+
+	if (Attributes && Effects && Cooldowns)
+	{
+		CopyComponentToFragments(Component, *Attributes, *Effects, *Cooldowns, EntityManager.GetWorld()->GetTimeSeconds());
+	}
+}
+
+void FNoctMassBridge::CopyFragmentsToComponent(const FNoctMassAttributesFragment& Attributes, const FNoctMassEffectsFragment& Effects,
+	const FNoctMassCooldownsFragment& Cooldowns, const double EntityTime, UNoctAbilityComponent& Component)
+{
+	for (const FNoctMassAttribute& MassAttribute : Attributes.Attributes)
+	{
+		FNoctAttribute Attribute;
+		MassAttribute.CopyTo(Attribute);
+
+		if (FNoctAttribute* Existing = Component.FindAttribute(MassAttribute.Tag))
+		{
+			*Existing = MoveTemp(Attribute);
+		}
+		else
+		{
+			Component.AddAttribute(MassAttribute.Tag, MoveTemp(Attribute));
+		}
+	}
+
+	for (const FNoctMassEffect& Effect : Effects.Effects)
+	{
+		Component.ResumeEffect(Effect.Spec, Effect.Timeline);
+	}
+
+	// Component cooldowns may run on server time, so only the remaining time carries over
+	for (const FNoctMassCooldown& Cooldown : Cooldowns.Cooldowns)
+	{
+		if (Cooldown.EndTime > EntityTime)
+		{
+			Component.StartCooldown(Cooldown.Tag, static_cast<float>(Cooldown.EndTime - EntityTime));
+		}
+	}
+}
+
+void FNoctMassBridge::CopyComponentToFragments(UNoctAbilityComponent& Component, FNoctMassAttributesFragment& Attributes,
+	FNoctMassEffectsFragment& Effects, FNoctMassCooldownsFragment& Cooldowns, const double EntityTime)
+{
+	Attributes.Attributes.Reset();
+	for (const TPair<FGameplayTag, FNoctAttribute>& Pair : Component.Attributes)
+	{
+		Attributes.Attributes.AddDefaulted_GetRef().CopyFrom(Pair.Key, Pair.Value);
+	}
+
+	Effects.Effects.Reset();
+	Effects.ActiveEffectTags.Reset();
+	for (const UNoctEffect* Effect : Component.ActiveEffects)
+	{
+		if (Effect && Effect->IsTimed())
+		{
+			FNoctEffectSpec Spec = UNoctEffect::MakeEffectSpec(Effect->GetClass(), Effect->Level);
+			Spec.Magnitude = Effect->AppliedMagnitude;
+			Effects.ResumeEffect(Spec, Effect->Timeline, Attributes);
+		}
+	}
+
+	Cooldowns.Cooldowns.Reset();
+	Cooldowns.NextEndTime = UE_BIG_NUMBER;
+
+	const double ComponentTime = Component.GetCooldownTime();
+	for (const FGameplayTag& Tag : Component.Cooldowns.ActiveTags)
+	{
+		if (const FNoctCooldownEntry* Entry = Component.Cooldowns.Find(Tag); Entry && Entry->EndTime > ComponentTime)
+		{
+			const float Remaining = static_cast<float>(Entry->EndTime - ComponentTime);
+			Cooldowns.StartCooldown(Tag, EntityTime + Remaining - Entry->Duration, Entry->Duration);
+		}
+	}
+}
@@ -0,0 +1,177 @@
+﻿// Copyright Nocturnum Games 2023
+
+
+#include "NoctMassFragments.h"
+#include "NoctAttribute.h"
+
+void FNoctMassAttribute::CopyFrom(const FGameplayTag InTag, const FNoctAttribute& Attribute)
+{
+	Tag = InTag;
+	MaxValue = Attribute.MaxValue;
+	CurrentValue = Attribute.CurrentValue;
+	BaseValue = Attribute.BaseValue;
+
+	FlatModifierSum = Attribute.GetFlatModifierSum();
+	PercentModifierScale = Attribute.GetPercentModifierScale();
+}
+
+void FNoctMassAttribute::CopyTo(FNoctAttribute& Attribute) const
+{
+	// The individual modifiers are gone, they come back as one flat and one percentage modifier with the same total
+	Attribute.Initialize(BaseValue, MaxValue);
+
+	if (FlatModifierSum != 0.0f)
+	{
+		Attribute.AddModifier(FNoctAttributeModifier(FlatModifierSum, false));
+	}
+	if (PercentModifierScale != 1.0f)
+	{
+		Attribute.AddModifier(FNoctAttributeModifier(PercentModifierScale - 1.0f, true));
+	}
+
+	Attribute.CurrentValue = Attribute.CalculateValue();
+}
+
+float FNoctMassAttribute::CalculateValue() const
+{
+	const float FinalValue = (BaseValue + FlatModifierSum) * PercentModifierScale;
+	return MaxValue > 0 && FinalValue > MaxValue ? MaxValue : FinalValue;
+}
+
+
+bool FNoctMassEffectsFragment::ApplyEffect(const FNoctEffectSpec& Spec, FNoctMassAttributesFragment& Attributes, const double Now)
+{
+	const UNoctEffect* DefaultEffect = Spec.IsValid() ? Spec.EffectClass->GetDefaultObject<UNoctEffect>() : nullptr;
+	if (!DefaultEffect || ActiveEffectTags.HasTagExact(Spec.EffectTag))
+	{
+		return false;
+	}
+
+	// Like UNoctEffect::NativeEffectTriggered, the operation is only applied natively when the effect asks for it
+	const int32 AttributeIndex = DefaultEffect->bApplyAttributeOperationNatively ? Attributes.IndexOf(DefaultEffect->TargetAttributeTag) : INDEX_NONE;
+
+	// Same order as UNoctEffect::EffectApplied, permanent and one shot effects trigger on application
+	if (DefaultEffect->bPermanent || DefaultEffect->bOneShotEffect)
+	{
+		if (AttributeIndex != INDEX_NONE)
+		{
+			FNoctMassAttribute& Attribute = Attributes.Attributes[AttributeIndex];
+			Attribute.BaseValue = UNoctEffect::ApplyAttributeOperation(DefaultEffect->AttributeOperation, Attribute.BaseValue, Spec.Magnitude);
+			Attribute.CurrentValue = Attribute.CalculateValue();
+		}
+
+		// Permanent effects have nothing left to do once triggered
+		if (DefaultEffect->bPermanent)
+		{
+			return true;
+		}
+	}
+
+	FNoctMassEffect& Effect = Effects.AddDefaulted_GetRef();
+	Effect.Spec = Spec;
+	Effect.AttributeIndex = AttributeIndex;
+	Effect.AttributeOperation = DefaultEffect->AttributeOperation;
+	Effect.Timeline.Start(Now, DefaultEffect->Duration, DefaultEffect->TriggerInterval, !DefaultEffect->bOneShotEffect);
+
+	ActiveEffectTags.AddTag(Spec.EffectTag);
+	return true;
+}
+
+bool FNoctMassEffectsFragment::ResumeEffect(const FNoctEffectSpec& Spec, const FNoctEffectTimeline& Timeline, const FNoctMassAttributesFragment& Attributes)
+{
+	const UNoctEffect* DefaultEffect = Spec.IsValid() ? Spec.EffectClass->GetDefaultObject<UNoctEffect>() : nullptr;
+	if (!DefaultEffect || DefaultEffect->bPermanent || ActiveEffectTags.HasTagExact(Spec.EffectTag))
+	{
+		return false;
+	}
+
+	FNoctMassEffect& Effect = Effects.AddDefaulted_GetRef();
+	Effect.Spec = Spec;
+	Effect.Timeline = Timeline;
+	Effect.AttributeIndex = DefaultEffect->bApplyAttributeOperationNatively ? Attributes.IndexOf(DefaultEffect->TargetAttributeTag) : INDEX_NONE;
+	Effect.AttributeOperation = DefaultEffect->AttributeOperation;
+
+	ActiveEffectTags.AddTag(Spec.EffectTag);
+	return true;
+}
+
+bool FNoctMassEffectsFragment::Advance(FNoctMassAttributesFragment& Attributes, const double Now)
+{
+	bool bAttributesChanged = false;
+
+	for (int32 Index = Effects.Num() - 1; Index >= 0; --Index)
+	{
+		FNoctMassEffect& Effect = Effects[Index];
+
+		if (const int32 TriggersDue = Effect.Timeline.GetTriggersDue(Now); TriggersDue > 0)
+		{
+			Effect.Timeline.TriggersFired += TriggersDue;
+
+			if (Attributes.Attributes.IsValidIndex(Effect.AttributeIndex))
+			{
+				FNoctMassAttribute& Attribute = Attributes.Attributes[Effect.AttributeIndex];
+				for (int32 Trigger = 0; Trigger < TriggersDue; ++Trigger)
+				{
+					Attribute.BaseValue = UNoctEffect::ApplyAttributeOperation(Effect.AttributeOperation, Attribute.BaseValue, Effect.Spec.Magnitude);
+				}
+				Attribute.CurrentValue = Attribute.CalculateValue();
+				bAttributesChanged = true;
+			}
+		}
+
+		if (Effect.Timeline.IsExpired(Now))
+		{
+			ActiveEffectTags.RemoveTag(Effect.Spec.EffectTag);
+			Effects.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+		}
+	}
+
+	return bAttributesChanged;
+}
+
+void FNoctMassCooldownsFragment::StartCooldown(const FGameplayTag Tag, const double Now, const float Duration)
+{
+	FNoctMassCooldown* Cooldown = Cooldowns.FindByPredicate([Tag](const FNoctMassCooldown& Entry)
+	{
+		return Entry.Tag == Tag;
+	});
+
+	if (!Cooldown)
+	{
+		Cooldown = &Cooldowns.AddDefaulted_GetRef();
+		Cooldown->Tag = Tag;
+	}
+
+	Cooldown->EndTime = Now + Duration;
+	Cooldown->Duration = Duration;
+	NextEndTime = FMath::Min(NextEndTime, Cooldown->EndTime);
+}
+
+bool FNoctMassCooldownsFragment::IsOnCooldown(const FGameplayTag Tag, const double Now) const
+{
+	return Cooldowns.ContainsByPredicate([Tag, Now](const FNoctMassCooldown& Entry)
+	{
+		return Entry.Tag == Tag && Entry.EndTime > Now;
+	});
+}
+
+void FNoctMassCooldownsFragment::RemoveExpired(const double Now)
+{
+	if (Now < NextEndTime)
+	{
+		return;
+	}
+
+	NextEndTime = UE_BIG_NUMBER;
+	for (int32 Index = Cooldowns.Num() - 1; Index >= 0; --Index)
+	{
+		if (Cooldowns[Index].EndTime <= Now)
+		{
+			Cooldowns.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+		}
+		else
+		{
+			NextEndTime = FMath::Min(NextEndTime, Cooldowns[Index].EndTime);
+		}
+	}
+}
@@ -0,0 +1,69 @@
+﻿// Copyright Nocturnum Games 2023
+
+
+#include "NoctMassProcessors.h"
+#include "MassExecutionContext.h"
+
+UNoctMassEffectProcessor::UNoctMassEffectProcessor()
+	: EntityQuery(*this)
+{
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::Server | EProcessorExecutionFlags::Standalone);
+	ProcessingPhase = EMassProcessingPhase::PrePhysics;
+}
+
+void UNoctMassEffectProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FNoctMassEffectsFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FNoctMassAttributesFragment>(EMassFragmentAccess::ReadWrite);
+}
+
+void UNoctMassEffectProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_NoctMassEffectProcessor);
+
+	const double Now = Context.GetWorld()->GetTimeSeconds();
+
+	EntityQuery.ParallelForEachEntityChunk(EntityManager, Context, [Now](FMassExecutionContext& ChunkContext)
+	{
+		const TArrayView<FNoctMassEffectsFragment> EffectsList = ChunkContext.GetMutableFragmentView<FNoctMassEffectsFragment>();
+		const TArrayView<FNoctMassAttributesFragment> AttributesList = ChunkContext.GetMutableFragmentView<FNoctMassAttributesFragment>();
+
+		for (int32 EntityIndex = 0; EntityIndex < ChunkContext.GetNumEntities(); ++EntityIndex)
+		{
+			FNoctMassEffectsFragment& Effects = EffectsList[EntityIndex];
+			if (Effects.Effects.Num() > 0)
+			{
+				Effects.Advance(AttributesList[EntityIndex], Now);
+			}
+		}
+	});
+}
+
+UNoctMassCooldownProcessor::UNoctMassCooldownProcessor()
+	: EntityQuery(*this)
+{
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::Server | EProcessorExecutionFlags::Standalone);
+	ProcessingPhase = EMassProcessingPhase::PrePhysics;
+}
+
+void UNoctMassCooldownProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FNoctMassCooldownsFragment>(EMassFragmentAccess::ReadWrite);
+}
+
+void UNoctMassCooldownProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_NoctMassCooldownProcessor);
+
+	const double Now = Context.GetWorld()->GetTimeSeconds();
+
+	EntityQuery.ParallelForEachEntityChunk(EntityManager, Context, [Now](FMassExecutionContext& ChunkContext)
+	{
+		const TArrayView<FNoctMassCooldownsFragment> CooldownsList = ChunkContext.GetMutableFragmentView<FNoctMassCooldownsFragment>();
+
+		for (int32 EntityIndex = 0; EntityIndex < ChunkContext.GetNumEntities(); ++EntityIndex)
+		{
+			CooldownsList[EntityIndex].RemoveExpired(Now);
+		}
+	});
+}
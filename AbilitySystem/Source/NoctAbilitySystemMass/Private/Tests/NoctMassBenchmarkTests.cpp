@@ -0,0 +1,142 @@
+﻿// Copyright Nocturnum Games 2023
+
+
+#include "MassEntityManager.h"
+#include "MassEntitySubsystem.h"
+#include "MassExecutor.h"
+#include "MassProcessingTypes.h"
+#include "NoctMassFragments.h"
+#include "NoctMassProcessors.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace NoctMassBenchmarkTests
+{
+	constexpr auto TestFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext
+		| EAutomationTestFlags::ServerContext | EAutomationTestFlags::CommandletContext | EAutomationTestFlags::PerfFilter;
+
+	constexpr int32 NumEntities = 50000;
+	constexpr int32 NumFrames = 540;
+	constexpr float FrameTime = 1.0f / 60.0f;
+
+	struct FFrameTimes
+	{
+		double Total = 0.0;
+		double Max = 0.0;
+
+		void Add(const double Seconds)
+		{
+			Total += Seconds;
+			Max = FMath::Max(Max, Seconds);
+		}
+
+		FString ToString() const
+		{
+			return FString::Printf(TEXT("%.3f ms average, %.3f ms max"), Total * 1000.0 / NumFrames, Max * 1000.0);
+		}
+	};
+}
+
+/**
+ * Runs the effect and cooldown processors over 50,000 entities for nine seconds of 60 Hz frames, without any actor or
+ * component. Every entity gets one periodic effect and one cooldown, started at staggered times so triggers and
+ * expiries are spread over the frames the way they would be in a crowd. Timings are reported as test info.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNoctMassBenchmark50kTest, "NoctAbilitySystem.Mass.Benchmark50k", NoctMassBenchmarkTests::TestFlags)
+
+bool FNoctMassBenchmark50kTest::RunTest(const FString& Parameters)
+{
+	using namespace NoctMassBenchmarkTests;
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("NoctMassBenchmark"));
+	UMassEntitySubsystem* EntitySubsystem = World->GetSubsystem<UMassEntitySubsystem>();
+	if (!TestNotNull(TEXT("Mass entity subsystem"), EntitySubsystem))
+	{
+		World->DestroyWorld(false);
+		return false;
+	}
+
+	FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+
+	// A default effect is periodic, lasts ten seconds and triggers every second, which is what a crowd damage over time looks like.
+	// Mass entities only change attributes for effects that apply their operation natively.
+	TGuardValue<bool> NativeOperationScope(GetMutableDefault<UNoctEffect>()->bApplyAttributeOperationNatively, true);
+	const FNoctEffectSpec Spec = UNoctEffect::MakeEffectSpec(UNoctEffect::StaticClass(), 1);
+	const FGameplayTag TargetAttributeTag = GetDefault<UNoctEffect>()->TargetAttributeTag;
+
+	const double SetupStart = FPlatformTime::Seconds();
+
+	const FMassArchetypeHandle Archetype = EntityManager.CreateArchetype({
+		FNoctMassAttributesFragment::StaticStruct(),
+		FNoctMassEffectsFragment::StaticStruct(),
+		FNoctMassCooldownsFragment::StaticStruct()
+	});
+
+	TArray<FMassEntityHandle> Entities;
+	EntityManager.BatchCreateEntities(Archetype, NumEntities, Entities);
+
+	FRandomStream Random(NumEntities);
+	for (const FMassEntityHandle Entity : Entities)
+	{
+		FNoctMassAttributesFragment& Attributes = EntityManager.GetFragmentDataChecked<FNoctMassAttributesFragment>(Entity);
+		FNoctMassAttribute& Attribute = Attributes.Attributes.AddDefaulted_GetRef();
+		Attribute.Tag = TargetAttributeTag;
+		Attribute.MaxValue = Attribute.BaseValue = Attribute.CurrentValue = 100.0f;
+
+		const double StartTime = Random.FRand();
+		EntityManager.GetFragmentDataChecked<FNoctMassEffectsFragment>(Entity).ApplyEffect(Spec, Attributes, StartTime);
+
+		FNoctMassCooldownsFragment& Cooldowns = EntityManager.GetFragmentDataChecked<FNoctMassCooldownsFragment>(Entity);
+		Cooldowns.StartCooldown(FGameplayTag(), StartTime, Random.FRandRange(0.5f, 7.5f));
+	}
+
+	const double SetupSeconds = FPlatformTime::Seconds() - SetupStart;
+
+	UNoctMassEffectProcessor* EffectProcessor = NewObject<UNoctMassEffectProcessor>(World);
+	UNoctMassCooldownProcessor* CooldownProcessor = NewObject<UNoctMassCooldownProcessor>(World);
+	EffectProcessor->CallInitialize(World);
+	CooldownProcessor->CallInitialize(World);
+
+	FFrameTimes EffectTimes;
+	FFrameTimes CooldownTimes;
+
+	for (int32 Frame = 1; Frame <= NumFrames; ++Frame)
+	{
+		// The processors read the world time, nothing else in the world needs to tick
+		World->TimeSeconds = Frame * FrameTime;
+
+		FMassProcessingContext ProcessingContext(EntityManager, FrameTime);
+
+		double Start = FPlatformTime::Seconds();
+		UE::Mass::Executor::Run(*EffectProcessor, ProcessingContext);
+		EffectTimes.Add(FPlatformTime::Seconds() - Start);
+
+		Start = FPlatformTime::Seconds();
+		UE::Mass::Executor::Run(*CooldownProcessor, ProcessingContext);
+		CooldownTimes.Add(FPlatformTime::Seconds() - Start);
+	}
+
+	// Every effect started within the first second and lasts ten, so none has expired yet, while every cooldown has
+	int32 NumActiveEffects = 0;
+	int32 NumActiveCooldowns = 0;
+	for (const FMassEntityHandle Entity : Entities)
+	{
+		NumActiveEffects += EntityManager.GetFragmentDataChecked<FNoctMassEffectsFragment>(Entity).Effects.Num();
+		NumActiveCooldowns += EntityManager.GetFragmentDataChecked<FNoctMassCooldownsFragment>(Entity).Cooldowns.Num();
+	}
+	TestEqual(TEXT("Active effects"), NumActiveEffects, NumEntities);
+	TestEqual(TEXT("Active cooldowns"), NumActiveCooldowns, 0);
+
+	AddInfo(FString::Printf(TEXT("%d entities, %d frames of %.4f s"), NumEntities, NumFrames, FrameTime));
+	AddInfo(FString::Printf(TEXT("Setup: %.3f ms"), SetupSeconds * 1000.0));
+	AddInfo(FString::Printf(TEXT("Effect processor: %s"), *EffectTimes.ToString()));
+	AddInfo(FString::Printf(TEXT("Cooldown processor: %s"), *CooldownTimes.ToString()));
+
+	EntityManager.BatchDestroyEntities(Entities);
+	World->DestroyWorld(false);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
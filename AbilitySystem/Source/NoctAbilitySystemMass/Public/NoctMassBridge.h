@@ -0,0 +1,36 @@
+﻿// Copyright Nocturnum Games 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+
+struct FMassEntityManager;
+struct FNoctMassAttributesFragment;
+struct FNoctMassEffectsFragment;
+struct FNoctMassCooldownsFragment;
+class UNoctAbilityComponent;
+
+/**
+ * Moves ability state between a Mass entity and a UNoctAbilityComponent, for entities that get promoted to a
+ * full actor when they become relevant and demoted again afterwards.
+ * Attributes keep their values but their modifiers are collapsed into one flat and one percentage modifier.
+ * Timed effects continue from where they were. Permanent effects have already changed the base value, so they aren't carried over.
+ */
+struct NOCTABILITYSYSTEMMASS_API FNoctMassBridge
+{
+	// Add the fragments the ability processors need to an entity. Does nothing for fragments it already has.
+	static void AddFragments(FMassEntityManager& EntityManager, FMassEntityHandle Entity);
+
+	// Copy the entity's attributes, effects and cooldowns onto Component. Effects whose tag is already on the component are skipped.
+	static void CopyEntityToComponent(FMassEntityManager& EntityManager, FMassEntityHandle Entity, UNoctAbilityComponent& Component);
+
+	// Copy Component's attributes, timed effects and cooldowns into the entity's fragments, replacing what they held
+	static void CopyComponentToEntity(UNoctAbilityComponent& Component, FMassEntityManager& EntityManager, FMassEntityHandle Entity);
+
+	static void CopyFragmentsToComponent(const FNoctMassAttributesFragment& Attributes, const FNoctMassEffectsFragment& Effects,
+		const FNoctMassCooldownsFragment& Cooldowns, double EntityTime, UNoctAbilityComponent& Component);
+
+	static void CopyComponentToFragments(UNoctAbilityComponent& Component, FNoctMassAttributesFragment& Attributes,
+		FNoctMassEffectsFragment& Effects, FNoctMassCooldownsFragment& Cooldowns, double EntityTime);
+};
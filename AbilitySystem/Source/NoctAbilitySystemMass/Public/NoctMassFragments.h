@@ -0,0 +1,180 @@
+﻿// Copyright Nocturnum Games 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "MassEntityTypes.h"
+#include "NoctEffect.h"
+#include "NoctMassFragments.generated.h"
+
+struct FNoctAttribute;
+
+/**
+ * FNoctAttribute without the individual modifiers, only what they add up to.
+ * Flat modifiers are summed and percentage modifiers multiplied together, which gives the same value as
+ * FNoctAttribute::CalculateValue for the same set of modifiers.
+ */
+USTRUCT()
+struct NOCTABILITYSYSTEMMASS_API FNoctMassAttribute
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "NoctAbilitySystem")
+	FGameplayTag Tag;
+
+	UPROPERTY(EditAnywhere, Category = "NoctAbilitySystem")
+	float MaxValue = 1.0f;
+
+	UPROPERTY(EditAnywhere, Category = "NoctAbilitySystem")
+	float CurrentValue = 1.0f;
+
+	UPROPERTY(EditAnywhere, Category = "NoctAbilitySystem")
+	float BaseValue = 1.0f;
+
+	// Sum of every flat modifier
+	UPROPERTY(EditAnywhere, Category = "NoctAbilitySystem")
+	float FlatModifierSum = 0.0f;
+
+	// Product of (1 + Value) for every percentage modifier
+	UPROPERTY(EditAnywhere, Category = "NoctAbilitySystem")
+	float PercentModifierScale = 1.0f;
+
+	void CopyFrom(FGameplayTag InTag, const FNoctAttribute& Attribute);
+	void CopyTo(FNoctAttribute& Attribute) const;
+
+	float CalculateValue() const;
+};
+
+// Attributes of an entity, looked up by tag. Entities rarely have more than a handful.
+USTRUCT()
+struct NOCTABILITYSYSTEMMASS_API FNoctMassAttributesFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	TArray<FNoctMassAttribute, TInlineAllocator<4>> Attributes;
+
+	int32 IndexOf(const FGameplayTag Tag) const
+	{
+		return Attributes.IndexOfByPredicate([Tag](const FNoctMassAttribute& Attribute)
+		{
+			return Attribute.Tag == Tag;
+		});
+	}
+
+	FNoctMassAttribute* Find(const FGameplayTag Tag)
+	{
+		const int32 Index = IndexOf(Tag);
+		return Index != INDEX_NONE ? &Attributes[Index] : nullptr;
+	}
+};
+
+template<>
+struct TMassFragmentTraits<FNoctMassAttributesFragment> final
+{
+	enum
+	{
+		AuthorAcceptsItsNotTriviallyCopyable = true
+	};
+};
+
+/**
+ * A timed effect running natively on an entity. There is no UNoctEffect instance, so instead of Blueprint events
+ * each trigger applies AttributeOperation with the spec's magnitude to the target attribute's base value.
+ */
+USTRUCT()
+struct NOCTABILITYSYSTEMMASS_API FNoctMassEffect
+{
+	GENERATED_BODY()
+
+	// The spec the effect was applied with, used to turn it back into a UNoctEffect on promotion
+	UPROPERTY()
+	FNoctEffectSpec Spec;
+
+	UPROPERTY()
+	FNoctEffectTimeline Timeline;
+
+	// Index into FNoctMassAttributesFragment::Attributes, INDEX_NONE if the entity doesn't have the attribute
+	// or the effect doesn't apply its operation natively, see UNoctEffect::bApplyAttributeOperationNatively
+	UPROPERTY()
+	int32 AttributeIndex = INDEX_NONE;
+
+	UPROPERTY()
+	ENoctAttributeOperation AttributeOperation = ENoctAttributeOperation::Add;
+};
+
+USTRUCT()
+struct NOCTABILITYSYSTEMMASS_API FNoctMassEffectsFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	TArray<FNoctMassEffect, TInlineAllocator<2>> Effects;
+
+	// Effect tags currently applied, an entity can't have the same effect twice
+	FGameplayTagContainer ActiveEffectTags;
+
+	/**
+	 * Apply Spec to the entity. One shot and permanent effects that apply their operation natively change the base value straight away,
+	 * periodic effects are added and triggered by UNoctMassEffectProcessor.
+	 */
+	bool ApplyEffect(const FNoctEffectSpec& Spec, FNoctMassAttributesFragment& Attributes, double Now);
+
+	// Continue a timed effect from its timeline, used when demoting an actor
+	bool ResumeEffect(const FNoctEffectSpec& Spec, const FNoctEffectTimeline& Timeline, const FNoctMassAttributesFragment& Attributes);
+
+	// Fire due triggers and remove expired effects. Returns true if any attribute changed.
+	bool Advance(FNoctMassAttributesFragment& Attributes, double Now);
+};
+
+template<>
+struct TMassFragmentTraits<FNoctMassEffectsFragment> final
+{
+	enum
+	{
+		AuthorAcceptsItsNotTriviallyCopyable = true
+	};
+};
+
+USTRUCT()
+struct NOCTABILITYSYSTEMMASS_API FNoctMassCooldown
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FGameplayTag Tag;
+
+	// World time the cooldown ends at
+	UPROPERTY()
+	double EndTime = 0.0;
+
+	UPROPERTY()
+	float Duration = 0.0f;
+};
+
+// Cooldown end times of an entity. Ended cooldowns are dropped by UNoctMassCooldownProcessor.
+USTRUCT()
+struct NOCTABILITYSYSTEMMASS_API FNoctMassCooldownsFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	TArray<FNoctMassCooldown, TInlineAllocator<4>> Cooldowns;
+
+	// Earliest end time in Cooldowns, lets the processor skip entities with nothing ending yet
+	double NextEndTime = UE_BIG_NUMBER;
+
+	void StartCooldown(FGameplayTag Tag, double Now, float Duration);
+
+	bool IsOnCooldown(FGameplayTag Tag, double Now) const;
+
+	// Drop every cooldown that has ended by Now
+	void RemoveExpired(double Now);
+};
+
+template<>
+struct TMassFragmentTraits<FNoctMassCooldownsFragment> final
+{
+	enum
+	{
+		AuthorAcceptsItsNotTriviallyCopyable = true
+	};
+};
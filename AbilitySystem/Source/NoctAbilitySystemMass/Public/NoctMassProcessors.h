@@ -0,0 +1,46 @@
+﻿// Copyright Nocturnum Games 2023
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassProcessor.h"
+#include "MassEntityQuery.h"
+#include "NoctMassFragments.h"
+#include "NoctMassProcessors.generated.h"
+
+/**
+ * Fires due triggers of every entity's timed effects and recalculates the attributes they change.
+ * Chunks are processed in parallel, entities only ever touch their own fragments.
+ */
+UCLASS()
+class NOCTABILITYSYSTEMMASS_API UNoctMassEffectProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UNoctMassEffectProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
+
+// Drops ended cooldowns from every entity, in parallel chunks
+UCLASS()
+class NOCTABILITYSYSTEMMASS_API UNoctMassCooldownProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UNoctMassCooldownProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};